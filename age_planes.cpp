@@ -0,0 +1,150 @@
+///
+/// Cell ages for the packed engines, without a hash map.
+/// (C) Andrew Brownbill 2019
+///
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "age_planes.h"
+#include "hex_life.h"
+
+constexpr unsigned AgePlanes::AGE_BITS;
+constexpr unsigned AgePlanes::MAX_AGE;
+constexpr unsigned AgePlanes::RATE_BITS;
+
+AgePlanes::AgePlanes( unsigned width, unsigned height ) :
+  xSize( width ), ySize( height ), words( width / CELLS_PER_WORD ),
+  planes( AGE_BITS, std::vector< uint64_t >( size_t( width / CELLS_PER_WORD ) * height )),
+  neighbors( width / CELLS_PER_WORD )
+{
+  if ( width == 0 || width % CELLS_PER_WORD != 0 || height == 0 ) {
+    throw std::invalid_argument( "AgePlanes width must be a non zero multiple of 64" );
+  }
+}
+
+void AgePlanes::clear()
+{
+  for ( auto& plane : planes ) std::fill( plane.begin(), plane.end(), 0 );
+}
+
+void AgePlanes::advance( const PackedBoard& previous, uint64_t generations )
+{
+  if ( previous.width() != xSize || previous.height() != ySize ) {
+    throw std::invalid_argument( "AgePlanes::advance board size mismatch" );
+  }
+  for ( unsigned y = 0; y < ySize; ++y )
+  {
+    const uint64_t* up = previous.row( y ? y - 1 : ySize - 1 );
+    const uint64_t* down = previous.row(( y + 1 < ySize ) ? y + 1 : 0 );
+    advanceRow( y, up, previous.row( y ), down, generations );
+  }
+}
+
+void AgePlanes::advanceRow( unsigned y, const uint64_t* up, const uint64_t* mid, const uint64_t* down,
+                            uint64_t generations )
+{
+  neighborhoodRow( up, mid, down, neighbors.data(), words );
+  ageRow( y, generations );
+}
+
+void AgePlanes::advanceHex( const PackedBoard& previous )
+{
+  if ( previous.width() != xSize || previous.height() != ySize ) {
+    throw std::invalid_argument( "AgePlanes::advanceHex board size mismatch" );
+  }
+  for ( unsigned y = 0; y < ySize; ++y )
+  {
+    const uint64_t* up = previous.row( y ? y - 1 : ySize - 1 );
+    const uint64_t* down = previous.row(( y + 1 < ySize ) ? y + 1 : 0 );
+    hexNeighborhoodRow( y, up, previous.row( y ), down, neighbors.data(), words );
+    ageRow( y, 1 );
+  }
+}
+
+void AgePlanes::ageRow( unsigned y, uint64_t generations )
+{
+  const uint64_t add = std::min< uint64_t >( generations, MAX_AGE );
+  const size_t first = size_t( y ) * words;
+  for ( unsigned w = 0; w < words; ++w )
+  {
+    // Ripple carry add of a constant, 64 counters at a time.
+    uint64_t sum[ AGE_BITS ];
+    uint64_t carry = 0;
+    for ( unsigned i = 0; i < AGE_BITS; ++i )
+    {
+      const uint64_t a = planes[ i ][ first + w ];
+      const uint64_t b = (( add >> i ) & 1 ) ? ~uint64_t( 0 ) : 0;
+      sum[ i ] = a ^ b ^ carry;
+      carry = ( a & b ) | ( carry & ( a ^ b ));
+    }
+
+    // Overflow saturates, no neighbors starts over.
+    const uint64_t keep = neighbors[ w ];
+    for ( unsigned i = 0; i < AGE_BITS; ++i ) {
+      planes[ i ][ first + w ] = ( sum[ i ] | carry ) & keep;
+    }
+  }
+}
+
+void AgePlanes::agedRow( unsigned y, uint64_t* out ) const
+{
+  const size_t first = size_t( y ) * words;
+  for ( unsigned w = 0; w < words; ++w )
+  {
+    uint64_t any = 0;
+    for ( unsigned i = 0; i < AGE_BITS; ++i ) any |= planes[ i ][ first + w ];
+    out[ w ] = any;
+  }
+}
+
+unsigned AgePlanes::age( unsigned x, unsigned y ) const
+{
+  const size_t word = size_t( y ) * words + x / CELLS_PER_WORD;
+  const unsigned bit = x % CELLS_PER_WORD;
+  unsigned value = 0;
+  for ( unsigned i = 0; i < AGE_BITS; ++i ) {
+    value |= unsigned(( planes[ i ][ word ] >> bit ) & 1 ) << i;
+  }
+  return value;
+}
+
+void AgePlanes::load( const LifeBuffer& ages )
+{
+  clear();
+  for ( const auto& cell : ages )
+  {
+    const unsigned x = cell.first.first;
+    const unsigned y = cell.first.second;
+    if ( x >= xSize || y >= ySize ) continue;
+    const unsigned value = std::min( cell.second.value, MAX_AGE );
+    const size_t word = size_t( y ) * words + x / CELLS_PER_WORD;
+    for ( unsigned i = 0; i < AGE_BITS; ++i ) {
+      planes[ i ][ word ] |= uint64_t(( value >> i ) & 1 ) << ( x % CELLS_PER_WORD );
+    }
+  }
+}
+
+void AgePlanes::store( LifeBuffer& ages ) const
+{
+  ages.clear();
+  for ( unsigned y = 0; y < ySize; ++y ) {
+    for ( unsigned w = 0; w < words; ++w )
+    {
+      uint64_t any = 0;
+      for ( const auto& plane : planes ) any |= plane[ size_t( y ) * words + w ];
+      for ( ; any; any &= any - 1 )
+      {
+        const unsigned x = w * CELLS_PER_WORD + __builtin_ctzll( any );
+        ages[ LifeCoord( x, y ) ].value = age( x, y );
+      }
+    }
+  }
+}
+
+size_t AgePlanes::memoryUsed() const
+{
+  size_t bytes = neighbors.capacity() * sizeof( uint64_t );
+  for ( const auto& plane : planes ) bytes += plane.capacity() * sizeof( uint64_t );
+  return bytes;
+}
@@ -0,0 +1,97 @@
+///
+/// Cell ages for the packed engines, without a hash map.
+/// (C) Andrew Brownbill 2019
+///
+
+#ifndef AGE_PLANES_H
+#define AGE_PLANES_H
+
+#include <cstdint>
+#include <vector>
+
+#include "life.h"
+#include "packed_board.h"
+
+// Generations per palette entry; lower values = faster color aging.
+constexpr unsigned AGE_RATE = 16;
+
+// Palette entries.  Ages past AGE_RATE * AGE_BUCKETS all get the last one.
+constexpr unsigned AGE_BUCKETS = 256;
+
+// Per cell ages kept as bit sliced saturating counters: AGE_BITS packed
+// planes shaped like the board, plane i holding bit i of every cell's
+// age.  Ages follow advanceAge: a cell ages while it's in advanceSim's
+// buffer, i.e. while it had a live neighbor the generation before, and
+// starts over when it drops out.  Counting stops at the last palette
+// entry, so bucket() always matches age / AGE_RATE clipped to the
+// palette.
+class AgePlanes
+{
+  public:
+
+  static constexpr unsigned AGE_BITS = 12;
+  static constexpr unsigned MAX_AGE = ( 1u << AGE_BITS ) - 1;
+  static_assert( MAX_AGE / AGE_RATE + 1 == AGE_BUCKETS, "AGE_BITS doesn't cover the palette" );
+
+  AgePlanes( unsigned width, unsigned height );
+
+  unsigned width() const { return xSize; }
+  unsigned height() const { return ySize; }
+
+  void clear();
+
+  // Age the cells with a live neighbor in previous by generations, the
+  // others go back to 0.  More than one generation at a time is for
+  // engines that skip ahead; it assumes the neighborhood held throughout.
+  void advance( const PackedBoard& previous, uint64_t generations = 1 );
+
+  // advance() for row y alone, from the previous generation's rows around
+  // it.  For engines that step in place and never hold all of previous.
+  void advanceRow( unsigned y, const uint64_t* up, const uint64_t* mid, const uint64_t* down,
+                   uint64_t generations = 1 );
+
+  // advance() for a hex board, where cells age while one of their six
+  // neighbors is alive, see advanceHex.
+  void advanceHex( const PackedBoard& previous );
+
+  // The cells of row y with an age, i.e. the ones that had a live
+  // neighbor last generation.
+  void agedRow( unsigned y, uint64_t* out ) const;
+
+  unsigned age( unsigned x, unsigned y ) const;
+
+  // age() / AGE_RATE, a palette index.
+  unsigned bucket( unsigned x, unsigned y ) const
+  {
+    const size_t word = size_t( y ) * words + x / CELLS_PER_WORD;
+    const unsigned bit = x % CELLS_PER_WORD;
+    unsigned value = 0;
+    for ( unsigned i = RATE_BITS; i < AGE_BITS; ++i ) {
+      value |= unsigned(( planes[ i ][ word ] >> bit ) & 1 ) << ( i - RATE_BITS );
+    }
+    return value;
+  }
+
+  // Convert from / to advanceAge's hash map, to carry ages across
+  // engines.
+  void load( const LifeBuffer& ages );
+  void store( LifeBuffer& ages ) const;
+
+  size_t memoryUsed() const;
+
+  private:
+
+  static constexpr unsigned RATE_BITS = 4;
+  static_assert( 1u << RATE_BITS == AGE_RATE, "AGE_RATE must be 2^RATE_BITS" );
+
+  // Age row y's cells set in neighbors, start the others over.
+  void ageRow( unsigned y, uint64_t generations );
+
+  unsigned xSize;
+  unsigned ySize;
+  unsigned words;
+  std::vector< std::vector< uint64_t > > planes;
+  std::vector< uint64_t > neighbors;     // One row of scratch
+};
+
+#endif
@@ -0,0 +1,53 @@
+///
+/// A reusable thread barrier.  C++11 doesn't have one.
+/// (C) Andrew Brownbill 2019
+///
+
+#ifndef BARRIER_H
+#define BARRIER_H
+
+#include <condition_variable>
+#include <mutex>
+
+class Barrier
+{
+  public:
+
+  explicit Barrier( unsigned threads ) : count( threads ), waiting( 0 ), phase( 0 ), broken( false ) {}
+  Barrier( const Barrier& ) = delete;
+  Barrier& operator=( const Barrier& ) = delete;
+
+  // Block until all threads have called wait.
+  void wait()
+  {
+    std::unique_lock<std::mutex> lock( mutex );
+    const unsigned arrivedPhase = phase;
+    if ( ++waiting == count )
+    {
+      waiting = 0;
+      ++phase;
+      released.notify_all();
+      return;
+    }
+    released.wait( lock, [&]{ return phase != arrivedPhase || broken; } );
+  }
+
+  // Let every wait, now and from here on, return without the others.
+  // For shutting down when not all the threads could be started.
+  void release()
+  {
+    std::lock_guard<std::mutex> lock( mutex );
+    broken = true;
+    released.notify_all();
+  }
+
+  private:
+  std::mutex mutex;
+  std::condition_variable released;
+  unsigned count;
+  unsigned waiting;
+  unsigned phase;
+  bool broken;
+};
+
+#endif
@@ -0,0 +1,33 @@
+///
+/// Bit sliced helpers shared by the packed kernels.
+/// (C) Andrew Brownbill 2019
+///
+
+#ifndef BIT_OPS_H
+#define BIT_OPS_H
+
+#include <cstdint>
+
+// Neighbor to the west (x-1) of every cell in cur, prev being the word
+// before it.
+inline uint64_t westOf( uint64_t prev, uint64_t cur )
+{
+  return ( cur << 1 ) | ( prev >> 63 );
+}
+
+// Neighbor to the east (x+1) of every cell in cur, next being the word
+// after it.
+inline uint64_t eastOf( uint64_t cur, uint64_t next )
+{
+  return ( cur >> 1 ) | ( next << 63 );
+}
+
+// Add three bit planes.
+inline void fullAdd( uint64_t a, uint64_t b, uint64_t c, uint64_t& sum, uint64_t& carry )
+{
+  const uint64_t u = a ^ b;
+  sum = u ^ c;
+  carry = ( a & b ) | ( u & c );
+}
+
+#endif
@@ -0,0 +1,253 @@
+///
+/// Game of life board in 8x8 blocks, one 64 bit word per block.
+/// (C) Andrew Brownbill 2019
+///
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include "block_board.h"
+
+// Cells of column 0 / column 7 of every row of a block.
+constexpr uint64_t WEST_COLUMN = 0x0101010101010101ull;
+constexpr uint64_t EAST_COLUMN = 0x8080808080808080ull;
+
+// Bits of v spread out to the even bits.
+static inline uint64_t spread( uint64_t v )
+{
+  v &= 0xffffffffull;
+  v = ( v | ( v << 16 )) & 0x0000ffff0000ffffull;
+  v = ( v | ( v << 8 )) & 0x00ff00ff00ff00ffull;
+  v = ( v | ( v << 4 )) & 0x0f0f0f0f0f0f0f0full;
+  v = ( v | ( v << 2 )) & 0x3333333333333333ull;
+  v = ( v | ( v << 1 )) & 0x5555555555555555ull;
+  return v;
+}
+
+// Even bits of v packed back together.
+static inline uint64_t compact( uint64_t v )
+{
+  v &= 0x5555555555555555ull;
+  v = ( v | ( v >> 1 )) & 0x3333333333333333ull;
+  v = ( v | ( v >> 2 )) & 0x0f0f0f0f0f0f0f0full;
+  v = ( v | ( v >> 4 )) & 0x00ff00ff00ff00ffull;
+  v = ( v | ( v >> 8 )) & 0x0000ffff0000ffffull;
+  v = ( v | ( v >> 16 )) & 0x00000000ffffffffull;
+  return v;
+}
+
+static size_t slotCount( unsigned xBlocks, unsigned yBlocks, BlockBoard::Layout layout )
+{
+  if ( layout == BlockBoard::Layout::RowMajor ) return size_t( xBlocks ) * yBlocks;
+  size_t side = 1;
+  while ( side < std::max( xBlocks, yBlocks )) side *= 2;
+  return side * side;
+}
+
+BlockBoard::BlockBoard( unsigned width, unsigned height, Layout layout, bool hugePages ) :
+  xSize( width ), ySize( height ), xBlocks( width / BLOCK_SIDE ), yBlocks( height / BLOCK_SIDE ),
+  order( layout )
+{
+  if ( width == 0 || height == 0 || width % BLOCK_SIDE != 0 || height % BLOCK_SIDE != 0 ) {
+    throw std::invalid_argument( "BlockBoard width and height must be non zero multiples of 8" );
+  }
+  blocks = PageBuffer( slotCount( xBlocks, yBlocks, layout ), hugePages );
+}
+
+size_t BlockBoard::mortonSlot( unsigned bx, unsigned by )
+{
+  return size_t( spread( bx ) | ( spread( by ) << 1 ));
+}
+
+void BlockBoard::mortonPosition( size_t slot, unsigned& bx, unsigned& by )
+{
+  bx = unsigned( compact( slot ));
+  by = unsigned( compact( slot >> 1 ));
+}
+
+size_t BlockBoard::columnPart( unsigned bx ) const
+{
+  return order == Layout::Morton ? size_t( spread( bx )) : bx;
+}
+
+size_t BlockBoard::rowPart( unsigned by ) const
+{
+  return order == Layout::Morton ? size_t( spread( by ) << 1 ) : size_t( by ) * xBlocks;
+}
+
+bool BlockBoard::position( size_t slot, unsigned& bx, unsigned& by ) const
+{
+  if ( order == Layout::Morton ) {
+    mortonPosition( slot, bx, by );
+  }
+  else {
+    bx = unsigned( slot % xBlocks );
+    by = unsigned( slot / xBlocks );
+  }
+  return bx < xBlocks && by < yBlocks;
+}
+
+void BlockBoard::clear()
+{
+  std::fill( blocks.data(), blocks.data() + blocks.size(), 0 );
+}
+
+size_t BlockBoard::population() const
+{
+  size_t count = 0;
+  for ( size_t i = 0; i < blocks.size(); ++i ) count += __builtin_popcountll( blocks[ i ] );
+  return count;
+}
+
+void BlockBoard::load( const PackedBoard& board )
+{
+  if ( board.width() != xSize || board.height() != ySize ) {
+    throw std::invalid_argument( "BlockBoard::load board size mismatch" );
+  }
+  for ( unsigned by = 0; by < yBlocks; ++by ) {
+    for ( unsigned bx = 0; bx < xBlocks; ++bx )
+    {
+      const unsigned word = bx * BLOCK_SIDE / CELLS_PER_WORD;
+      const unsigned shift = bx * BLOCK_SIDE % CELLS_PER_WORD;
+      uint64_t b = 0;
+      for ( unsigned r = 0; r < BLOCK_SIDE; ++r ) {
+        b |= (( board.row( by * BLOCK_SIDE + r )[ word ] >> shift ) & 0xff ) << ( r * BLOCK_SIDE );
+      }
+      block( bx, by ) = b;
+    }
+  }
+}
+
+void BlockBoard::store( PackedBoard& board ) const
+{
+  board.clear();
+  for ( unsigned by = 0; by < yBlocks; ++by ) {
+    for ( unsigned bx = 0; bx < xBlocks; ++bx )
+    {
+      const uint64_t b = block( bx, by );
+      if ( !b ) continue;
+      const unsigned word = bx * BLOCK_SIDE / CELLS_PER_WORD;
+      const unsigned shift = bx * BLOCK_SIDE % CELLS_PER_WORD;
+      for ( unsigned r = 0; r < BLOCK_SIDE; ++r ) {
+        board.row( by * BLOCK_SIDE + r )[ word ] |= (( b >> ( r * BLOCK_SIDE )) & 0xff ) << shift;
+      }
+    }
+  }
+}
+
+// Neighbor to the west (x-1) of every cell in block, w is the block to
+// the west.
+static inline uint64_t westOf( uint64_t w, uint64_t block )
+{
+  return (( block << 1 ) & ~WEST_COLUMN ) | (( w >> 7 ) & WEST_COLUMN );
+}
+
+// Neighbor to the east (x+1) of every cell in block.
+static inline uint64_t eastOf( uint64_t block, uint64_t e )
+{
+  return (( block >> 1 ) & ~EAST_COLUMN ) | (( e << 7 ) & EAST_COLUMN );
+}
+
+// Neighbor to the north (y-1) of every cell in block, n is the block
+// to the north.
+static inline uint64_t northOf( uint64_t n, uint64_t block )
+{
+  return ( block << BLOCK_SIDE ) | ( n >> ( 64 - BLOCK_SIDE ));
+}
+
+// Neighbor to the south (y+1) of every cell in block.
+static inline uint64_t southOf( uint64_t block, uint64_t s )
+{
+  return ( block >> BLOCK_SIDE ) | ( s << ( 64 - BLOCK_SIDE ));
+}
+
+// Add three bit planes.
+static inline void fullAdd( uint64_t a, uint64_t b, uint64_t c, uint64_t& sum, uint64_t& carry )
+{
+  const uint64_t u = a ^ b;
+  sum = u ^ c;
+  carry = ( a & b ) | ( u & c );
+}
+
+// The next generation of the block at row + mid, given the slot parts of
+// its column and row and those of their neighbors.
+static inline uint64_t stepBlock( const uint64_t* in, size_t west, size_t mid, size_t east,
+                                  size_t north, size_t row, size_t south )
+{
+  const uint64_t nw = in[ north + west ], n = in[ north + mid ], ne = in[ north + east ];
+  const uint64_t w = in[ row + west ], c = in[ row + mid ], e = in[ row + east ];
+  const uint64_t sw = in[ south + west ], so = in[ south + mid ], se = in[ south + east ];
+  if ( !( nw | n | ne | w | c | e | sw | so | se )) return 0;
+
+  const uint64_t cw = westOf( w, c ), ce = eastOf( c, e );
+  const uint64_t nWest = westOf( nw, n ), nEast = eastOf( n, ne );
+  const uint64_t sWest = westOf( sw, so ), sEast = eastOf( so, se );
+
+  // Bit sliced sum of the eight neighbors.
+  uint64_t s0, c0, s1, c1, ones, c3, twos, c4;
+  fullAdd( northOf( nWest, cw ), northOf( n, c ), northOf( nEast, ce ), s0, c0 );
+  fullAdd( cw, ce, southOf( cw, sWest ), s1, c1 );
+  const uint64_t down = southOf( c, so );
+  const uint64_t downEast = southOf( ce, sEast );
+  const uint64_t s2 = down ^ downEast;
+  const uint64_t c2 = down & downEast;
+  fullAdd( s0, s1, s2, ones, c3 );
+  fullAdd( c0, c1, c2, twos, c4 );
+  const uint64_t fours = c4 | ( twos & c3 );
+  twos ^= c3;
+
+  // 3 neighbors = alive, 2 neighbors = same as before, else dead.
+  return twos & ~fours & ( ones | c );
+}
+
+void advanceBlocks( const BlockBoard& src, BlockBoard& dst )
+{
+  if ( dst.width() != src.width() || dst.height() != src.height() || dst.layout() != src.layout() ) {
+    throw std::invalid_argument( "advanceBlocks board size or layout mismatch" );
+  }
+  const unsigned xBlocks = src.blocksWide();
+  const unsigned yBlocks = src.blocksHigh();
+
+  // Work out every column's and row's part of a slot once.
+  std::vector< size_t > columns( xBlocks );
+  std::vector< size_t > rows( yBlocks );
+  for ( unsigned bx = 0; bx < xBlocks; ++bx ) columns[ bx ] = src.columnPart( bx );
+  for ( unsigned by = 0; by < yBlocks; ++by ) rows[ by ] = src.rowPart( by );
+
+  const uint64_t* in = src.data();
+  uint64_t* out = dst.data();
+  auto step = [&]( unsigned bx, unsigned by ) {
+    const size_t west = columns[ bx ? bx - 1 : xBlocks - 1 ];     // wrap around x
+    const size_t east = columns[ bx + 1 < xBlocks ? bx + 1 : 0 ];
+    const size_t north = rows[ by ? by - 1 : yBlocks - 1 ];      // wrap around y
+    const size_t south = rows[ by + 1 < yBlocks ? by + 1 : 0 ];
+    out[ rows[ by ] + columns[ bx ] ] = stepBlock( in, west, columns[ bx ], east, north, rows[ by ], south );
+  };
+
+  if ( src.layout() == BlockBoard::Layout::RowMajor )
+  {
+    for ( unsigned by = 0; by < yBlocks; ++by ) {
+      for ( unsigned bx = 0; bx < xBlocks; ++bx ) step( bx, by );
+    }
+    return;
+  }
+  // Along the curve, skipping the slots past the board's edges.  Every 64
+  // slots is an 8x8 square of blocks, so only decode the square's corner
+  // and take the blocks within it from a table.
+  constexpr size_t SQUARE = BLOCK_SIDE * BLOCK_SIDE;
+  unsigned dx[ SQUARE ], dy[ SQUARE ];
+  for ( unsigned i = 0; i < SQUARE; ++i ) BlockBoard::mortonPosition( i, dx[i], dy[i] );
+  for ( size_t square = 0; square < src.slots(); square += SQUARE )
+  {
+    unsigned x0, y0;
+    BlockBoard::mortonPosition( square, x0, y0 );
+    if ( x0 >= xBlocks || y0 >= yBlocks ) continue;
+    const size_t count = std::min( SQUARE, src.slots() - square );
+    for ( size_t i = 0; i < count; ++i )
+    {
+      const unsigned bx = x0 + dx[i], by = y0 + dy[i];
+      if ( bx < xBlocks && by < yBlocks ) step( bx, by );
+    }
+  }
+}
@@ -0,0 +1,84 @@
+///
+/// Game of life board in 8x8 blocks, one 64 bit word per block.
+/// (C) Andrew Brownbill 2019
+///
+
+#ifndef BLOCK_BOARD_H
+#define BLOCK_BOARD_H
+
+#include <cstdint>
+
+#include "huge_pages.h"
+#include "packed_board.h"
+
+// Cells on a side of a block.
+constexpr unsigned BLOCK_SIDE = 8;
+
+// A torus stored as 8x8 blocks, bit r * 8 + c of a block holding the
+// cell c across and r down.  A block's neighbors are all in one word, so
+// stepping it needs the block and its 8 neighbors rather than three rows
+// of words.  Blocks are laid out in Morton (Z) order by default, so
+// blocks close on the board are close in memory both across and down; a
+// block's north and south neighbors are usually on the same page rather
+// than a row of blocks away.  The Morton space is a power of 2 square, so
+// boards far from square waste the unused part of it.  RowMajor lays the
+// blocks out a row at a time instead, for comparison.  Big boards go on
+// huge pages, see PageBuffer.  Width and height must be multiples of 8.
+class BlockBoard
+{
+  public:
+
+  enum class Layout { Morton, RowMajor };
+
+  BlockBoard( unsigned width, unsigned height, Layout layout = Layout::Morton, bool hugePages = true );
+
+  unsigned width() const { return xSize; }
+  unsigned height() const { return ySize; }
+  unsigned blocksWide() const { return xBlocks; }
+  unsigned blocksHigh() const { return yBlocks; }
+  Layout layout() const { return order; }
+  bool usingHugePages() const { return blocks.usingHugePages(); }
+
+  // Blocks in storage order, including the unused Morton ones.  A slot is
+  // always column part + row part, so stepping can work them out once per
+  // column and row.
+  size_t slots() const { return blocks.size(); }
+  size_t slot( unsigned bx, unsigned by ) const { return columnPart( bx ) + rowPart( by ); }
+  size_t columnPart( unsigned bx ) const;
+  size_t rowPart( unsigned by ) const;
+  // Block at slot, false for an unused one.
+  bool position( size_t slot, unsigned& bx, unsigned& by ) const;
+
+  // The Morton curve: x bits to the even bits, y bits to the odd bits.
+  static size_t mortonSlot( unsigned bx, unsigned by );
+  static void mortonPosition( size_t slot, unsigned& bx, unsigned& by );
+
+  uint64_t block( unsigned bx, unsigned by ) const { return blocks[ slot( bx, by ) ]; }
+  uint64_t& block( unsigned bx, unsigned by ) { return blocks[ slot( bx, by ) ]; }
+  const uint64_t* data() const { return blocks.data(); }
+  uint64_t* data() { return blocks.data(); }
+
+  void clear();
+  size_t population() const;
+  size_t memoryUsed() const { return blocks.bytes(); }
+
+  // Convert from / to the row packed board.
+  void load( const PackedBoard& board );
+  void store( PackedBoard& board ) const;
+
+  private:
+
+  unsigned xSize;
+  unsigned ySize;
+  unsigned xBlocks;
+  unsigned yBlocks;
+  Layout order;
+  PageBuffer blocks;
+};
+
+// Move the board forward one iteration into dst, a block at a time in
+// storage order.  Blocks with nothing alive around them are skipped.  dst
+// must have the same size and layout.
+void advanceBlocks( const BlockBoard& src, BlockBoard& dst );
+
+#endif
@@ -0,0 +1,74 @@
+///
+/// Drawing the hash map engines' cells into a pixel buffer.
+/// (C) Andrew Brownbill 2019
+///
+
+#include <algorithm>
+
+#include "age_planes.h"
+#include "cell_render.h"
+
+// Palette entry for an age.
+static inline uint32_t ageColor( unsigned age, const std::vector< uint32_t >& colors )
+{
+  return colors[ std::min< size_t >( age / AGE_RATE, colors.size() - 1 ) ];
+}
+
+void renderCellsUnordered( const LifeBuffer& buffer, const LifeBuffer& ages, const std::vector< uint32_t >& colors,
+                           uint32_t background, const CellView& view )
+{
+  const unsigned ppc = view.pixelsPerCell;
+  for ( unsigned y = 0; y < view.rows * ppc; ++y ) {
+    std::fill( view.pixels + size_t( y ) * view.pitch, view.pixels + size_t( y ) * view.pitch + view.columns * ppc,
+               background );
+  }
+
+  for ( const auto& i : buffer )
+  {
+    if ( !i.second.value ) continue;
+    const LifeCoord& c = i.first;
+    const uint32_t color = ageColor( ages.at( c ).value, colors );
+    for ( unsigned x = 0; x < ppc; ++x ) {
+      for ( unsigned y = 0; y < ppc; ++y ) {
+        view.pixels[ size_t( c.second * ppc + y ) * view.pitch + c.first * ppc + x ] = color;
+      }
+    }
+  }
+}
+
+void RowRenderer::render( const LifeBuffer& buffer, const LifeBuffer& ages, const std::vector< uint32_t >& colors,
+                          uint32_t background, const CellView& view )
+{
+  // One walk of the map: the live cells with their colors, one age
+  // lookup each, and a count per row.
+  rowStart.assign( view.rows + 1, 0 );
+  found.clear();
+  for ( const auto& i : buffer )
+  {
+    if ( !i.second.value ) continue;
+    const auto age = ages.find( i.first );
+    const unsigned value = ( age == ages.end() ) ? 0 : age->second.value;
+    found.push_back( Found{ i.first.first, i.first.second, ageColor( value, colors ) } );
+    ++rowStart[ i.first.second + 1 ];
+  }
+
+  // Counts to offsets, then bin by row.
+  for ( unsigned y = 0; y < view.rows; ++y ) rowStart[ y + 1 ] += rowStart[ y ];
+  cells.resize( found.size() );
+  next.assign( rowStart.begin(), rowStart.end() - 1 );
+  for ( const Found& f : found ) cells[ next[ f.y ]++ ] = Cell{ f.x, f.color };
+
+  // Top to bottom, each pixel row written once.
+  const unsigned ppc = view.pixelsPerCell;
+  for ( unsigned y = 0; y < view.rows; ++y )
+  {
+    uint32_t* line = view.pixels + size_t( y ) * ppc * view.pitch;
+    std::fill( line, line + view.columns * ppc, background );
+    for ( uint32_t i = rowStart[ y ]; i < rowStart[ y + 1 ]; ++i ) {
+      std::fill( line + cells[ i ].x * ppc, line + ( cells[ i ].x + 1 ) * ppc, cells[ i ].color );
+    }
+    for ( unsigned r = 1; r < ppc; ++r ) {
+      std::copy( line, line + view.columns * ppc, line + r * view.pitch );
+    }
+  }
+}
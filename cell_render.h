@@ -0,0 +1,74 @@
+///
+/// Drawing the hash map engines' cells into a pixel buffer.
+/// (C) Andrew Brownbill 2019
+///
+
+#ifndef CELL_RENDER_H
+#define CELL_RENDER_H
+
+#include <cstdint>
+#include <vector>
+
+#include "life.h"
+
+// Where the grid goes: columns x rows cells, pixelsPerCell square each,
+// into pixels with pitch pixels per row.
+class CellView
+{
+  public:
+
+  unsigned columns;
+  unsigned rows;
+  unsigned pixelsPerCell;
+  uint32_t* pixels;
+  unsigned pitch;
+};
+
+// Draw the live cells of buffer in colors[ age / AGE_RATE ], clipped to
+// the last color, on background.  Cells come in hash map order, so the
+// pixel writes land all over the frame, and each cell's age is a second
+// hash lookup.  The page's original drawScreen; kept to compare against.
+void renderCellsUnordered( const LifeBuffer& buffer, const LifeBuffer& ages, const std::vector< uint32_t >& colors,
+                           uint32_t background, const CellView& view );
+
+// renderCellsUnordered's picture drawn a row at a time.  One pass over
+// the map finds each live cell's age, a counting sort bins the cells by
+// row, and a last pass goes down the bins, writing each pixel row once,
+// background and cells together, from top to bottom.
+class RowRenderer
+{
+  public:
+
+  void render( const LifeBuffer& buffer, const LifeBuffer& ages, const std::vector< uint32_t >& colors,
+               uint32_t background, const CellView& view );
+
+  size_t memoryUsed() const
+  {
+    return ( rowStart.capacity() + next.capacity() ) * sizeof( uint32_t ) +
+           cells.capacity() * sizeof( Cell ) + found.capacity() * sizeof( Found );
+  }
+
+  private:
+
+  class Found
+  {
+    public:
+    uint32_t x;
+    uint32_t y;
+    uint32_t color;
+  };
+
+  class Cell
+  {
+    public:
+    uint32_t x;
+    uint32_t color;
+  };
+
+  std::vector< uint32_t > rowStart;     // Bins, rows + 1 offsets into cells
+  std::vector< uint32_t > next;         // Where each row's next cell goes
+  std::vector< Cell > cells;
+  std::vector< Found > found;           // Live cells in map order
+};
+
+#endif
@@ -1,5 +1,33 @@
 #!/bin/bash
+#
+# Builds the two versions of the page.  shell.html loads gol_simd.js
+# when the browser has simd128 and the page is cross origin isolated
+# (needed for threads), gol_baseline.js otherwise.
+#
+# GOL_SNAPSHOT=1 ./compile.sh starts the page from the board in
+# snapshot.h (see gol_snapshot) instead of random glider guns.
+#
+# GOL_SDL2=1 ./compile.sh shows frames through an SDL2 streaming texture,
+# one generation per requestAnimationFrame, instead of the SDL1 surface.
+#
+# GOL_MEMORY64=1 ./compile.sh also builds gol_memory64.js, with 64 bit
+# pointers for boards past 4 GB.  index.html?huge loads it.
+#
 
-mkdir -p docs
-emcc game_of_life.cpp -O2 --shell-file $EMSDK/upstream/emscripten/src/shell_minimal.html -std=c++11 -s WASM=1 -s USE_SDL=2 -s USE_SDL_IMAGE=2 -s USE_SDL_TTF=2 -o docs/index.html
+SOURCES="game_of_life.cpp age_planes.cpp hex_life.cpp display.cpp block_board.cpp cell_render.cpp huge_pages.cpp engine_selector.cpp hashlife.cpp hashlife_view.cpp life.cpp life_engine.cpp life_slab.cpp lut_engine.cpp memory_budget.cpp occupancy.cpp packed_board.cpp packed_simd.cpp list_life.cpp parallel_engine.cpp sorted_life.cpp step_thread.cpp voxel_life.cpp fft.cpp lenia.cpp life_rule.cpp rule_circuit.cpp rule_kernel.cpp rule_compiler.cpp"
+FLAGS=(-O2 -std=c++11 -s WASM=1 -s "EXPORTED_RUNTIME_METHODS=['ccall','cwrap','addFunction']" -s USE_SDL=2 -s USE_SDL_IMAGE=2 -s USE_SDL_TTF=2 -s ALLOW_MEMORY_GROWTH=1 -s ALLOW_TABLE_GROWTH=1)
+
+if [ -n "$GOL_SNAPSHOT" ]; then
+  FLAGS+=(-DGOL_SNAPSHOT)
+fi
+if [ -n "$GOL_SDL2" ]; then
+  FLAGS+=(-DGOL_SDL2)
+fi
 
+mkdir -p docs
+emcc $SOURCES "${FLAGS[@]}" -s MAXIMUM_MEMORY=4GB -o docs/gol_baseline.js
+emcc $SOURCES "${FLAGS[@]}" -s MAXIMUM_MEMORY=4GB -msimd128 -pthread -s PTHREAD_POOL_SIZE=8 -s PTHREAD_POOL_SIZE_STRICT=2 -o docs/gol_simd.js
+if [ -n "$GOL_MEMORY64" ]; then
+  emcc $SOURCES "${FLAGS[@]}" -s MEMORY64=1 -s MAXIMUM_MEMORY=16GB -o docs/gol_memory64.js
+fi
+cp shell.html docs/index.html
@@ -0,0 +1,138 @@
+///
+/// Getting the drawn frame onto the page.
+/// (C) Andrew Brownbill 2019
+///
+
+#include <algorithm>
+
+#include <emscripten.h>
+
+#include "display.h"
+#include "life.h"
+
+// Weight of the newest present() in the average.
+constexpr double SMOOTHING = 0.1;
+
+#ifdef GOL_SDL2
+
+Display::Display() : drawn( Y_SCREEN, true ), drawnBefore( Y_SCREEN, true ), average( 0 ), sent( 0 )
+{
+  SDL_Init( SDL_INIT_VIDEO );
+  window = SDL_CreateWindow( "Game of Life", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
+                             X_SCREEN, Y_SCREEN, 0 );
+  renderer = SDL_CreateRenderer( window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC );
+  texture = SDL_CreateTexture( renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING,
+                               X_SCREEN, Y_SCREEN );
+  screen = SDL_CreateRGBSurfaceWithFormat( 0, X_SCREEN, Y_SCREEN, 32, SDL_PIXELFORMAT_ARGB8888 );
+}
+
+Display::~Display()
+{
+  SDL_FreeSurface( screen );
+  SDL_DestroyTexture( texture );
+  SDL_DestroyRenderer( renderer );
+  SDL_DestroyWindow( window );
+  SDL_Quit();
+}
+
+const char* Display::path() const
+{
+  return "texture";
+}
+
+void Display::begin()
+{
+  if ( SDL_MUSTLOCK( screen )) SDL_LockSurface( screen );
+  std::fill( drawn.begin(), drawn.end(), false );
+}
+
+// Upload the runs of rows drawn on this frame or last, last frame's to
+// blank them in the texture, and show the texture.
+void Display::send( bool everyRow )
+{
+  sent = 0;
+  for ( int y = 0; y < Y_SCREEN; )
+  {
+    auto wanted = [&]( int row ) { return everyRow || drawn[ row ] || drawnBefore[ row ]; };
+    if ( !wanted( y ) ) {
+      ++y;
+      continue;
+    }
+    int end = y + 1;
+    while ( end < Y_SCREEN && wanted( end )) ++end;
+    const SDL_Rect rows{ 0, y, X_SCREEN, end - y };
+    SDL_UpdateTexture( texture, &rows, static_cast< Uint8* >( screen->pixels ) + y * screen->pitch, screen->pitch );
+    sent += unsigned( end - y );
+    y = end;
+  }
+  SDL_RenderCopy( renderer, texture, nullptr, nullptr );
+  SDL_RenderPresent( renderer );
+}
+
+void Display::present()
+{
+  const double begin = emscripten_get_now();
+  if ( SDL_MUSTLOCK( screen )) SDL_UnlockSurface( screen );
+  send( false );
+  drawnBefore.swap( drawn );
+
+  const double took = emscripten_get_now() - begin;
+  average = average ? average + SMOOTHING * ( took - average ) : took;
+}
+
+double Display::timePresent( unsigned frames, bool everyRow )
+{
+  // present() moved this frame's rows to drawnBefore; put them back so
+  // the runs are the same ones it sent.
+  drawn = drawnBefore;
+  const unsigned rows = sent;
+  const double begin = emscripten_get_now();
+  for ( unsigned i = 0; i < frames; ++i ) send( everyRow );
+  const double took = ( emscripten_get_now() - begin ) / std::max( frames, 1u );
+  sent = rows;
+  return took;
+}
+
+#else
+
+Display::Display() : average( 0 ), sent( 0 )
+{
+  SDL_Init( SDL_INIT_VIDEO );
+  screen = SDL_SetVideoMode( X_SCREEN, Y_SCREEN, 32, SDL_SWSURFACE );
+}
+
+Display::~Display()
+{
+  screen = nullptr;
+  SDL_Quit();
+}
+
+const char* Display::path() const
+{
+  return "surface";
+}
+
+void Display::begin()
+{
+  if ( SDL_MUSTLOCK( screen )) SDL_LockSurface( screen );
+}
+
+void Display::present()
+{
+  const double begin = emscripten_get_now();
+  if ( SDL_MUSTLOCK( screen )) SDL_UnlockSurface( screen );
+  SDL_UpdateRect( screen, 0, 0, 0, 0 );
+  sent = Y_SCREEN;
+
+  const double took = emscripten_get_now() - begin;
+  average = average ? average + SMOOTHING * ( took - average ) : took;
+}
+
+double Display::timePresent( unsigned frames, bool )
+{
+  const double begin = emscripten_get_now();
+  for ( unsigned i = 0; i < frames; ++i ) SDL_UpdateRect( screen, 0, 0, 0, 0 );
+  return ( emscripten_get_now() - begin ) / std::max( frames, 1u );
+}
+
+#endif
@@ -0,0 +1,82 @@
+///
+/// Getting the drawn frame onto the page.
+/// (C) Andrew Brownbill 2019
+///
+
+#ifndef DISPLAY_H
+#define DISPLAY_H
+
+#include <algorithm>
+#include <vector>
+
+#ifdef GOL_SDL2
+#include <SDL2/SDL.h>
+#else
+#include <SDL/SDL.h>
+#endif
+
+// The frame everything draws into and how it's shown.  The default build
+// draws into the SDL1 video surface and shows it with SDL_UpdateRect,
+// through emscripten's SDL1 emulation.  Built with -DGOL_SDL2 it draws
+// into a plain surface and streams it to an SDL2 texture: only the rows
+// that had anything drawn this frame or last go up, a run of them at a
+// time, then the renderer copies the texture to the canvas.  The drawing
+// says which rows it drew on through drew(), so nothing reads the frame
+// back.  present() is timed either way, so the two builds can be
+// compared from the stats overlay, or with timePresent().
+class Display
+{
+  public:
+
+  Display();
+  Display( const Display& ) = delete;
+  Display& operator=( const Display& ) = delete;
+  ~Display();
+
+  // Where to draw, X_SCREEN by Y_SCREEN, between begin() and present().
+  SDL_Surface* surface() { return screen; }
+
+  void begin();
+  void present();
+
+  // Pixel rows [top, bottom) have something other than background on
+  // them this frame.
+  void drew( unsigned top, unsigned bottom )
+  {
+#ifdef GOL_SDL2
+    std::fill( drawn.begin() + top, drawn.begin() + bottom, true );
+#else
+    (void) top;
+    (void) bottom;
+#endif
+  }
+
+  // Milliseconds to show the last frame again, averaged over frames,
+  // sending the rows present() did or, with everyRow, all of them.  The
+  // surface build always sends all of them.
+  double timePresent( unsigned frames, bool everyRow );
+
+  // "surface" or "texture".
+  const char* path() const;
+
+  // present() time, smoothed, and how many rows the last one sent.
+  double presentMilliseconds() const { return average; }
+  unsigned rowsSent() const { return sent; }
+
+  private:
+
+  SDL_Surface* screen;
+#ifdef GOL_SDL2
+  SDL_Window* window;
+  SDL_Renderer* renderer;
+  SDL_Texture* texture;
+  void send( bool everyRow );
+
+  std::vector< bool > drawn;          // Rows drawn on this frame
+  std::vector< bool > drawnBefore;    // and last frame
+#endif
+  double average;
+  unsigned sent;
+};
+
+#endif
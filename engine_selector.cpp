@@ -0,0 +1,94 @@
+///
+/// Picks the fastest engine for the board the page is showing.
+/// (C) Andrew Brownbill 2019
+///
+
+#include <algorithm>
+#include <chrono>
+
+#include "age_planes.h"
+#include "engine_selector.h"
+
+constexpr double EngineSelector::SPARSE_BELOW;
+constexpr double EngineSelector::DENSE_ABOVE;
+constexpr unsigned EngineSelector::CHECK_INTERVAL;
+
+EngineSelector::EngineSelector() :
+  platform( PlatformFeatures::probe() ), generations( 0 ), calibrated( false ), dense( false )
+{
+}
+
+std::string EngineSelector::calibrate( LifeEngine& engine )
+{
+  // Enough to see the difference without stalling the page.
+  constexpr unsigned MIN_GENERATIONS = 2;
+  constexpr unsigned MAX_GENERATIONS = 16;
+  constexpr double BUDGET_SECONDS = 0.01;
+
+  // The page ages the cells every generation, off the packed boards or
+  // through cells(), so that's part of the cost.
+  AgePlanes ages( X_GRID, Y_GRID );
+  auto generation = [&]( LifeEngine& candidate, bool agesInline ) {
+    candidate.advance();
+    if ( agesInline ) return;
+    if ( candidate.previousBoard() ) ages.advance( *candidate.previousBoard() );
+    else candidate.cells();
+  };
+
+  const LifeBuffer& start = engine.cells();
+  std::vector< Calibration > last;
+  last.swap( results );
+  for ( const std::string& name : engineNames() )
+  {
+    // A second set of band workers beside the live engine's would want
+    // more threads than the wasm pool holds.  The pool only grows once
+    // the main thread yields, which it doesn't while waiting on the
+    // candidate's bands, so the page would hang.  The live one keeps the
+    // time it had.
+    if ( name == "parallel" && name == engine.name() )
+    {
+      for ( const Calibration& old : last ) {
+        if ( old.engine == name ) results.push_back( old );
+      }
+      continue;
+    }
+
+    std::unique_ptr< LifeEngine > candidate = makeEngine( name );
+    candidate->load( start );
+    const bool agesInline = candidate->trackAges( &ages );
+
+    // The first generation pays for tables and thread start up.
+    generation( *candidate, agesInline );
+
+    const auto begin = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed( 0 );
+    unsigned ran = 0;
+    while ( ran < MIN_GENERATIONS || ( ran < MAX_GENERATIONS && elapsed.count() < BUDGET_SECONDS ))
+    {
+      generation( *candidate, agesInline );
+      ++ran;
+      elapsed = std::chrono::steady_clock::now() - begin;
+    }
+    results.push_back( Calibration{ name, elapsed.count() / ran } );
+  }
+
+  std::sort( results.begin(), results.end(), []( const Calibration& a, const Calibration& b ) {
+    return a.secondsPerGeneration < b.secondsPerGeneration;
+  });
+  return results.front().engine;
+}
+
+std::string EngineSelector::check( LifeEngine& engine )
+{
+  const bool due = !calibrated || ++generations % CHECK_INTERVAL == 0;
+  if ( !due ) return "";
+
+  const double density = double( engine.population() ) / ( double( X_GRID ) * Y_GRID );
+  const bool nowDense = dense ? density >= SPARSE_BELOW : density > DENSE_ABOVE;
+  if ( calibrated && nowDense == dense ) return "";
+
+  calibrated = true;
+  dense = nowDense;
+  const std::string best = calibrate( engine );
+  return best != engine.name() ? best : "";
+}
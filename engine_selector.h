@@ -0,0 +1,61 @@
+///
+/// Picks the fastest engine for the board the page is showing.
+/// (C) Andrew Brownbill 2019
+///
+
+#ifndef ENGINE_SELECTOR_H
+#define ENGINE_SELECTOR_H
+
+#include <string>
+#include <vector>
+
+#include "life_engine.h"
+
+// How long a candidate engine took on the current board.
+class Calibration
+{
+  public:
+
+  std::string engine;
+  double secondsPerGeneration;
+};
+
+// The best engine depends on the population.  The hash engine only
+// touches live cells and their neighbors, the packed engines touch every
+// cell no matter what.  The selector times every engine this platform
+// can run on a copy of the board, and times them again whenever the
+// density moves between the sparse and the dense regime.  The two
+// thresholds are apart so a board sitting near one doesn't flip flop.
+class EngineSelector
+{
+  public:
+
+  // Densities as live cells per cell.
+  static constexpr double SPARSE_BELOW = 0.01;
+  static constexpr double DENSE_ABOVE = 0.03;
+
+  // Generations between density checks.
+  static constexpr unsigned CHECK_INTERVAL = 30;
+
+  EngineSelector();
+
+  const PlatformFeatures& features() const { return platform; }
+  const std::vector< Calibration >& lastCalibration() const { return results; }
+
+  // Time every candidate on the board engine holds and return the
+  // fastest.  Doesn't touch engine's state.
+  std::string calibrate( LifeEngine& engine );
+
+  // Call once per generation.  Returns the engine to switch to, or an
+  // empty string to keep the current one.
+  std::string check( LifeEngine& engine );
+
+  private:
+  PlatformFeatures platform;
+  std::vector< Calibration > results;
+  unsigned generations;
+  bool calibrated;
+  bool dense;
+};
+
+#endif
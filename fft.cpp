@@ -0,0 +1,153 @@
+///
+/// Fast Fourier transforms, four at a time, no libraries.
+/// (C) Andrew Brownbill 2019
+///
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "fft.h"
+
+constexpr double TWO_PI = 6.283185307179586;
+
+// sin( 2π / 3 )
+constexpr float SIN_THIRD = 0.8660254037844386f;
+
+Fft::Fft( unsigned length ) : n( length )
+{
+  if ( length == 0 ) throw std::invalid_argument( "Fft length must be non zero" );
+
+  // Fours first, they take the fewest operations per element.
+  std::vector< unsigned > radices;
+  unsigned rest = length;
+  while ( rest % 4 == 0 ) { radices.push_back( 4 ); rest /= 4; }
+  while ( rest % 2 == 0 ) { radices.push_back( 2 ); rest /= 2; }
+  for ( unsigned f = 3; rest > 1; f += 2 ) {
+    while ( rest % f == 0 ) { radices.push_back( f ); rest /= f; }
+  }
+
+  unsigned remaining = length;
+  unsigned stride = 1;
+  for ( unsigned radix : radices )
+  {
+    Stage stage;
+    stage.radix = radix;
+    stage.length = remaining;
+    stage.stride = stride;
+    const unsigned m = remaining / radix;
+    stage.twiddleRe.resize( size_t( m ) * radix );
+    stage.twiddleIm.resize( size_t( m ) * radix );
+    for ( unsigned p = 0; p < m; ++p ) {
+      for ( unsigned k = 0; k < radix; ++k )
+      {
+        const double angle = -TWO_PI * double( p ) * k / remaining;
+        stage.twiddleRe[ p * radix + k ] = float( std::cos( angle ));
+        stage.twiddleIm[ p * radix + k ] = float( std::sin( angle ));
+      }
+    }
+    if ( radix > 4 ) {
+      for ( unsigned k = 0; k < radix; ++k )
+      {
+        stage.rootRe.push_back( float( std::cos( -TWO_PI * k / radix )));
+        stage.rootIm.push_back( float( std::sin( -TWO_PI * k / radix )));
+      }
+    }
+    stages.push_back( stage );
+    remaining = m;
+    stride *= radix;
+  }
+}
+
+void Fft::forward( Vec4* re, Vec4* im, Vec4* work ) const
+{
+  Vec4* xr = re;
+  Vec4* xi = im;
+  Vec4* yr = work;
+  Vec4* yi = work + n;
+  for ( const Stage& stage : stages )
+  {
+    pass( stage, xr, xi, yr, yi );
+    std::swap( xr, yr );
+    std::swap( xi, yi );
+  }
+  if ( xr != re )
+  {
+    std::copy( xr, xr + n, re );
+    std::copy( xi, xi + n, im );
+  }
+}
+
+void Fft::pass( const Stage& stage, const Vec4* xr, const Vec4* xi, Vec4* yr, Vec4* yi ) const
+{
+  const unsigned radix = stage.radix;
+  const unsigned m = stage.length / radix;
+  const unsigned s = stage.stride;
+
+  // Element r of butterfly p, q in; element k out.
+  auto in = [&]( unsigned p, unsigned q, unsigned r ) { return q + s * ( p + r * m ); };
+  auto out = [&]( unsigned p, unsigned q, unsigned k ) { return q + s * ( radix * p + k ); };
+
+  // Output k of butterfly p times its twiddle.
+  auto store = [&]( unsigned p, unsigned q, unsigned k, Vec4 re, Vec4 im ) {
+    const float wr = stage.twiddleRe[ p * radix + k ];
+    const float wi = stage.twiddleIm[ p * radix + k ];
+    yr[ out( p, q, k ) ] = re * wr - im * wi;
+    yi[ out( p, q, k ) ] = re * wi + im * wr;
+  };
+
+  for ( unsigned p = 0; p < m; ++p ) {
+    for ( unsigned q = 0; q < s; ++q )
+    {
+      if ( radix == 4 )
+      {
+        const Vec4 ar0 = xr[ in( p, q, 0 ) ], ai0 = xi[ in( p, q, 0 ) ];
+        const Vec4 ar1 = xr[ in( p, q, 1 ) ], ai1 = xi[ in( p, q, 1 ) ];
+        const Vec4 ar2 = xr[ in( p, q, 2 ) ], ai2 = xi[ in( p, q, 2 ) ];
+        const Vec4 ar3 = xr[ in( p, q, 3 ) ], ai3 = xi[ in( p, q, 3 ) ];
+        const Vec4 sr = ar0 + ar2, si = ai0 + ai2, dr = ar0 - ar2, di = ai0 - ai2;
+        const Vec4 tr = ar1 + ar3, ti = ai1 + ai3, er = ar1 - ar3, ei = ai1 - ai3;
+        yr[ out( p, q, 0 ) ] = sr + tr;
+        yi[ out( p, q, 0 ) ] = si + ti;
+        store( p, q, 1, dr + ei, di - er );     // d - i e
+        store( p, q, 2, sr - tr, si - ti );
+        store( p, q, 3, dr - ei, di + er );     // d + i e
+      }
+      else if ( radix == 2 )
+      {
+        const Vec4 ar0 = xr[ in( p, q, 0 ) ], ai0 = xi[ in( p, q, 0 ) ];
+        const Vec4 ar1 = xr[ in( p, q, 1 ) ], ai1 = xi[ in( p, q, 1 ) ];
+        yr[ out( p, q, 0 ) ] = ar0 + ar1;
+        yi[ out( p, q, 0 ) ] = ai0 + ai1;
+        store( p, q, 1, ar0 - ar1, ai0 - ai1 );
+      }
+      else if ( radix == 3 )
+      {
+        const Vec4 ar0 = xr[ in( p, q, 0 ) ], ai0 = xi[ in( p, q, 0 ) ];
+        const Vec4 ar1 = xr[ in( p, q, 1 ) ], ai1 = xi[ in( p, q, 1 ) ];
+        const Vec4 ar2 = xr[ in( p, q, 2 ) ], ai2 = xi[ in( p, q, 2 ) ];
+        const Vec4 tr = ar1 + ar2, ti = ai1 + ai2, dr = ar1 - ar2, di = ai1 - ai2;
+        const Vec4 cr = ar0 - tr * 0.5f, ci = ai0 - ti * 0.5f;
+        yr[ out( p, q, 0 ) ] = ar0 + tr;
+        yi[ out( p, q, 0 ) ] = ai0 + ti;
+        store( p, q, 1, cr + di * SIN_THIRD, ci - dr * SIN_THIRD );
+        store( p, q, 2, cr - di * SIN_THIRD, ci + dr * SIN_THIRD );
+      }
+      else
+      {
+        for ( unsigned k = 0; k < radix; ++k )
+        {
+          Vec4 sumRe = {}, sumIm = {};
+          for ( unsigned r = 0; r < radix; ++r )
+          {
+            const unsigned root = ( r * k ) % radix;
+            const Vec4 ar = xr[ in( p, q, r ) ], ai = xi[ in( p, q, r ) ];
+            sumRe += ar * stage.rootRe[ root ] - ai * stage.rootIm[ root ];
+            sumIm += ar * stage.rootIm[ root ] + ai * stage.rootRe[ root ];
+          }
+          store( p, q, k, sumRe, sumIm );
+        }
+      }
+    }
+  }
+}
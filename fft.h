@@ -0,0 +1,58 @@
+///
+/// Fast Fourier transforms, four at a time, no libraries.
+/// (C) Andrew Brownbill 2019
+///
+
+#ifndef FFT_H
+#define FFT_H
+
+#include <vector>
+
+// Four floats.  Written with compiler vector extensions like Vec2 in
+// packed_simd.cpp, so it's SSE or NEON natively and simd128 in wasm
+// builds made with -msimd128.
+typedef float Vec4 __attribute__(( vector_size( 16 )));
+
+// Complex FFTs of one length, any length, run on four signals at once,
+// lane i of every element belonging to signal i.  Mixed radix Stockham:
+// each stage reads one buffer and writes the other in order, so there's
+// no bit reversal and any factor works.  Factors of 4, 2 and 3 have
+// their own butterflies, others go through a plain DFT of the factor,
+// so lengths with big prime factors are slow but right.
+class Fft
+{
+  public:
+
+  explicit Fft( unsigned length );
+
+  unsigned size() const { return n; }
+
+  // Transform re and im, n elements each, in place.  work is 2n of
+  // scratch.  The inverse isn't scaled, dividing by n is up to the
+  // caller.
+  void forward( Vec4* re, Vec4* im, Vec4* work ) const;
+  void inverse( Vec4* re, Vec4* im, Vec4* work ) const { forward( im, re, work ); }
+
+  private:
+
+  // One pass: length / radix butterflies of radix elements spaced
+  // length / radix apart, stride transforms of length interleaved.
+  class Stage
+  {
+    public:
+    unsigned radix;
+    unsigned length;
+    unsigned stride;
+    std::vector< float > twiddleRe;       // [ p * radix + k ], e^-2πi pk / length
+    std::vector< float > twiddleIm;
+    std::vector< float > rootRe;          // [ k ], e^-2πi k / radix, for the plain DFT
+    std::vector< float > rootIm;
+  };
+
+  void pass( const Stage& stage, const Vec4* xr, const Vec4* xi, Vec4* yr, Vec4* yi ) const;
+
+  unsigned n;
+  std::vector< Stage > stages;
+};
+
+#endif
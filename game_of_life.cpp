@@ -3,70 +3,40 @@
 /// (C) Andrew Brownbill 2019
 ///  
 
+#include <algorithm>
+#include <functional>
 #include <iostream>
-#include <utility>
-#include <unordered_map>
-#include <vector>
+#include <memory>
+#include <stdexcept>
 #include <string>
+#include <vector>
 
-#include <SDL/SDL.h>
-#include <emscripten.h>
+#include "life.h"
+#include "age_planes.h"
+#include "block_board.h"
+#include "cell_render.h"
+#include "engine_selector.h"
+#include "hashlife_view.h"
+#include "hex_life.h"
+#include "lenia.h"
+#include "life_engine.h"
+#include "memory_budget.h"
+#include "occupancy.h"
+#include "packed_board.h"
+#include "rule_kernel.h"
+#include "step_thread.h"
+#include "voxel_life.h"
 
-// X and Y screen resolution
-constexpr int X_SCREEN=1024;
-constexpr int Y_SCREEN=768;
-
-// For bigger game of life cells
-constexpr int PIXEL_PER_GRID=2;
-
-// Create the game of life play board.
-constexpr int X_GRID=X_SCREEN/PIXEL_PER_GRID;
-constexpr int Y_GRID=Y_SCREEN/PIXEL_PER_GRID;
-
-// Game of life co-ordinate.  X = first, Y = second.
-using LifeCoord = std::pair<unsigned,unsigned>;
-
-// For making patterns using ASCII art.
-using Pattern = std::vector< std::string >;
-
-// A Glider Gun
-const Pattern gliderGun = {
-  "                         X             ",
-  "                       X X             ",
-  "             XX      XX            XX  ",
-  "            X   X    XX            XX  ",
-  " XX        X     X   XX                ",
-  " XX        X   X XX    X X             ",
-  "           X     X       X             ",
-  "            X   X                      ",
-  "             XX                        ",
-};
+#include "display.h"
 
-// Hash function for a game of life coordinate.
-namespace std {
-  template<>
-  struct hash<LifeCoord>
-  {
-    std::size_t operator()(const LifeCoord& k) const {
-      return hash<unsigned>()(k.first ^ (k.second << 16));
-    }
-  };
-}
-
-// A simple game of life cell state. Defaults to 0
-class CellState
-{
-  public:
-
-  CellState(void) { value = 0; }
-  unsigned value;
-};
-
-// The game of life buffer.  Maps coordinates to cell states.
-using LifeBuffer = std::unordered_map<LifeCoord,CellState>;
+#include <emscripten.h>
+#ifdef GOL_SDL2
+#include <emscripten/html5.h>
+#endif
 
-// We need a double buffer to build the next state.
-using LifeDBuffer = std::pair<LifeBuffer,LifeBuffer>;
+#ifdef GOL_SNAPSHOT
+#include "snapshot.h"
+#endif
 
 // Make a Color palette
 class Palette
@@ -116,113 +86,341 @@ class Palette
   std::vector<Uint32> values;
 };
 
-// Draw the game of life buffer on the screen.
-void drawScreen( SDL_Surface *screen, const LifeBuffer& buffer, const LifeBuffer& age )
+// Draw the game of life buffer on the screen, a row at a time.
+void drawScreen( Display& display, const LifeBuffer& buffer, const LifeBuffer& age, RowRenderer& renderer )
+{
+  SDL_Surface* screen = display.surface();
+  const Uint32 black = SDL_MapRGBA( screen->format, 0, 0, 0, 255 );
+  const Palette palette(screen);
+  const CellView view{ X_GRID, Y_GRID, PIXEL_PER_GRID, (Uint32*)screen->pixels, unsigned( screen->pitch / sizeof( Uint32 )) };
+  renderer.render( buffer, age, palette.values, black, view );
+  // The renderer writes every row, background and all.
+  display.drew( 0, Y_SCREEN );
+}
+
+// Draw a packed board colored by its ages, a word of cells at a time.
+// Cells [margin, size - margin) go on the screen, pixelsPerCell wide.
+void drawScreen( Display& display, const PackedBoard& alive, const AgePlanes& ages,
+                 unsigned margin = 0, unsigned pixelsPerCell = PIXEL_PER_GRID )
 {
+  SDL_Surface* screen = display.surface();
   const Uint32 black = SDL_MapRGBA( screen->format, 0, 0, 0, 255 );
   const Palette palette(screen);
+  static_assert( AGE_BUCKETS == 256, "Palette size doesn't match AGE_BUCKETS" );
 
-  // Clear
   Uint32 *start = (Uint32*)screen->pixels;
-  Uint32 *end= start + X_SCREEN * Y_SCREEN;
-  for ( Uint32 *cur = start; cur < end; ++cur ) *cur = black;
+  std::fill( start, start + X_SCREEN * Y_SCREEN, black );
 
-  // Update with set cells
-  for ( const auto& i : buffer )
+  for ( unsigned y = margin; y + margin < alive.height(); ++y )
   {
-    const LifeCoord& c = i.first;
-    constexpr unsigned AGE_RATE = 16;   // lower values = faster color aging
-    const unsigned int adjustedAge = age.at( c ).value / AGE_RATE;
-    const unsigned int clippedAge = (adjustedAge < palette.values.size()) ?
-        adjustedAge : palette.values.size()-1;
-
-    if ( i.second.value )
-    {
-      for ( int x = 0; x < PIXEL_PER_GRID; ++x ) {
-        for ( int y = 0; y < PIXEL_PER_GRID; ++y ) {
-          const int xc = x + c.first  * PIXEL_PER_GRID;
-          const int yc = y + c.second * PIXEL_PER_GRID;
-          start[ xc + yc * X_SCREEN ] = palette.values.at( clippedAge );
+    const unsigned top = ( y - margin ) * pixelsPerCell;
+    if ( top >= unsigned( Y_SCREEN )) break;
+    const unsigned bottom = std::min( top + pixelsPerCell, unsigned( Y_SCREEN ));
+    const uint64_t* row = alive.row( y );
+    bool any = false;
+    for ( unsigned w = 0; w < alive.wordsPerRow(); ++w ) {
+      for ( uint64_t bits = row[w]; bits; bits &= bits - 1 )
+      {
+        const unsigned x = w * CELLS_PER_WORD + __builtin_ctzll( bits );
+        if ( x < margin || x + margin >= alive.width() ) continue;
+        const unsigned left = ( x - margin ) * pixelsPerCell;
+        if ( left >= unsigned( X_SCREEN )) continue;
+        const unsigned right = std::min( left + pixelsPerCell, unsigned( X_SCREEN ));
+        const Uint32 color = palette.values[ ages.bucket( x, y ) ];
+        for ( unsigned yc = top; yc < bottom; ++yc ) {
+          std::fill( start + yc * X_SCREEN + left, start + yc * X_SCREEN + right, color );
         }
+        any = true;
       }
     }
+    if ( any ) display.drew( top, bottom );
   }
 }
 
-// Move the game forward one iteration.
-void advanceSim( LifeDBuffer &dbuffer )
+// Draw a packed board colored by its ages on its grid.  Hex boards have
+// their odd rows half a cell to the right, so the cells sit like bricks,
+// each touching the six it counts.  The half cell past the right edge
+// wraps round to the left one, as the board does.
+void drawScreen( Display& display, const PackedBoard& alive, const AgePlanes& ages, CellGrid grid )
 {
-  // Swap old for new.
-  std::swap( dbuffer.first, dbuffer.second );
+  SDL_Surface* screen = display.surface();
+  if ( grid == CellGrid::Square ) {
+    drawScreen( display, alive, ages );
+    return;
+  }
+  const Uint32 black = SDL_MapRGBA( screen->format, 0, 0, 0, 255 );
+  const Palette palette(screen);
+  static_assert( X_GRID * PIXEL_PER_GRID == X_SCREEN, "The hex rows wrap at the screen's edge" );
 
-  // Clear out the new buffer.
-  dbuffer.first.clear();
+  Uint32 *start = (Uint32*)screen->pixels;
+  std::fill( start, start + X_SCREEN * Y_SCREEN, black );
 
-  // Figure out hold many neighbors each cell has.
-  for ( const auto& i : dbuffer.second )
+  for ( unsigned y = 0; y < alive.height() && y < unsigned( Y_GRID ); ++y )
   {
-    if ( i.second.value == 0 ) continue;
-    const LifeCoord& c = i.first;
-    for ( int x = -1; x <=1; ++x ) {
-      for ( int y = -1; y <=1; ++y ) {
-        if ( x !=0 || y != 0 ) {    // I can't be a neighbor of myself
-          const int xc = (x+c.first  + X_GRID) % X_GRID; // wrap around x
-          const int yc = (y+c.second + Y_GRID) % Y_GRID; // wrap around y
-          dbuffer.first[ LifeCoord( xc, yc )].value += 1;
+    const unsigned shift = y % 2 ? PIXEL_PER_GRID / 2 : 0;
+    const uint64_t* row = alive.row( y );
+    bool any = false;
+    for ( unsigned w = 0; w < alive.wordsPerRow(); ++w ) {
+      for ( uint64_t bits = row[w]; bits; bits &= bits - 1 )
+      {
+        const unsigned x = w * CELLS_PER_WORD + __builtin_ctzll( bits );
+        if ( x >= unsigned( X_GRID )) continue;
+        const Uint32 color = palette.values[ ages.bucket( x, y ) ];
+        const unsigned left = x * PIXEL_PER_GRID + shift;
+        for ( unsigned yc = y * PIXEL_PER_GRID; yc < ( y + 1 ) * PIXEL_PER_GRID; ++yc )
+        {
+          Uint32* line = start + yc * X_SCREEN;
+          for ( unsigned xc = left; xc < left + PIXEL_PER_GRID; ++xc ) line[ xc % X_SCREEN ] = color;
         }
+        any = true;
       }
-    }   
+    }
+    if ( any ) display.drew( y * PIXEL_PER_GRID, ( y + 1 ) * PIXEL_PER_GRID );
   }
+}
+
+// Draw a packed board colored by its ages, visiting only the words
+// occupied says hold live cells.
+void drawScreen( Display& display, const PackedBoard& alive, const AgePlanes& ages,
+                 const Occupancy& occupied )
+{
+  SDL_Surface* screen = display.surface();
+  const Uint32 black = SDL_MapRGBA( screen->format, 0, 0, 0, 255 );
+  const Palette palette(screen);
+
+  Uint32 *start = (Uint32*)screen->pixels;
+  std::fill( start, start + X_SCREEN * Y_SCREEN, black );
+
+  const uint64_t* cells = alive.row( 0 );
+  occupied.forEach( [&]( size_t i ) {
+    const unsigned y = unsigned( i / alive.wordsPerRow() );
+    const unsigned w = unsigned( i % alive.wordsPerRow() );
+    for ( uint64_t bits = cells[ i ]; bits; bits &= bits - 1 )
+    {
+      const unsigned x = w * CELLS_PER_WORD + __builtin_ctzll( bits );
+      const Uint32 color = palette.values[ ages.bucket( x, y ) ];
+      for ( unsigned yc = y * PIXEL_PER_GRID; yc < ( y + 1 ) * PIXEL_PER_GRID; ++yc ) {
+        Uint32* line = start + yc * X_SCREEN + x * PIXEL_PER_GRID;
+        std::fill( line, line + PIXEL_PER_GRID, color );
+      }
+    }
+    if ( cells[ i ] ) display.drew( y * PIXEL_PER_GRID, ( y + 1 ) * PIXEL_PER_GRID );
+  });
+}
 
-  // Apply the game of life rules to any cells with neighbors from
-  // the old buffer.
-  for ( auto& i : dbuffer.first )
+// Draw a block board colored by its ages, a block at a time in the
+// board's storage order, so drawing walks memory along the same curve as
+// stepping.
+void drawScreen( Display& display, const BlockBoard& alive, const AgePlanes& ages )
+{
+  SDL_Surface* screen = display.surface();
+  const Uint32 black = SDL_MapRGBA( screen->format, 0, 0, 0, 255 );
+  const Palette palette(screen);
+
+  Uint32 *start = (Uint32*)screen->pixels;
+  std::fill( start, start + X_SCREEN * Y_SCREEN, black );
+
+  const uint64_t* blocks = alive.data();
+  for ( size_t s = 0; s < alive.slots(); ++s )
   {
-    if ( i.second.value <= 1 ) i.second.value = 0;         // Starve
-    else if ( i.second.value == 3 ) i.second.value = 1;    // Expand 
-    else if ( i.second.value >= 4 ) i.second.value = 0;    // Overpopulate
-    else i.second.value = dbuffer.second[ i.first ].value; // Same as before
+    unsigned bx, by;
+    if ( !blocks[ s ] || !alive.position( s, bx, by )) continue;
+    for ( uint64_t bits = blocks[ s ]; bits; bits &= bits - 1 )
+    {
+      const unsigned bit = __builtin_ctzll( bits );
+      const unsigned x = bx * BLOCK_SIDE + bit % BLOCK_SIDE;
+      const unsigned y = by * BLOCK_SIDE + bit / BLOCK_SIDE;
+      const Uint32 color = palette.values[ ages.bucket( x, y ) ];
+      for ( unsigned yc = y * PIXEL_PER_GRID; yc < ( y + 1 ) * PIXEL_PER_GRID; ++yc ) {
+        Uint32* line = start + yc * X_SCREEN + x * PIXEL_PER_GRID;
+        std::fill( line, line + PIXEL_PER_GRID, color );
+      }
+    }
+    // The block's rows of cells, as far down the screen as they go.
+    const unsigned top = by * BLOCK_SIDE * PIXEL_PER_GRID;
+    if ( top < unsigned( Y_SCREEN )) {
+      display.drew( top, std::min( top + BLOCK_SIDE * PIXEL_PER_GRID, unsigned( Y_SCREEN )));
+    }
   }
 }
 
-void advanceAge( LifeBuffer& age, const LifeBuffer& current )
+// Draw a Lenia world filling the screen, values through the palette,
+// black where they're too small to show.
+void drawScreen( Display& display, const Lenia& lenia )
 {
-  std::vector< LifeCoord > toErase;   // Erase all cells not in current
-  for ( auto& cell : age )
+  SDL_Surface* screen = display.surface();
+  const Uint32 black = SDL_MapRGBA( screen->format, 0, 0, 0, 255 );
+  const Palette palette(screen);
+
+  Uint32 *start = (Uint32*)screen->pixels;
+  for ( unsigned y = 0; y < Y_GRID; ++y )
   {
-    if ( current.count( cell.first ) == 0 ) toErase.push_back( cell.first );
+    const float* row = lenia.row( y );
+    bool any = false;
+    for ( unsigned x = 0; x < X_GRID; ++x )
+    {
+      const unsigned level = unsigned( row[x] * ( AGE_BUCKETS - 1 ));
+      const Uint32 color = level ? palette.values[ level ] : black;
+      for ( unsigned yc = y * PIXEL_PER_GRID; yc < ( y + 1 ) * PIXEL_PER_GRID; ++yc ) {
+        Uint32* line = start + yc * X_SCREEN + x * PIXEL_PER_GRID;
+        std::fill( line, line + PIXEL_PER_GRID, color );
+      }
+      any = any || level;
+    }
+    if ( any ) display.drew( y * PIXEL_PER_GRID, ( y + 1 ) * PIXEL_PER_GRID );
   }
-  for ( const auto& key : toErase ) age.erase( key );
+}
+
+// Draw what a view shows of a volume, as big as fits, in the middle of
+// the screen.
+void drawScreen( Display& display, const VoxelView& view )
+{
+  SDL_Surface* screen = display.surface();
+  const Uint32 black = SDL_MapRGBA( screen->format, 0, 0, 0, 255 );
+  const Palette palette(screen);
 
-  for ( const auto& cell : current )
+  Uint32 *start = (Uint32*)screen->pixels;
+  std::fill( start, start + X_SCREEN * Y_SCREEN, black );
+
+  const PackedBoard& cells = view.cells();
+  const unsigned scale = std::max( 1u, std::min( X_SCREEN / cells.width(), Y_SCREEN / cells.height() ));
+  const unsigned across = std::min( cells.width(), X_SCREEN / scale );
+  const unsigned down = std::min( cells.height(), Y_SCREEN / scale );
+  const unsigned left = ( X_SCREEN - across * scale ) / 2;
+  const unsigned top = ( Y_SCREEN - down * scale ) / 2;
+  for ( unsigned y = 0; y < down; ++y )
   {
-    age[ cell.first ].value += 1;
+    const uint64_t* row = cells.row( y );
+    bool any = false;
+    for ( unsigned w = 0; w < cells.wordsPerRow(); ++w ) {
+      for ( uint64_t bits = row[w]; bits; bits &= bits - 1 )
+      {
+        const unsigned x = w * CELLS_PER_WORD + __builtin_ctzll( bits );
+        if ( x >= across ) continue;
+        const Uint32 color = palette.values[ view.level( x, y ) ];
+        for ( unsigned yc = top + y * scale; yc < top + ( y + 1 ) * scale; ++yc ) {
+          Uint32* line = start + yc * X_SCREEN + left + x * scale;
+          std::fill( line, line + scale, color );
+        }
+        any = true;
+      }
+    }
+    if ( any ) display.drew( top + y * scale, top + ( y + 1 ) * scale );
   }
-} 
+}
+
+// Something that takes the board's place on the page, stepping and
+// drawing itself a frame at a time while the board waits where it was.
+class PageMode : public MemoryClient
+{
+  public:
+
+  virtual void advance() = 0;
+  virtual void draw( Display& display ) = 0;
+  virtual std::string name() const = 0;
+  virtual uint64_t generation() const = 0;
+};
 
-void dropPattern( 
-  LifeBuffer& grid,           // Destination 
-  const unsigned x,           // x target location
-  const unsigned y,           // y target location
-  const Pattern& pattern,     // The pattern to write to that location
-  const unsigned int rotate ) // How should the pattern be rotated? (0-3).
+// A SIDE^3 volume under a 3D rule from a random blob in the middle,
+// drawn a layer at a time or projected.
+class VoxelMode : public PageMode
 {
-  int yp=0;
-  for ( const auto& row : pattern )
+  public:
+
+  // 16M voxels, 2 MB a generation.  The blob they start from is 1/64th
+  // of the volume, a little under a third alive.
+  static constexpr unsigned SIDE = 256;
+  static constexpr unsigned SEED_SIDE = 64;
+  static constexpr unsigned SEED_PERCENT = 30;
+
+  VoxelMode( const VoxelRule& rule, unsigned threads, int layer ) :
+    life( SIDE, SIDE, SIDE, rule, threads ), view( SIDE, SIDE ), shownLayer( layer )
   {
-    int xp=0;
-    for ( char c : row ) {
-      const unsigned xc = ( x + xp + X_GRID ) % X_GRID;
-      const unsigned yc = ( y + yp + Y_GRID ) % Y_GRID;
-      grid[ LifeCoord( xc, yc ) ].value = (c == 'X') ? 1 : 0;   
-      xp += ( rotate & 1 ) ? 1 : -1;
-    }
-    yp += ( rotate & 2 ) ? 1 : -1;
+    seedCube( life.board(), SEED_SIDE, SEED_PERCENT, unsigned( rand() ));
+  }
+
+  // Show layer z, or every layer projected for negative z.
+  void setLayer( int z ) { shownLayer = z; }
+
+  void advance() override { life.advance(); }
+
+  void draw( Display& display ) override
+  {
+    if ( shownLayer < 0 ) view.project( life.board() );
+    else view.slice( life.board(), unsigned( shownLayer ));
+    drawScreen( display, view );
   }
-} 
 
-// Creates the screen and initial board.  Updates the game.
-class LifeSingleton
+  std::string name() const override
+  {
+    return "voxel " + life.rule().toString() + " " + std::to_string( life.threads() ) + " threads " +
+           ( shownLayer < 0 ? std::string( "projected" ) : "layer " + std::to_string( shownLayer ));
+  }
+
+  uint64_t generation() const override { return life.generation(); }
+
+  void memoryUsage( std::vector< MemoryUse >& report ) const override
+  {
+    life.memoryUsage( report );
+    report.push_back( MemoryUse{ "render", view.memoryUsed() } );
+  }
+
+  private:
+  VoxelLife life;
+  VoxelView view;
+  int shownLayer;
+};
+
+// An X_GRID x Y_GRID Lenia world from a scatter of random patches.
+class LeniaMode : public PageMode
+{
+  public:
+
+  // Patches four radii across; at the default radius a dozen cover about
+  // a sixth of the world.
+  static constexpr unsigned PATCHES = 12;
+
+  LeniaMode( const LeniaParams& params, unsigned threads ) : lenia( X_GRID, Y_GRID, params, threads )
+  {
+    lenia.seedPatches( PATCHES, unsigned( rand() ));
+  }
+
+  void advance() override { lenia.advance(); }
+  void draw( Display& display ) override { drawScreen( display, lenia ); }
+
+  std::string name() const override
+  {
+    return "lenia R" + std::to_string( lenia.params().radius ) + ( lenia.usesFft() ? " fft " : " direct " ) +
+           std::to_string( lenia.threads() ) + " threads";
+  }
+
+  uint64_t generation() const override { return lenia.generation(); }
+
+  void memoryUsage( std::vector< MemoryUse >& report ) const override { lenia.memoryUsage( report ); }
+
+  private:
+  Lenia lenia;
+};
+
+// The engine the page starts with.  The packed engines only need 64 bit
+// integer ops, so they're quick on browsers without simd128 too.  Build
+// with -DGOL_ENGINE=\"lut\" to start with the lookup table engine.
+#ifndef GOL_ENGINE
+#define GOL_ENGINE "packed"
+#endif
+
+// Which of the two web builds this is, see compile.sh.
+#if defined( __wasm64__ )
+#define GOL_VARIANT "memory64"
+#elif defined( __wasm_simd128__ ) && defined( __EMSCRIPTEN_PTHREADS__ )
+#define GOL_VARIANT "simd+threads"
+#else
+#define GOL_VARIANT "baseline"
+#endif
+
+// Creates the screen and initial board.  Updates the game.  Holds the
+// ages, which it gives up if memory runs short.
+class LifeSingleton : public MemoryClient
 {
   public:
 
@@ -231,50 +429,770 @@ class LifeSingleton
 
   LifeSingleton() 
   {
-    SDL_Init(SDL_INIT_VIDEO );
-    screen = SDL_SetVideoMode(X_SCREEN, Y_SCREEN, 32, SDL_SWSURFACE);
+    screen = display.surface();
 
+    // Build the start board packed, one bit per cell, rather than one
+    // hash map insert per cell.
+    PackedBoard start( X_GRID, Y_GRID );
+#ifdef GOL_SNAPSHOT
+    static_assert( SNAPSHOT_WIDTH == X_GRID && SNAPSHOT_HEIGHT == Y_GRID, "snapshot.h is stale" );
+    for ( unsigned i = 0; i < SNAPSHOT_WORDS; ++i )
+    {
+      const uint64_t index = snapshotWords[ 2 * i ];
+      start.row( index / start.wordsPerRow() )[ index % start.wordsPerRow() ] = snapshotWords[ 2 * i + 1 ];
+    }
+#else
     // Draw some glider guns
     for ( int i = 0; i < 10; ++i )
     {
-      dropPattern( life.first, rand() % X_GRID, rand() % Y_GRID, gliderGun, rand() % 4 ); 
+      dropPattern( start, rand() % X_GRID, rand() % Y_GRID, gliderGun, rand() % 4 ); 
     }
+#endif
+    const PlatformFeatures& features = selector.features();
+    pipelined = features.threads && features.cores > 1;
+    engine = makeEngine( GOL_ENGINE );
+    engine->load( start );
+    syncAges();
+    budget.attach( engine.get(), ENGINE_PRIORITY );
+    budget.attach( this, AGE_PRIORITY );
+
+    std::cout << "simd " << ( features.simd ? "yes" : "no" )
+              << ", threads " << ( features.threads ? "yes" : "no" )
+              << ", cores " << features.cores << std::endl;
+    constructedAt = emscripten_get_now();
   }
   ~LifeSingleton()
   {
+    dropMode();
+    budget.detach( this );
+    budget.detach( engine.get() );
     screen = nullptr;
-    SDL_Quit();
   }
   
+  // Switch engines, keeping the board.  Ages live here, so they carry
+  // over.  Returns false for unknown engines.
+  bool setEngine( const std::string& name )
+  {
+    return useEngine( makeEngine( name ));
+  }
+
+  // Run the board under rule from now on.  Only RuleEngine knows rules
+  // other than B3/S23.
+  void setRule( const LifeRule& rule )
+  {
+    useEngine( std::unique_ptr< LifeEngine >( new RuleEngine( rule )));
+  }
+
+  // Run the board as a hex grid under rule, see HexEngine.  Throws
+  // std::invalid_argument for rules counting past six neighbors.
+  void setHexRule( const LifeRule& rule )
+  {
+    useEngine( std::unique_ptr< LifeEngine >( new HexEngine( rule )));
+  }
+
+  // Time the rule's kernel, compiled if this build can, against the
+  // generic lookup path, on a copy of the board.  B3/S23 unless the board
+  // runs under another rule.
+  std::string benchRule( unsigned generations )
+  {
+    const RuleEngine* ruled = dynamic_cast< const RuleEngine* >( engine.get() );
+    const LifeRule rule = ruled ? ruled->rule() : LifeRule::conway();
+    const RowKernel kernel = ruled ? ruled->compiledKernel() : nullptr;
+    PackedBoard start( X_GRID, Y_GRID );
+    start.load( engine->cells() );
+    auto time = [&]( const std::function< void( const PackedBoard&, PackedBoard& ) >& step ) {
+      PackedBoard board( start ), other( X_GRID, Y_GRID );
+      const double begin = emscripten_get_now();
+      for ( unsigned i = 0; i < generations; ++i )
+      {
+        step( board, other );
+        std::swap( board, other );
+      }
+      return std::to_string(( emscripten_get_now() - begin ) / generations ) + "ms";
+    };
+    std::string report = rule.toString();
+    if ( kernel ) {
+      report += " compiled " + time( [&]( const PackedBoard& src, PackedBoard& dst ) { advanceRule( src, dst, kernel ); } );
+    }
+    const RuleCircuit circuit = RuleCircuit::synthesize( rule );
+    report += " circuit " + time( [&]( const PackedBoard& src, PackedBoard& dst ) { advanceCircuit( src, dst, circuit ); } );
+    report += " sliced " + time( [&]( const PackedBoard& src, PackedBoard& dst ) { advanceRule( src, dst, rule ); } );
+    report += " lookup " + time( [&]( const PackedBoard& src, PackedBoard& dst ) { advanceRuleLookup( src, dst, rule ); } );
+    return report;
+  }
+
+  // Swap in next, keeping the board.
+  bool useEngine( std::unique_ptr< LifeEngine > next )
+  {
+    if ( !next ) return false;
+    next->load( engine->cells() );
+    budget.detach( engine.get() );
+    engine = std::move( next );
+    budget.attach( engine.get(), ENGINE_PRIORITY );
+    syncAges();
+    return true;
+  }
+
+  // Move the board onto an unbounded plane and run it with HashLife, or
+  // go back to the torus where it was left.
+  void setHashLife( bool on )
+  {
+    if ( on == planar ) return;
+    planar = on;
+    if ( !on )
+    {
+      budget.detach( &hashlife );
+      hashlife.clear();
+      window.reset();
+      windowBefore.reset();
+      windowAges.reset();
+      return;
+    }
+    PackedBoard board( X_GRID, Y_GRID );
+    board.load( engine->cells() );
+    hashlife.load( board, -X_GRID / 2, -Y_GRID / 2 );
+    view = Viewport{ -X_GRID / 2, -Y_GRID / 2, PIXEL_ZOOM, X_SCREEN, Y_SCREEN };
+    budget.attach( &hashlife, ENGINE_PRIORITY );
+  }
+
+  // Run a volume under rule in place of the board, or with nullptr go
+  // back to the board if a volume is running.
+  void setVoxels( const VoxelRule* rule )
+  {
+    if ( !rule ) {
+      if ( dynamic_cast< const VoxelMode* >( mode.get() )) dropMode();
+      return;
+    }
+    dropMode();
+    const unsigned threads = freeThreads();
+    startMode( new VoxelMode( *rule, threads, voxelLayer ));
+  }
+
+  // Run a Lenia world under params in place of the board, or with
+  // nullptr go back to the board if a Lenia world is running.
+  void setLenia( const LeniaParams* params )
+  {
+    if ( !params ) {
+      if ( dynamic_cast< const LeniaMode* >( mode.get() )) dropMode();
+      return;
+    }
+    dropMode();
+    const unsigned threads = freeThreads();
+    startMode( new LeniaMode( *params, threads ));
+  }
+
+  // Show layer z of the volume, or every layer projected for negative z.
+  void setVoxelLayer( int z )
+  {
+    voxelLayer = z < 0 ? -1 : z % int( VoxelMode::SIDE );
+    if ( VoxelMode* voxels = dynamic_cast< VoxelMode* >( mode.get() )) voxels->setLayer( voxelLayer );
+  }
+
+  // Center the view on cell x, y, 2^zoom pixels per cell.
+  void setViewport( int64_t x, int64_t y, int zoom )
+  {
+    view.zoom = std::max( MIN_ZOOM, std::min( MAX_ZOOM, zoom ));
+    const int64_t across = view.zoom >= 0 ? X_SCREEN >> view.zoom : int64_t( X_SCREEN ) << -view.zoom;
+    const int64_t down = view.zoom >= 0 ? Y_SCREEN >> view.zoom : int64_t( Y_SCREEN ) << -view.zoom;
+    view.left = x - across / 2;
+    view.top = y - down / 2;
+  }
+
+  StepController& stepper() { return hashlifeStep; }
+
+  MemoryBudget& memory() { return budget; }
+
+  const Display& screenDisplay() const { return display; }
+  Display& screenDisplay() { return display; }
+
+  void memoryUsage( std::vector< MemoryUse >& report ) const override
+  {
+    size_t bytes = memoryUsed( age ) + agePlanes.memoryUsed();
+    if ( windowAges ) bytes += windowAges->memoryUsed() + window->memoryUsed() + windowBefore->memoryUsed();
+    report.push_back( MemoryUse{ "ages", bytes } );
+    report.push_back( MemoryUse{ "render", rowRenderer.memoryUsed() + shown.memoryUsed() + shownBefore.memoryUsed() } );
+  }
+
+  // Losing the ages only resets the colors.  The planes are small and
+  // fixed, so only the hash map gives memory back.
+  size_t trimMemory( size_t ) override
+  {
+    const size_t freed = memoryUsed( age );
+    LifeBuffer().swap( age );
+    agePlanes.clear();
+    if ( windowAges ) windowAges->clear();
+    return freed;
+  }
+
+  // Let the selector pick engines as the board changes.
+  void setAutoEngine( bool on ) { autoEngine = on; }
+
+  // Step the next generation on a thread of its own while drawing this
+  // one, where there are threads to spare.
+  void setPipelined( bool on )
+  {
+    const PlatformFeatures& features = selector.features();
+    pipelined = on && features.threads && features.cores > 1;
+    if ( !pipelined ) stepThread.reset();
+    syncAges();
+  }
+
+  const StepThread* pipeline() const { return pipelined ? stepThread.get() : nullptr; }
+
+  const char* engineName()
+  {
+    if ( mode ) {
+      planarName = mode->name();
+      return planarName.c_str();
+    }
+    if ( !planar ) return engine->name();
+    planarName = "hashlife 2^" + std::to_string( hashlife.stepLog2() );
+    return planarName.c_str();
+  }
+  double generation() const
+  {
+    if ( mode ) return double( mode->generation() );
+    return planar ? double( hashlife.generation() ) : generations;
+  }
+
+  // Milliseconds since the page started loading.
+  double constructed() const { return constructedAt; }
+  double firstFrame() const { return firstFrameAt; }
+
   void update( void )
   {
-    advanceSim( life );
-    advanceAge( age, life.first );
-    if (SDL_MUSTLOCK(screen)) SDL_LockSurface(screen);
-    drawScreen( screen, life.first, age );
-    if (SDL_MUSTLOCK(screen)) SDL_UnlockSurface(screen);
-    SDL_UpdateRect(screen, 0, 0, 0, 0); 
+    if ( mode ) {
+      updateMode();
+      return;
+    }
+    if ( planar ) {
+      updateHashLife();
+      return;
+    }
+    // Stepping ahead, the engine already holds this generation.
+    const bool ahead = stepsAhead();
+    if ( !ahead ) engine->advance();
+    ++generations;
+    checkMemory( generations );
+    if ( autoEngine ) {
+      const std::string best = selector.check( *engine );
+      if ( !best.empty() ) {
+        std::cout << "switching from " << engine->name() << " to " << best << " engine:";
+        for ( const auto& c : selector.lastCalibration() ) {
+          std::cout << " " << c.engine << " " << c.secondsPerGeneration * 1e3 << "ms";
+        }
+        std::cout << std::endl;
+        setEngine( best );
+      }
+    }
+    if ( ahead && stepsAhead() )
+    {
+      drawSteppingAhead();
+      if ( generations == 1 ) firstFrameAt = emscripten_get_now();
+      return;
+    }
+    drewAhead = false;
+    display.begin();
+    if ( agesPacked )
+    {
+      if ( !agesInline ) agePacked( *engine->previousBoard(), engine->grid() );
+      if ( engine->grid() != CellGrid::Square ) {
+        drawScreen( display, *engine->currentBoard(), agePlanes, engine->grid() );
+      }
+      else if ( const BlockBoard* blocks = engine->currentBlocks() ) {
+        drawScreen( display, *blocks, agePlanes );
+      }
+      else if ( const Occupancy* occupied = engine->currentOccupancy() ) {
+        drawScreen( display, *engine->currentBoard(), agePlanes, *occupied );
+      }
+      else {
+        drawScreen( display, *engine->currentBoard(), agePlanes );
+      }
+    }
+    else
+    {
+      const LifeBuffer& life = engine->cells();
+      advanceAge( age, life );
+      drawScreen( display, life, age, rowRenderer );
+    }
+    display.present();
+    if ( generations == 1 ) firstFrameAt = emscripten_get_now();
   }
 
   private:
-  LifeDBuffer life;
-  LifeBuffer age;
-  SDL_Surface *screen;
+
+  bool stepsAhead() const { return pipelined && engine->currentBoard() && engine->stepsOnAnyThread(); }
+
+  // Two stages: the step thread moves the engine to the next generation
+  // while this thread draws the one it holds now, so the screen runs a
+  // generation behind the engine.  The engine may overwrite any of its
+  // boards while stepping, so the drawing works off a copy, and ages it
+  // from the copy before, the same way the serial path ages from
+  // previousBoard().  Ages never go inside the engine (see syncAges), and
+  // nothing touches it from outside while it steps, since the step is
+  // always finished by the end of the frame.
+  void drawSteppingAhead()
+  {
+    if ( !stepThread ) stepThread.reset( new StepThread( [this]{ engine->advance(); } ));
+    std::swap( shown, shownBefore );
+    shown = *engine->currentBoard();
+    const CellGrid grid = engine->grid();
+    stepThread->start();
+
+    display.begin();
+    // The first frame shows what the serial path already aged.
+    if ( drewAhead ) agePacked( shownBefore, grid );
+    drewAhead = true;
+    drawScreen( display, shown, agePlanes, grid );
+    display.present();
+    stepThread->finish();
+  }
+
+  // Age the packed cells with a live neighbor in previous, the neighbors
+  // being the grid's.
+  void agePacked( const PackedBoard& previous, CellGrid grid )
+  {
+    if ( grid == CellGrid::Hex ) agePlanes.advanceHex( previous );
+    else agePlanes.advance( previous );
+  }
+
+  // A step of whatever took the board's place, drawn.
+  void updateMode()
+  {
+    mode->advance();
+    checkMemory( ++frames );
+    display.begin();
+    mode->draw( display );
+    display.present();
+  }
+
+  // One step of the size the controller picked, drawn from the tree.
+  void updateHashLife()
+  {
+    const double begin = emscripten_get_now();
+    hashlife.setStepLog2( hashlifeStep.stepLog2() );
+    hashlife.step();
+    hashlifeStep.frameDone(( emscripten_get_now() - begin ) / 1e3 );
+    checkMemory( ++frames );
+
+    display.begin();
+    if ( view.zoom >= 0 )
+    {
+      ageWindow( uint64_t( 1 ) << hashlife.stepLog2() );
+      drawScreen( display, *window, *windowAges, 1, 1u << view.zoom );
+    }
+    else
+    {
+      const Palette palette( screen );
+      renderHashLife( hashlife, view, palette.values, SDL_MapRGBA( screen->format, 0, 0, 0, 255 ),
+                      (Uint32*) screen->pixels, screen->pitch / sizeof( Uint32 ));
+      display.drew( 0, Y_SCREEN );
+    }
+    display.present();
+  }
+
+  // Keep the ages where the engine can update them cheaply: bit planes
+  // for the packed engines, the hash map for the hash engine.
+  void syncAges()
+  {
+    const bool packed = engine->currentBoard() != nullptr;
+    agesInline = !stepsAhead() && engine->trackAges( &agePlanes );
+    if ( !agesInline ) engine->trackAges( nullptr );
+    if ( packed == agesPacked ) return;
+    if ( packed )
+    {
+      agePlanes.load( age );
+      LifeBuffer().swap( age );
+    }
+    else
+    {
+      agePlanes.store( age );
+      agePlanes.clear();
+    }
+    agesPacked = packed;
+  }
+
+  // Ages only mean something cell by cell, so HashLife's are kept for
+  // the cells on screen, in a window a cell bigger all round so the edge
+  // cells see their neighbors.  A step of 2^k generations ages cells by
+  // 2^k, as if their neighborhood held in between.  Moving the view
+  // starts the ages over.
+  void ageWindow( uint64_t generations )
+  {
+    const unsigned across = (( X_SCREEN >> view.zoom ) + 2 + CELLS_PER_WORD - 1 ) / CELLS_PER_WORD * CELLS_PER_WORD;
+    const unsigned down = ( Y_SCREEN >> view.zoom ) + 2;
+    const int64_t left = view.left - 1;
+    const int64_t top = view.top - 1;
+    if ( !window || window->width() != across || window->height() != down ||
+         left != windowLeft || top != windowTop )
+    {
+      window.reset( new PackedBoard( across, down ));
+      windowAges.reset( new AgePlanes( across, down ));
+      hashlife.extract( left, top, *window );
+      windowBefore.reset( new PackedBoard( *window ));
+      windowLeft = left;
+      windowTop = top;
+    }
+    else
+    {
+      std::swap( window, windowBefore );
+      hashlife.extract( left, top, *window );
+    }
+    windowAges->advance( *windowBefore, generations );
+  }
+
+  // Every MEMORY_CHECK_INTERVAL frames or generations, trim the clients
+  // back under the limit.
+  void checkMemory( unsigned count )
+  {
+    if ( count % MEMORY_CHECK_INTERVAL == 0 && !budget.enforce() )
+    {
+      std::cout << "over the memory limit: " << budget.report() << std::endl;
+    }
+  }
+
+  // Hand over to mode, stepping instead of the board.
+  void startMode( PageMode* next )
+  {
+    mode.reset( next );
+    budget.attach( mode.get(), ENGINE_PRIORITY );
+  }
+
+  // Back to the board.  The mode's threads are gone once this returns.
+  void dropMode()
+  {
+    if ( mode ) budget.detach( mode.get() );
+    mode.reset();
+  }
+
+  // Threads for a mode, out of the same pthread pool as the engines', so
+  // the board's own extra threads go first.
+  unsigned freeThreads()
+  {
+    stepThread.reset();
+    if ( dynamic_cast< const ThreadedEngine* >( engine.get() )) {
+      autoEngine = false;
+      setEngine( "packed" );
+    }
+    const PlatformFeatures& features = selector.features();
+    return features.threads ? std::min( features.cores, 8u ) : 1;
+  }
+
+  // Engine caches go before the ages.
+  static constexpr unsigned ENGINE_PRIORITY = 0;
+  static constexpr unsigned AGE_PRIORITY = 1;
+  static constexpr unsigned MEMORY_CHECK_INTERVAL = 30;
+
+  // PIXEL_PER_GRID is 2^PIXEL_ZOOM.  Zoomed in past MAX_ZOOM a cell is
+  // bigger than the screen; MIN_ZOOM shows 2^40 cells across.
+  static constexpr int PIXEL_ZOOM = 1;
+  static constexpr int MIN_ZOOM = -30;
+  static constexpr int MAX_ZOOM = 8;
+  static_assert( PIXEL_PER_GRID == 1 << PIXEL_ZOOM, "PIXEL_ZOOM doesn't match PIXEL_PER_GRID" );
+
+  MemoryBudget budget;
+  std::unique_ptr< LifeEngine > engine;
+  EngineSelector selector;
+  bool autoEngine = true;
+  unsigned generations = 0;
+  double constructedAt = 0;
+  double firstFrameAt = 0;
+  LifeBuffer age;                   // For the hash engine
+  RowRenderer rowRenderer;
+  AgePlanes agePlanes{ X_GRID, Y_GRID };    // For the packed ones
+  bool agesPacked = false;
+  bool agesInline = false;          // The engine ages agePlanes itself
+  Display display;
+  SDL_Surface *screen;              // display's
+
+  bool pipelined = false;           // Step and draw on separate threads
+  bool drewAhead = false;           // Last frame was drawSteppingAhead's
+  PackedBoard shown{ X_GRID, Y_GRID };          // The generation being drawn
+  PackedBoard shownBefore{ X_GRID, Y_GRID };
+  std::unique_ptr< StepThread > stepThread;     // After engine, so it stops first
+
+  bool planar = false;
+  HashLife hashlife;
+  StepController hashlifeStep;
+  Viewport view;
+  std::unique_ptr< PackedBoard > window;       // On screen cells and ages
+  std::unique_ptr< PackedBoard > windowBefore;
+  std::unique_ptr< AgePlanes > windowAges;
+  int64_t windowLeft = 0;
+  int64_t windowTop = 0;
+  unsigned frames = 0;
+  std::string planarName;
+
+  std::unique_ptr< PageMode > mode;             // In place of the board when set
+  int voxelLayer = -1;                          // Projected
 };
 
 std::unique_ptr< LifeSingleton > singleton; 
 
+// Switch engines from javascript, e.g.
+// Module.ccall( 'setEngine', 'number', ['string'], ['hash'] )
+// This turns automatic engine selection off.
+extern "C" EMSCRIPTEN_KEEPALIVE int setEngine( const char* name )
+{
+  singleton->setAutoEngine( false );
+  return singleton->setEngine( name ) ? 1 : 0;
+}
+
+// Run the board under a life-like rule in B/S notation, e.g.
+// Module.ccall( 'setRule', 'number', ['string'], ['B36/S23'] )
+// On a kernel compiled for the rule where the build allows.  Turns
+// automatic engine selection off, since the other engines only run
+// B3/S23; setEngine goes back to them.  Returns 0 if the rule won't parse.
+extern "C" EMSCRIPTEN_KEEPALIVE int setRule( const char* text )
+{
+  LifeRule rule;
+  try {
+    rule = LifeRule::parse( text );
+  }
+  catch ( const std::invalid_argument& e ) {
+    std::cout << e.what() << std::endl;
+    return 0;
+  }
+  singleton->setAutoEngine( false );
+  singleton->setRule( rule );
+  return 1;
+}
+
+// Run the board as a hex grid, six neighbors a cell, under a rule in B/S
+// notation counting up to 6, e.g.
+// Module.ccall( 'setHexRule', 'number', ['string'], ['B2/S34'] )
+// Turns automatic engine selection off, the square engines play another
+// game; setEngine or setRule go back to them.  Returns 0 if the rule
+// won't parse or counts past 6.
+extern "C" EMSCRIPTEN_KEEPALIVE int setHexRule( const char* text )
+{
+  try {
+    singleton->setHexRule( LifeRule::parse( text ));
+  }
+  catch ( const std::invalid_argument& e ) {
+    std::cout << e.what() << std::endl;
+    return 0;
+  }
+  singleton->setAutoEngine( false );
+  return 1;
+}
+
+// Milliseconds a generation for the current rule's compiled kernel, its
+// circuit run a gate at a time, the bit sliced path and the lookup path,
+// e.g. "B36/S23 compiled 0.21ms circuit 0.35ms sliced 0.62ms lookup 9.8ms".
+extern "C" EMSCRIPTEN_KEEPALIVE const char* benchRule( int generations )
+{
+  static std::string report;
+  report = singleton->benchRule( unsigned( std::max( generations, 1 )));
+  return report.c_str();
+}
+
+// Run a 256^3 volume under a 3D rule in Bays' notation, survival then
+// birth ranges, from a random blob in the middle, e.g.
+// Module.ccall( 'setVoxelRule', 'number', ['string'], ['4555'] )
+// An empty rule goes back to the board.  Returns 0 if the rule won't
+// parse.
+extern "C" EMSCRIPTEN_KEEPALIVE int setVoxelRule( const char* text )
+{
+  if ( !*text ) {
+    singleton->setVoxels( nullptr );
+    return 1;
+  }
+  try {
+    const VoxelRule rule = VoxelRule::parse( text );
+    singleton->setVoxels( &rule );
+  }
+  catch ( const std::invalid_argument& e ) {
+    std::cout << e.what() << std::endl;
+    return 0;
+  }
+  return 1;
+}
+
+// Show layer z of the volume (0 to 255), or -1 for every layer projected
+// down the z axis, nearer voxels hiding farther ones.  Layers are colored
+// by neighbor count, the projection by depth.
+extern "C" EMSCRIPTEN_KEEPALIVE void setVoxelView( int z )
+{
+  singleton->setVoxelLayer( z );
+}
+
+// Run a Lenia world, cells valued 0 to 1 growing by how their ring of
+// neighbors radius cells out averages, from random patches, e.g.
+// Module.ccall( 'setLenia', 'number', ['number', 'number', 'number', 'number'], [13, 0.15, 0.015, 0.1] )
+// Radius 0 goes back to the board.  Past a radius of a few the ring is
+// convolved through an FFT.  Returns 0 if the radius doesn't fit.
+extern "C" EMSCRIPTEN_KEEPALIVE int setLenia( int radius, double mu, double sigma, double dt )
+{
+  if ( radius <= 0 ) {
+    singleton->setLenia( nullptr );
+    return 1;
+  }
+  LeniaParams params;
+  params.radius = unsigned( radius );
+  params.mu = float( mu );
+  params.sigma = float( sigma );
+  params.dt = float( dt );
+  try {
+    singleton->setLenia( &params );
+  }
+  catch ( const std::invalid_argument& e ) {
+    std::cout << e.what() << std::endl;
+    return 0;
+  }
+  return 1;
+}
+
+// Run the board on an unbounded plane with HashLife (1), or go back to
+// the torus (0).  The step grows to 2^k generations a frame while the
+// frame rate holds.
+extern "C" EMSCRIPTEN_KEEPALIVE void setHashLife( int on )
+{
+  singleton->setHashLife( on != 0 );
+}
+
+// What HashLife's step controller aims for.
+extern "C" EMSCRIPTEN_KEEPALIVE void setHashLifeTargets( double framesPerSecond, double generationsPerSecond )
+{
+  singleton->stepper().setTargets( framesPerSecond, generationsPerSecond );
+}
+
+// Center the HashLife view on cell x, y with 2^zoom pixels per cell,
+// negative zooms out; e.g. Module.ccall( 'setViewport', null,
+// ['number','number','number'], [0, 0, -6] )
+extern "C" EMSCRIPTEN_KEEPALIVE void setViewport( double x, double y, int zoom )
+{
+  singleton->setViewport( int64_t( x ), int64_t( y ), zoom );
+}
+
+// Turn automatic engine selection back on (1) or off (0).
+extern "C" EMSCRIPTEN_KEEPALIVE void setAutoEngine( int on )
+{
+  singleton->setAutoEngine( on != 0 );
+}
+
+// For the stats overlay in shell.html.
+extern "C" EMSCRIPTEN_KEEPALIVE const char* statsVariant()
+{
+  return GOL_VARIANT;
+}
+
+extern "C" EMSCRIPTEN_KEEPALIVE const char* statsEngine()
+{
+  return singleton->engineName();
+}
+
+extern "C" EMSCRIPTEN_KEEPALIVE double statsGeneration()
+{
+  return singleton->generation();
+}
+
+extern "C" EMSCRIPTEN_KEEPALIVE double statsConstructed()
+{
+  return singleton->constructed();
+}
+
+// 0 until the first frame is up.
+extern "C" EMSCRIPTEN_KEEPALIVE double statsFirstFrame()
+{
+  return singleton->firstFrame();
+}
+
+// Memory per subsystem, one line.
+extern "C" EMSCRIPTEN_KEEPALIVE const char* statsMemory()
+{
+  static std::string report;
+  report = singleton->memory().report();
+  return report.c_str();
+}
+
+// The most the engines and ages have held at once, in megabytes.
+extern "C" EMSCRIPTEN_KEEPALIVE double statsPeakMemory()
+{
+  return singleton->memory().peak() / 1048576.0;
+}
+
+// Cap what the engines and ages may hold, in megabytes.
+extern "C" EMSCRIPTEN_KEEPALIVE void setMemoryLimit( double megabytes )
+{
+  singleton->memory().setLimit( size_t( megabytes * 1048576.0 ));
+}
+
+// Step the next generation while drawing this one (1) or not (0).
+extern "C" EMSCRIPTEN_KEEPALIVE void setPipeline( int on )
+{
+  singleton->setPipelined( on != 0 );
+}
+
+// How often each stage of the pipeline waited on the other, e.g.
+// "step 20 stalls 31ms, draw 80 stalls 412ms, 100 frames".
+extern "C" EMSCRIPTEN_KEEPALIVE const char* statsPipeline()
+{
+  static std::string text;
+  const StepThread* pipeline = singleton->pipeline();
+  if ( !pipeline ) return "off";
+  auto stage = []( const char* name, const StepThread::Stalls& stalls ) {
+    return std::string( name ) + " " + std::to_string( stalls.count ) + " stalls " +
+           std::to_string( int( stalls.seconds * 1e3 )) + "ms";
+  };
+  text = stage( "step", pipeline->stepStalls() ) + ", " + stage( "draw", pipeline->callerStalls() ) + ", " +
+         std::to_string( pipeline->frames() ) + " frames";
+  return text.c_str();
+}
+
+// How long showing a frame takes, e.g. "texture 0.42ms 768 rows".
+extern "C" EMSCRIPTEN_KEEPALIVE const char* statsPresent()
+{
+  static std::string text;
+  const Display& display = singleton->screenDisplay();
+  text = std::string( display.path() ) + " " + std::to_string( display.presentMilliseconds() ) + "ms " +
+         std::to_string( display.rowsSent() ) + " rows";
+  return text.c_str();
+}
+
+// Milliseconds to show the current frame again, frames times over, e.g.
+// "texture 412 rows 0.21ms, 768 rows 0.38ms".  The texture build times
+// the rows present() sent and then every row; the surface build, e.g.
+// "surface 768 rows 0.52ms", always sends every row.  Run it in each
+// build on the same board to compare the two paths.
+extern "C" EMSCRIPTEN_KEEPALIVE const char* benchPresent( int frames )
+{
+  static std::string text;
+  Display& display = singleton->screenDisplay();
+  const unsigned times = unsigned( std::max( frames, 1 ));
+  const unsigned rows = display.rowsSent();
+  text = std::string( display.path() ) + " " + std::to_string( rows ) + " rows " +
+         std::to_string( display.timePresent( times, false )) + "ms";
+  if ( rows != unsigned( Y_SCREEN )) {
+    text += ", " + std::to_string( Y_SCREEN ) + " rows " + std::to_string( display.timePresent( times, true )) + "ms";
+  }
+  return text.c_str();
+}
+
 // Advance forward one.  Callback from emscripten
 void tick() {
   singleton->update(); 
 }
 
+#ifdef GOL_SDL2
+// One generation per display frame, paced by requestAnimationFrame.
+EM_BOOL animationFrame( double, void* )
+{
+  tick();
+  return EM_TRUE;
+}
+#endif
+
 int main(int argc, char** argv) 
 {
   srand(time( nullptr ));
   
   singleton = std::unique_ptr< LifeSingleton >( new LifeSingleton());
+#ifdef GOL_SDL2
+  emscripten_request_animation_frame_loop( animationFrame, nullptr );
+#else
   emscripten_set_main_loop(tick, 15000, 0);
+#endif
 
   return 0;
 }
@@ -0,0 +1,926 @@
+///
+/// Benchmarks the game of life engines on the native build.
+/// (C) Andrew Brownbill 2019
+///
+/// gol_bench [--suite NAME]... [--width W] [--height H] [--generations N]
+///           [--density PERCENT] [--seed S] [--max-threads T] [--halo K]...
+///           [--step K] [--cache-mb M] [--gc mark-sweep|lru|rebuild] [--perf]
+///           [--rule B3/S23] [--voxel-side N] [--voxel-rule 4555]
+///
+/// --perf adds cache and TLB misses per generation to every line, where
+/// the kernel lets us count them.
+/// --rule is for the rule suite, --voxel-side and --voxel-rule for the
+/// voxel suite.
+/// Every run is checked against advancePacked, mismatches are flagged.
+/// Rules other than B3/S23 are checked against the lookup path instead,
+/// hex life and voxels against a cell at a time step, Lenia's FFT
+/// convolution against the direct one.
+/// The age suite runs AgePlanes beside advanceAge on the page's board,
+/// past the point where ages saturate, and compares every cell.
+/// HashLife runs on an unbounded plane, so it's checked on a patch with
+/// an empty margin the pattern can't cross, under each --gc policy with
+/// a small cache, and its drawing against the window it draws, at zoom 0
+/// and zoomed out.
+///
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "hashlife.h"
+#include "hashlife_view.h"
+#include "age_planes.h"
+#include "block_board.h"
+#include "cell_render.h"
+#include "hex_life.h"
+#include "lenia.h"
+#include "life.h"
+#include "life_rule.h"
+#include "list_life.h"
+#include "lut_engine.h"
+#include "packed_board.h"
+#include "packed_simd.h"
+#include "parallel_engine.h"
+#include "occupancy.h"
+#include "perf_counters.h"
+#include "rule_kernel.h"
+#include "wavefront.h"
+#include "sorted_life.h"
+#include "voxel_life.h"
+
+// What to run and on what.
+class BenchOptions
+{
+  public:
+
+  unsigned width = 4096;
+  unsigned height = 4096;
+  unsigned generations = 100;
+  unsigned density = 35;      // 0 = glider guns
+  unsigned seed = 1;
+  unsigned maxThreads = 16;
+  std::vector< unsigned > halos;
+  std::vector< std::string > suites;
+  unsigned stepLog2 = 0;      // HashLife steps 2^stepLog2 generations
+  unsigned cacheMB = 256;
+  HashLife::GcPolicy gcPolicy = HashLife::GcPolicy::LruResults;
+  bool perf = false;
+  LifeRule rule;
+  unsigned voxelSide = 256;
+  VoxelRule voxelRule = VoxelRule::bays4555();
+};
+
+// Counts around every timed run when --perf is on.
+static std::unique_ptr< PerfCounters > counters;
+
+const std::vector< std::pair< std::string, HashLife::GcPolicy > > gcPolicies = {
+  { "mark-sweep", HashLife::GcPolicy::MarkSweep },
+  { "lru", HashLife::GcPolicy::LruResults },
+  { "rebuild", HashLife::GcPolicy::Rebuild },
+};
+
+static bool parseGcPolicy( const std::string& name, HashLife::GcPolicy& policy )
+{
+  for ( const auto& named : gcPolicies )
+  {
+    if ( named.first != name ) continue;
+    policy = named.second;
+    return true;
+  }
+  return false;
+}
+
+static PackedBoard startBoard( const BenchOptions& options )
+{
+  PackedBoard board( options.width, options.height );
+  if ( options.density ) fillRandom( board, options.density, options.seed );
+  else seedGliderGuns( board, options.seed );
+  return board;
+}
+
+static double seconds( const std::function< void() >& work )
+{
+  if ( counters ) counters->start();
+  const auto begin = std::chrono::steady_clock::now();
+  work();
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+  if ( counters ) counters->stop();
+  return elapsed.count();
+}
+
+// The counters from the last timed run, per runs.
+static void printCounters( unsigned runs, const char* per )
+{
+  if ( !counters ) return;
+  for ( unsigned i = 0; i < PerfCounters::COUNTERS; ++i )
+  {
+    const auto counter = PerfCounters::Counter( i );
+    if ( !counters->available( counter )) continue;
+    std::cout << "  " << PerfCounters::name( counter ) << " " << std::fixed << std::setprecision( 0 )
+              << double( counters->value( counter )) / runs << "/" << per;
+  }
+}
+
+static bool sameBoard( const PackedBoard& a, const PackedBoard& b )
+{
+  if ( a.width() != b.width() || a.height() != b.height() ) return false;
+  for ( unsigned y = 0; y < a.height(); ++y ) {
+    if ( std::memcmp( a.row( y ), b.row( y ), a.wordsPerRow() * sizeof( uint64_t ))) return false;
+  }
+  return true;
+}
+
+// Everything a suite needs.
+class BenchContext
+{
+  public:
+
+  BenchContext( const BenchOptions& opts ) :
+    options( opts ), start( startBoard( opts )), expected( start )
+  {
+    PackedBoard other( start.width(), start.height() );
+    for ( unsigned i = 0; i < options.generations; ++i )
+    {
+      advancePacked( expected, other );
+      std::swap( expected, other );
+    }
+  }
+
+  void report( const std::string& suite, const std::string& config, double time,
+               const PackedBoard& result ) const
+  {
+    report( suite, config, time, result, expected );
+  }
+
+  void report( const std::string& suite, const std::string& config, double time,
+               const PackedBoard& result, const PackedBoard& reference ) const
+  {
+    const double cells = double( options.width ) * options.height * options.generations;
+    std::cout << std::left << std::setw( 10 ) << suite << std::setw( 24 ) << config
+              << std::right << std::setw( 12 ) << std::fixed << std::setprecision( 1 )
+              << options.generations / time << " gen/s "
+              << std::setw( 10 ) << std::setprecision( 3 ) << cells / time / 1e9 << " Gcell/s"
+              << ( sameBoard( result, reference ) ? "" : "  MISMATCH" );
+    printCounters( options.generations, "gen" );
+    std::cout << "\n";
+  }
+
+  const BenchOptions& options;
+  const PackedBoard start;
+  PackedBoard expected;
+};
+
+// The original hash map engine.  Only runs on the web page's board size.
+static void benchHash( const BenchContext& context )
+{
+  if ( context.options.width != unsigned( X_GRID ) || context.options.height != unsigned( Y_GRID ))
+  {
+    std::cout << "hash      skipped, needs --width " << X_GRID << " --height " << Y_GRID << "\n";
+    return;
+  }
+  LifeDBuffer life;
+  context.start.store( life.first );
+  const double time = seconds( [&]{
+    for ( unsigned i = 0; i < context.options.generations; ++i ) advanceSim( life );
+  });
+  PackedBoard result( context.options.width, context.options.height );
+  result.load( life.first );
+  context.report( "hash", "advanceSim", time, result );
+}
+
+static void benchPacked( const BenchContext& context )
+{
+  PackedBoard board = context.start;
+  PackedBoard other( board.width(), board.height() );
+  const double time = seconds( [&]{
+    for ( unsigned i = 0; i < context.options.generations; ++i )
+    {
+      advancePacked( board, other );
+      std::swap( board, other );
+    }
+  });
+  context.report( "packed", "advancePacked", time, board );
+}
+
+// Drawing the hash engine's cells and ages, a frame per generation asked
+// for: in hash map order as the page used to, and binned by row.  Boards
+// bigger than the page get a pixel per cell.
+static void benchRender( const BenchContext& context )
+{
+  const unsigned width = context.options.width, height = context.options.height;
+  const unsigned ppc = ( width <= unsigned( X_GRID ) && height <= unsigned( Y_GRID )) ? PIXEL_PER_GRID : 1;
+  PackedBoard next( width, height );
+  advancePacked( context.start, next );
+  LifeBuffer cells, ages;
+  storeNeighborhood( context.start, next, cells );
+  advanceAge( ages, cells );
+
+  std::vector< uint32_t > colors( AGE_BUCKETS );
+  for ( unsigned i = 0; i < AGE_BUCKETS; ++i ) colors[ i ] = 0xff000000u | i * 0x010101u;
+  std::vector< uint32_t > before( size_t( width ) * ppc * height * ppc );
+  std::vector< uint32_t > after( before.size() );
+  const CellView beforeView{ width, height, ppc, before.data(), width * ppc };
+  const CellView afterView{ width, height, ppc, after.data(), width * ppc };
+
+  RowRenderer renderer;
+  const unsigned frames = context.options.generations;
+  auto line = [&]( const char* config, double time ) {
+    std::cout << std::left << std::setw( 10 ) << "render" << std::setw( 24 ) << config
+              << std::right << std::setw( 12 ) << std::fixed << std::setprecision( 1 )
+              << frames / time << " frame/s";
+    printCounters( frames, "frame" );
+  };
+  line( "hash map order", seconds( [&]{
+    for ( unsigned i = 0; i < frames; ++i ) renderCellsUnordered( cells, ages, colors, 0, beforeView );
+  }));
+  std::cout << "\n";
+  line( "row bins", seconds( [&]{
+    for ( unsigned i = 0; i < frames; ++i ) renderer.render( cells, ages, colors, 0, afterView );
+  }));
+  std::cout << ( before == after ? "" : "  MISMATCH" ) << "\n";
+}
+
+// AgePlanes beside the hash path, advanceSim and advanceAge, on the page's
+// board since advanceSim wraps there.  The hash path runs alone for the
+// first CARRY generations, then its ages go into the planes with load()
+// and both step on, long enough that the oldest cells pass MAX_AGE and
+// the planes saturate.  Every cell's age and bucket must agree.
+static void benchAge( const BenchContext& context )
+{
+  constexpr unsigned CARRY = 100;
+  constexpr unsigned GENERATIONS = 4300;
+  static_assert( GENERATIONS > CARRY + AgePlanes::MAX_AGE, "too short to reach saturation" );
+
+  const BenchOptions& options = context.options;
+  PackedBoard board( X_GRID, Y_GRID ), other( X_GRID, Y_GRID );
+  if ( options.density ) fillRandom( board, options.density, options.seed );
+  else seedGliderGuns( board, options.seed );
+
+  LifeDBuffer life;
+  LifeBuffer ages;
+  board.store( life.first );
+  for ( unsigned i = 0; i < CARRY; ++i )
+  {
+    advanceSim( life );
+    advanceAge( ages, life.first );
+    advancePacked( board, other );
+    std::swap( board, other );
+  }
+
+  AgePlanes planes( X_GRID, Y_GRID );
+  planes.load( ages );
+  double time = 0;       // The planes alone, so no counters
+  for ( unsigned i = CARRY; i < GENERATIONS; ++i )
+  {
+    advanceSim( life );
+    advanceAge( ages, life.first );
+    advancePacked( board, other );
+    time += seconds( [&]{ planes.advance( board ); } );
+    std::swap( board, other );
+  }
+
+  bool same = true;
+  unsigned saturated = 0;
+  for ( unsigned y = 0; y < unsigned( Y_GRID ); ++y ) {
+    for ( unsigned x = 0; x < unsigned( X_GRID ); ++x )
+    {
+      const auto found = ages.find( LifeCoord( x, y ));
+      const unsigned age = std::min( found == ages.end() ? 0u : found->second.value, AgePlanes::MAX_AGE );
+      same = same && planes.age( x, y ) == age &&
+             planes.bucket( x, y ) == std::min( age / AGE_RATE, AGE_BUCKETS - 1 );
+      saturated += age == AgePlanes::MAX_AGE;
+    }
+  }
+  const unsigned planeGenerations = GENERATIONS - CARRY;
+  std::cout << std::left << std::setw( 10 ) << "age" << std::setw( 24 ) << "planes vs advanceAge"
+            << std::right << std::setw( 12 ) << std::fixed << std::setprecision( 1 )
+            << planeGenerations / time << " gen/s  " << GENERATIONS << " generations  saturated "
+            << saturated << ( same ? "" : "  MISMATCH" ) << "\n";
+}
+
+// Only the words next to live ones, through the summary bitmaps.
+static void benchOccupied( const BenchContext& context )
+{
+  const unsigned width = context.options.width, height = context.options.height;
+  PackedBoard board = context.start;
+  PackedBoard other( width, height );
+  Occupancy map( width, height ), otherMap( width, height ), near( width, height );
+  map.rebuild( board );
+  const double time = seconds( [&]{
+    for ( unsigned i = 0; i < context.options.generations; ++i )
+    {
+      advanceOccupied( board, map, other, otherMap, near );
+      std::swap( board, other );
+      std::swap( map, otherMap );
+    }
+  });
+  context.report( "occupied", "advanceOccupied", time, board );
+}
+
+// One board and three rows of scratch, against advancePacked's two boards.
+static void benchInPlace( const BenchContext& context )
+{
+  PackedBoard board = context.start;
+  std::vector< uint64_t > rows;
+  const double time = seconds( [&]{
+    for ( unsigned i = 0; i < context.options.generations; ++i ) advancePackedInPlace( board, rows );
+  });
+  const size_t bytes = board.memoryUsed() + rows.capacity() * sizeof( uint64_t );
+  std::ostringstream config;
+  config << std::fixed << std::setprecision( 1 ) << bytes / 1048576.0 << "MB, packed "
+         << 2 * board.memoryUsed() / 1048576.0 << "MB";
+  context.report( "inplace", config.str(), time, board );
+}
+
+// Temporal blocking, depth generations a pass, against advancePacked's
+// one.  Shows up once the board is well past the L2 cache.
+static void benchWavefront( const BenchContext& context )
+{
+  for ( unsigned depth : { 2u, 4u, 8u, 16u } )
+  {
+    Wavefront wavefront( context.options.width, context.options.height, depth );
+    PackedBoard board = context.start;
+    PackedBoard other( board.width(), board.height() );
+    const double time = seconds( [&]{
+      for ( unsigned done = 0; done < context.options.generations; done += depth )
+      {
+        wavefront.advance( board, other, std::min( depth, context.options.generations - done ));
+        std::swap( board, other );
+      }
+    });
+    context.report( "wavefront", "depth " + std::to_string( depth ), time, board );
+  }
+}
+
+static void benchSimd( const BenchContext& context )
+{
+  PackedBoard board = context.start;
+  PackedBoard other( board.width(), board.height() );
+  const double time = seconds( [&]{
+    for ( unsigned i = 0; i < context.options.generations; ++i )
+    {
+      advancePackedSimd( board, other );
+      std::swap( board, other );
+    }
+  });
+  context.report( "simd", "advancePackedSimd", time, board );
+}
+
+static void benchLut( const BenchContext& context )
+{
+  PackedBoard board = context.start;
+  PackedBoard other( board.width(), board.height() );
+  blockTable();
+  const double time = seconds( [&]{
+    for ( unsigned i = 0; i < context.options.generations; ++i )
+    {
+      advanceLut( board, other );
+      std::swap( board, other );
+    }
+  });
+  context.report( "lut", "advanceLut", time, board );
+}
+
+// --rule with the generic lookup path, bit sliced with the rule looped
+// over per word, and the rule's circuit run a gate at a time.  The page
+// also runs a kernel compiled from the circuit at run time;
+// rule_check.js times that one under node.
+static void benchRule( const BenchContext& context )
+{
+  const LifeRule& rule = context.options.rule;
+  auto run = [&]( const std::function< void( const PackedBoard&, PackedBoard& ) >& step, PackedBoard& board ) {
+    board = context.start;
+    PackedBoard other( board.width(), board.height() );
+    return seconds( [&]{
+      for ( unsigned i = 0; i < context.options.generations; ++i )
+      {
+        step( board, other );
+        std::swap( board, other );
+      }
+    });
+  };
+  PackedBoard looked( context.start ), sliced( context.start ), circuited( context.start );
+  const double lookupTime = run( [&]( const PackedBoard& src, PackedBoard& dst ) {
+    advanceRuleLookup( src, dst, rule );
+  }, looked );
+  const double slicedTime = run( [&]( const PackedBoard& src, PackedBoard& dst ) {
+    advanceRule( src, dst, rule );
+  }, sliced );
+  const RuleCircuit circuit = RuleCircuit::synthesize( rule );
+  const double circuitTime = run( [&]( const PackedBoard& src, PackedBoard& dst ) {
+    advanceCircuit( src, dst, circuit );
+  }, circuited );
+  const PackedBoard& reference = rule == LifeRule::conway() ? context.expected : looked;
+  context.report( "rule", rule.toString() + " lookup", lookupTime, looked, reference );
+  context.report( "rule", rule.toString() + " sliced", slicedTime, sliced, reference );
+  context.report( "rule", rule.toString() + " circuit " + std::to_string( circuit.gates().size() ) + " gates",
+                  circuitTime, circuited, reference );
+}
+
+// One hex generation a cell at a time, get() and set() on the offset
+// rows, to check advanceHex against.
+static void stepHexByCell( const PackedBoard& src, PackedBoard& dst, const LifeRule& rule )
+{
+  const int width = int( src.width() );
+  const int height = int( src.height() );
+  for ( int y = 0; y < height; ++y ) {
+    for ( int x = 0; x < width; ++x )
+    {
+      const int side = y % 2 ? 1 : -1;         // Odd rows sit half a cell right
+      const int neighbors[ 6 ][ 2 ] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { side, -1 }, { 0, 1 }, { side, 1 } };
+      unsigned count = 0;
+      for ( const auto& d : neighbors ) {
+        count += src.get( unsigned(( x + d[0] + width ) % width ), unsigned(( y + d[1] + height ) % height ));
+      }
+      dst.set( unsigned( x ), unsigned( y ), rule.next( src.get( unsigned( x ), unsigned( y )), count ));
+    }
+  }
+}
+
+// Hexagonal life, B2/S34, on the start board as a hex grid.
+static void benchHex( const BenchContext& context )
+{
+  if ( context.options.height % 2 )
+  {
+    std::cout << "hex       skipped, needs an even --height\n";
+    return;
+  }
+  const LifeRule rule = hexLife();
+  const unsigned width = context.options.width, height = context.options.height;
+  PackedBoard board( context.start ), other( width, height );
+  const double time = seconds( [&]{
+    for ( unsigned i = 0; i < context.options.generations; ++i )
+    {
+      advanceHex( board, other, rule );
+      std::swap( board, other );
+    }
+  });
+  PackedBoard reference( context.start ), scratch( width, height );
+  for ( unsigned i = 0; i < context.options.generations; ++i )
+  {
+    stepHexByCell( reference, scratch, rule );
+    std::swap( reference, scratch );
+  }
+  context.report( "hex", rule.toString(), time, board, reference );
+}
+
+// One voxel generation a cell at a time, to check advanceVoxels against.
+static void stepVoxelsByCell( const VoxelBoard& src, VoxelBoard& dst, const VoxelRule& rule )
+{
+  const int width = int( src.width() ), height = int( src.height() ), depth = int( src.depth() );
+  for ( int z = 0; z < depth; ++z ) {
+    for ( int y = 0; y < height; ++y ) {
+      for ( int x = 0; x < width; ++x )
+      {
+        unsigned count = 0;
+        for ( int dz = -1; dz <= 1; ++dz ) {
+          for ( int dy = -1; dy <= 1; ++dy ) {
+            for ( int dx = -1; dx <= 1; ++dx ) {
+              if ( dx || dy || dz ) {
+                count += src.get( unsigned(( x + dx + width ) % width ), unsigned(( y + dy + height ) % height ),
+                                  unsigned(( z + dz + depth ) % depth ));
+              }
+            }
+          }
+        }
+        dst.set( unsigned( x ), unsigned( y ), unsigned( z ), rule.next( src.get( unsigned( x ), unsigned( y ), unsigned( z )), count ));
+      }
+    }
+  }
+}
+
+static bool sameVolume( const VoxelBoard& a, const VoxelBoard& b )
+{
+  for ( unsigned z = 0; z < a.depth(); ++z ) {
+    if ( std::memcmp( a.row( 0, z ), b.row( 0, z ), size_t( a.wordsPerRow() ) * a.height() * sizeof( uint64_t ))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// --voxel-rule on a --voxel-side cube, from a blob a quarter of the side
+// across at --density, on 1 to --max-threads threads.  Checked against a
+// cell at a time step on a 64^3 cube first, then each run against the
+// one thread run.
+static void benchVoxels( const BenchContext& context )
+{
+  const BenchOptions& options = context.options;
+  const VoxelRule& rule = options.voxelRule;
+  const unsigned percent = options.density ? options.density : 30;
+  auto line = [&]( const std::string& config, double time, unsigned side, unsigned generations, bool same ) {
+    const double cells = double( side ) * side * side * generations;
+    std::cout << std::left << std::setw( 10 ) << "voxel" << std::setw( 24 ) << config
+              << std::right << std::setw( 12 ) << std::fixed << std::setprecision( 1 ) << generations / time
+              << " gen/s " << std::setw( 10 ) << std::setprecision( 3 ) << cells / time / 1e9 << " Gcell/s"
+              << ( same ? "" : "  MISMATCH" );
+    printCounters( generations, "gen" );
+    std::cout << "\n";
+  };
+
+  {
+    constexpr unsigned SIDE = 64, GENERATIONS = 10;
+    VoxelBoard board( SIDE, SIDE, SIDE ), other( SIDE, SIDE, SIDE );
+    seedCube( board, SIDE / 2, percent, options.seed );
+    VoxelBoard reference( board ), scratch( other );
+    const double time = seconds( [&]{
+      for ( unsigned i = 0; i < GENERATIONS; ++i )
+      {
+        advanceVoxels( board, other, rule, 0, SIDE );
+        std::swap( board, other );
+      }
+    });
+    for ( unsigned i = 0; i < GENERATIONS; ++i )
+    {
+      stepVoxelsByCell( reference, scratch, rule );
+      std::swap( reference, scratch );
+    }
+    line( rule.toString() + " check 64^3", time, SIDE, GENERATIONS, sameVolume( board, reference ));
+  }
+
+  const unsigned side = options.voxelSide;
+  std::unique_ptr< VoxelBoard > single;
+  for ( unsigned threads = 1; threads <= options.maxThreads; threads *= 2 )
+  {
+    VoxelLife life( side, side, side, rule, threads );
+    seedCube( life.board(), side / 4, percent, options.seed );
+    const double time = seconds( [&]{
+      for ( unsigned i = 0; i < options.generations; ++i ) life.advance();
+    });
+    if ( !single ) single.reset( new VoxelBoard( life.board() ));
+    line( rule.toString() + " threads " + std::to_string( life.threads() ), time, side, options.generations,
+          sameVolume( life.board(), *single ));
+  }
+}
+
+// Lenia on the page's world, from the page's patches, convolving through
+// the FFT and directly at growing radii on one thread, to find where the
+// FFT starts winning; Lenia::DIRECT_MAX_RADIUS should sit just under it.
+// The two must agree to within float rounding.  Then the FFT at the
+// default radius on 1 to --max-threads threads.  Capped at 10
+// generations, the direct runs get slow.
+static void benchLenia( const BenchContext& context )
+{
+  const BenchOptions& options = context.options;
+  const unsigned generations = std::min( options.generations, 10u );
+  const unsigned seed = options.seed;
+  auto line = [&]( const std::string& config, double time, bool same ) {
+    const double cells = double( X_GRID ) * Y_GRID * generations;
+    std::cout << std::left << std::setw( 10 ) << "lenia" << std::setw( 24 ) << config
+              << std::right << std::setw( 12 ) << std::fixed << std::setprecision( 1 ) << generations / time
+              << " gen/s " << std::setw( 10 ) << std::setprecision( 3 ) << cells / time / 1e9 << " Gcell/s"
+              << ( same ? "" : "  MISMATCH" );
+    printCounters( generations, "gen" );
+    std::cout << "\n";
+  };
+  auto run = [&]( Lenia& lenia ) {
+    lenia.seedPatches( 12, seed );
+    return seconds( [&]{
+      for ( unsigned i = 0; i < generations; ++i ) lenia.advance();
+    });
+  };
+
+  unsigned crossover = 0;
+  for ( unsigned radius : { 2u, 3u, 4u, 5u, 6u, 8u, 12u, 16u, 24u, 32u } )
+  {
+    LeniaParams params;
+    params.radius = radius;
+    Lenia fft( X_GRID, Y_GRID, params, 1, Convolution::Fft );
+    Lenia direct( X_GRID, Y_GRID, params, 1, Convolution::Direct );
+    const double fftTime = run( fft );
+    const double directTime = run( direct );
+    float difference = 0;
+    for ( unsigned y = 0; y < Y_GRID; ++y ) {
+      for ( unsigned x = 0; x < X_GRID; ++x ) difference = std::max( difference, std::fabs( fft.row( y )[x] - direct.row( y )[x] ));
+    }
+    const bool same = difference < 1e-3f;
+    line( "R" + std::to_string( radius ) + " fft", fftTime, same );
+    line( "R" + std::to_string( radius ) + " direct", directTime, same );
+    if ( !crossover && fftTime < directTime ) crossover = radius;
+  }
+  std::cout << "lenia     fft wins from R" << crossover << ", direct up to R" << Lenia::DIRECT_MAX_RADIUS << " on auto\n";
+
+  std::unique_ptr< Lenia > single;
+  for ( unsigned threads = 1; threads <= options.maxThreads; threads *= 2 )
+  {
+    std::unique_ptr< Lenia > lenia( new Lenia( X_GRID, Y_GRID, LeniaParams(), threads, Convolution::Fft ));
+    const double time = run( *lenia );
+    bool same = true;
+    if ( single ) {
+      for ( unsigned y = 0; y < Y_GRID; ++y ) {
+        same = same && !std::memcmp( lenia->row( y ), single->row( y ), X_GRID * sizeof( float ));
+      }
+    }
+    line( "R13 fft threads " + std::to_string( lenia->threads() ), time, same );
+    if ( !single ) single = std::move( lenia );
+  }
+}
+
+static void benchSorted( const BenchContext& context )
+{
+  SortedLife life( context.options.width, context.options.height );
+  life.load( context.start );
+  const double time = seconds( [&]{
+    for ( unsigned i = 0; i < context.options.generations; ++i ) life.advance();
+  });
+  PackedBoard result( context.options.width, context.options.height );
+  life.store( result );
+  context.report( "sorted", "radix sorted keys", time, result );
+}
+
+static void benchList( const BenchContext& context )
+{
+  ListLife life( context.options.width, context.options.height );
+  life.load( context.start );
+  const double time = seconds( [&]{
+    for ( unsigned i = 0; i < context.options.generations; ++i ) life.advance();
+  });
+  PackedBoard result( context.options.width, context.options.height );
+  life.store( result );
+  std::ostringstream config;
+  config << "row lists " << std::fixed << std::setprecision( 1 )
+         << double( life.memoryUsed() ) / std::max< size_t >( life.population(), 1 ) << "B/cell";
+  context.report( "list", config.str(), time, result );
+}
+
+// 8x8 blocks, a row of blocks at a time or in Morton order, on small or
+// huge pages.  With --perf the dtlb-miss column shows what the curve and
+// the huge pages save on big boards.
+static void benchBlock( const BenchContext& context )
+{
+  if ( context.options.height % BLOCK_SIDE )
+  {
+    std::cout << "block     skipped, needs multiples of " << BLOCK_SIDE << " for --height\n";
+    return;
+  }
+  for ( auto layout : { BlockBoard::Layout::RowMajor, BlockBoard::Layout::Morton } ) {
+    for ( bool huge : { false, true } )
+    {
+      BlockBoard board( context.options.width, context.options.height, layout, huge );
+      BlockBoard other( context.options.width, context.options.height, layout, huge );
+      board.load( context.start );
+      const double time = seconds( [&]{
+        for ( unsigned i = 0; i < context.options.generations; ++i )
+        {
+          advanceBlocks( board, other );
+          std::swap( board, other );
+        }
+      });
+      PackedBoard result( context.options.width, context.options.height );
+      board.store( result );
+      const std::string config = std::string( layout == BlockBoard::Layout::Morton ? "morton" : "rows" ) +
+                                 ( board.usingHugePages() ? " 2M pages" : " 4K pages" );
+      context.report( "block", config, time, result );
+    }
+  }
+}
+
+// Thread scaling for each halo width.
+static void benchParallel( const BenchContext& context )
+{
+  std::vector< unsigned > halos = context.options.halos;
+  if ( halos.empty() ) halos = { 1, 2, 4, 8 };
+  for ( unsigned halo : halos )
+  {
+    for ( unsigned threads = 1; threads <= context.options.maxThreads; threads *= 2 )
+    {
+      if ( context.options.height / threads < halo ) continue;
+      ParallelEngine engine( context.options.width, context.options.height, threads, halo );
+      engine.load( context.start );
+      const double time = seconds( [&]{ engine.advance( context.options.generations ); } );
+      PackedBoard result( context.options.width, context.options.height );
+      engine.store( result );
+      context.report( "parallel", "threads " + std::to_string( threads ) +
+                      " halo " + std::to_string( halo ), time, result );
+    }
+  }
+}
+
+// HashLife on the plane against advancePacked on a torus with an empty
+// margin wider than the pattern can grow in the generations run, so
+// neither edge is ever reached and the two must agree.  A 256x256 patch
+// of the start pattern, stepped 2^stepLog2 at a time under each
+// collection policy with a cache small enough that collections run
+// every few steps.
+static void checkHashLife( const BenchOptions& options )
+{
+  constexpr unsigned PATCH = 256;
+  constexpr size_t CACHE_BYTES = 256 << 10;
+  const uint64_t steps = std::max< uint64_t >( 1, std::min( options.generations, 256u ) >> options.stepLog2 );
+  const unsigned generations = unsigned( steps << options.stepLog2 );
+  // Rounded so the board stays a whole number of words across.
+  const unsigned margin = ( generations + CELLS_PER_WORD / 2 ) / ( CELLS_PER_WORD / 2 ) * ( CELLS_PER_WORD / 2 );
+
+  PackedBoard patch( PATCH, PATCH );
+  if ( options.density ) fillRandom( patch, options.density, options.seed );
+  else seedGliderGuns( patch, options.seed );
+  PackedBoard expected( PATCH + 2 * margin, PATCH + 2 * margin ), other( expected.width(), expected.height() );
+  for ( unsigned y = 0; y < PATCH; ++y ) {
+    for ( unsigned x = 0; x < PATCH; ++x ) expected.set( x + margin, y + margin, patch.get( x, y ));
+  }
+  const PackedBoard start( expected );
+  for ( unsigned i = 0; i < generations; ++i )
+  {
+    advancePacked( expected, other );
+    std::swap( expected, other );
+  }
+
+  for ( const auto& named : gcPolicies )
+  {
+    HashLife life;
+    life.setMemoryLimit( CACHE_BYTES );
+    life.setGcPolicy( named.second );
+    life.setStepLog2( options.stepLog2 );
+    life.load( start, 0, 0 );
+    for ( uint64_t i = 0; i < steps; ++i ) life.step();
+    PackedBoard result( start.width(), start.height() );
+    life.extract( 0, 0, result );
+    std::cout << std::left << std::setw( 10 ) << "hashlife" << std::setw( 24 )
+              << ( "check " + named.first + " 256KB" ) << std::right << "  " << generations
+              << " generations  gc " << life.stats().collections
+              << ( sameBoard( result, expected ) && life.generation() == generations ? "" : "  MISMATCH" ) << "\n";
+  }
+}
+
+// renderHashLife against the window it shows, extracted to a packed
+// board.  At zoom 0 that's drawn the way the page draws the hash map
+// engine, a pixel per cell through renderCellsUnordered.  Zoomed out
+// there's nothing to draw a packed board with, so each pixel's block of
+// cells is counted and colored as renderHashLife documents.
+static void checkHashLifeRender( const HashLife& life )
+{
+  std::vector< uint32_t > colors( AGE_BUCKETS );
+  for ( unsigned i = 0; i < AGE_BUCKETS; ++i ) colors[ i ] = 0xff000000u | i * 0x010101u;
+  const uint32_t background = 0xff0000ffu;
+  std::vector< uint32_t > pixels( size_t( X_SCREEN ) * Y_SCREEN ), expected( pixels.size() );
+
+  for ( int zoom : { 0, -2 } )
+  {
+    // Block aligned, so no node straddles a pixel.
+    const unsigned block = 1u << -zoom;
+    const Viewport view{ -int64_t( X_SCREEN / 2 * block ), -int64_t( Y_SCREEN / 2 * block ), zoom,
+                         unsigned( X_SCREEN ), unsigned( Y_SCREEN ) };
+    const double time = seconds( [&]{
+      renderHashLife( life, view, colors, background, pixels.data(), X_SCREEN );
+    });
+
+    PackedBoard window( X_SCREEN * block, Y_SCREEN * block );
+    life.extract( view.left, view.top, window );
+    if ( zoom == 0 )
+    {
+      LifeBuffer cells, ages;
+      window.store( cells );
+      for ( const auto& cell : cells ) ages[ cell.first ].value = 0;
+      renderCellsUnordered( cells, ages, colors, background,
+                            CellView{ unsigned( X_SCREEN ), unsigned( Y_SCREEN ), 1, expected.data(), X_SCREEN } );
+    }
+    else
+    {
+      const double full = double( block ) * block;
+      for ( unsigned py = 0; py < unsigned( Y_SCREEN ); ++py ) {
+        for ( unsigned px = 0; px < unsigned( X_SCREEN ); ++px )
+        {
+          uint64_t population = 0;
+          for ( unsigned y = 0; y < block; ++y ) {
+            for ( unsigned x = 0; x < block; ++x ) population += window.get( px * block + x, py * block + y );
+          }
+          expected[ size_t( py ) * X_SCREEN + px ] = population == 0 ? background :
+            colors[ size_t(( colors.size() - 1 ) * ( population - 1 ) / ( full - 1 )) ];
+        }
+      }
+    }
+    std::cout << std::left << std::setw( 10 ) << "hashlife" << std::setw( 24 )
+              << ( "render zoom " + std::to_string( zoom )) << std::right << std::setw( 12 )
+              << std::fixed << std::setprecision( 1 ) << 1 / time << " frame/s"
+              << ( pixels == expected ? "" : "  MISMATCH" );
+    printCounters( 1, "frame" );
+    std::cout << "\n";
+  }
+}
+
+// The start board centered on the plane, in steps of 2^stepLog2
+// generations, with the node cache held to cacheMB.  Checked first by
+// checkHashLife, and the result drawn by checkHashLifeRender.
+static void benchHashLife( const BenchContext& context )
+{
+  checkHashLife( context.options );
+
+  const BenchOptions& options = context.options;
+  HashLife life;
+  life.setMemoryLimit( size_t( options.cacheMB ) << 20 );
+  life.setGcPolicy( options.gcPolicy );
+  life.setStepLog2( options.stepLog2 );
+  life.load( context.start, -int64_t( options.width / 2 ), -int64_t( options.height / 2 ));
+
+  const uint64_t steps = std::max< uint64_t >( 1, options.generations >> options.stepLog2 );
+  const double time = seconds( [&]{
+    for ( uint64_t i = 0; i < steps; ++i ) life.step();
+  });
+
+  std::string policy;
+  for ( const auto& named : gcPolicies ) {
+    if ( named.second == options.gcPolicy ) policy = named.first;
+  }
+  const HashLife::Stats& stats = life.stats();
+  std::cout << std::left << std::setw( 10 ) << "hashlife" << std::setw( 24 )
+            << ( "step 2^" + std::to_string( options.stepLog2 ) + " " + policy )
+            << std::right << std::setw( 12 ) << std::fixed << std::setprecision( 1 )
+            << life.generation() / time << " gen/s  population " << life.population()
+            << "  nodes " << stats.nodes << " (" << std::setprecision( 1 )
+            << stats.bytes / 1048576.0 << "MB)  hits " << std::setprecision( 1 )
+            << 100 * stats.hitRate() << "%  gc " << stats.collections << " freed "
+            << stats.freedNodes << " pause max " << std::setprecision( 2 ) << stats.maxPauseMs
+            << "ms total " << stats.totalPauseMs << "ms\n";
+  checkHashLifeRender( life );
+}
+
+// Name to suite.
+const std::vector< std::pair< std::string, std::function< void( const BenchContext& ) > > > suites = {
+  { "hash", benchHash },
+  { "packed", benchPacked },
+  { "simd", benchSimd },
+  { "lut", benchLut },
+  { "rule", benchRule },
+  { "hex", benchHex },
+  { "voxel", benchVoxels },
+  { "lenia", benchLenia },
+  { "inplace", benchInPlace },
+  { "occupied", benchOccupied },
+  { "render", benchRender },
+  { "age", benchAge },
+  { "block", benchBlock },
+  { "wavefront", benchWavefront },
+  { "sorted", benchSorted },
+  { "list", benchList },
+  { "parallel", benchParallel },
+  { "hashlife", benchHashLife },
+};
+
+int main( int argc, char** argv )
+{
+  BenchOptions options;
+  for ( int i = 1; i < argc; ++i )
+  {
+    const std::string arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+    if ( arg == "--suite" && hasValue ) options.suites.push_back( argv[++i] );
+    else if ( arg == "--width" && hasValue ) options.width = std::stoul( argv[++i] );
+    else if ( arg == "--height" && hasValue ) options.height = std::stoul( argv[++i] );
+    else if ( arg == "--generations" && hasValue ) options.generations = std::stoul( argv[++i] );
+    else if ( arg == "--density" && hasValue ) options.density = std::stoul( argv[++i] );
+    else if ( arg == "--seed" && hasValue ) options.seed = std::stoul( argv[++i] );
+    else if ( arg == "--max-threads" && hasValue ) options.maxThreads = std::stoul( argv[++i] );
+    else if ( arg == "--halo" && hasValue ) options.halos.push_back( std::stoul( argv[++i] ));
+    else if ( arg == "--step" && hasValue ) options.stepLog2 = std::stoul( argv[++i] );
+    else if ( arg == "--cache-mb" && hasValue ) options.cacheMB = std::stoul( argv[++i] );
+    else if ( arg == "--gc" && hasValue && parseGcPolicy( argv[ i + 1 ], options.gcPolicy )) ++i;
+    else if ( arg == "--perf" ) options.perf = true;
+    else if ( arg == "--rule" && hasValue ) options.rule = LifeRule::parse( argv[++i] );
+    else if ( arg == "--voxel-side" && hasValue ) options.voxelSide = std::stoul( argv[++i] );
+    else if ( arg == "--voxel-rule" && hasValue ) options.voxelRule = VoxelRule::parse( argv[++i] );
+    else {
+      std::cerr << "usage: " << argv[0] << " [--suite NAME]... [--width W] [--height H] "
+                << "[--generations N] [--density PERCENT] [--seed S] [--max-threads T] [--halo K]... "
+                << "[--step K] [--cache-mb M] [--gc mark-sweep|lru|rebuild] [--perf] [--rule B3/S23] "
+                << "[--voxel-side N] [--voxel-rule 4555]\n"
+                << "suites:";
+      for ( const auto& suite : suites ) std::cerr << " " << suite.first;
+      std::cerr << "\n";
+      return 2;
+    }
+  }
+
+  if ( options.perf )
+  {
+    counters.reset( new PerfCounters );
+    if ( !counters->anyAvailable() ) {
+      std::cerr << "no hardware counters here (perf_event_paranoid, VM or container?)\n";
+    }
+  }
+
+  try {
+    const BenchContext context( options );
+    std::cout << options.width << "x" << options.height << ", " << options.generations
+              << " generations, " << ( options.density ? std::to_string( options.density ) + "% random"
+                                                       : std::string( "glider guns" )) << "\n";
+    for ( const auto& suite : suites )
+    {
+      const bool wanted = options.suites.empty() ||
+        std::find( options.suites.begin(), options.suites.end(), suite.first ) != options.suites.end();
+      if ( wanted ) suite.second( context );
+    }
+  }
+  catch ( const std::exception& e ) {
+    std::cerr << e.what() << "\n";
+    return 1;
+  }
+  return 0;
+}
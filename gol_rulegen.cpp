@@ -0,0 +1,46 @@
+///
+/// Writes a rule's WebAssembly kernel, for trying it outside the page.
+/// (C) Andrew Brownbill 2019
+///
+/// gol_rulegen [--rule B3/S23] [--scalar] [--shared] [--lookup] > kernel.wasm
+///
+/// The same module the page builds and links at run time, see
+/// compileRuleKernel.  --lookup writes the generic lookup kernel instead,
+/// which doesn't depend on the rule.  rule_check.js runs both under node.
+///
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "rule_compiler.h"
+
+int main( int argc, char** argv )
+{
+  LifeRule rule;
+  WasmTarget target;
+  bool lookup = false;
+  try {
+    for ( int i = 1; i < argc; ++i )
+    {
+      const std::string arg = argv[i];
+      const bool hasValue = i + 1 < argc;
+      if ( arg == "--rule" && hasValue ) rule = LifeRule::parse( argv[++i] );
+      else if ( arg == "--scalar" ) target.simd = false;
+      else if ( arg == "--shared" ) target.sharedMemory = true;
+      else if ( arg == "--lookup" ) lookup = true;
+      else {
+        std::cerr << "usage: " << argv[0] << " [--rule B3/S23] [--scalar] [--shared] [--lookup] > kernel.wasm\n";
+        return 2;
+      }
+    }
+  }
+  catch ( const std::invalid_argument& e ) {
+    std::cerr << e.what() << "\n";
+    return 2;
+  }
+
+  const std::vector< uint8_t > module = lookup ? compileLookupKernel( target ) : compileRuleKernel( rule, target );
+  std::cout.write( reinterpret_cast< const char* >( module.data() ), module.size() );
+  return std::cout ? 0 : 1;
+}
@@ -0,0 +1,112 @@
+///
+/// Runs the game of life across several processes on one machine.
+/// (C) Andrew Brownbill 2019
+///
+/// gol_shard [--width W] [--height H] [--processes P] [--halo K]
+///           [--generations N] [--seed S] [--density PERCENT] [--check]
+///
+/// --check compares the result against a single process run.  On the
+/// default X_GRID by Y_GRID board the reference is advanceSim itself.
+///
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "life.h"
+#include "life_shard.h"
+#include "packed_board.h"
+
+// The reference result, one generation at a time in one process.
+static PackedBoard reference( const PackedBoard& start, unsigned generations )
+{
+  PackedBoard result( start.width(), start.height() );
+  if ( start.width() == unsigned( X_GRID ) && start.height() == unsigned( Y_GRID ))
+  {
+    LifeDBuffer life;
+    start.store( life.first );
+    for ( unsigned i = 0; i < generations; ++i ) advanceSim( life );
+    result.load( life.first );
+    return result;
+  }
+
+  PackedBoard other( start.width(), start.height() );
+  result = start;
+  for ( unsigned i = 0; i < generations; ++i )
+  {
+    advancePacked( result, other );
+    std::swap( result, other );
+  }
+  return result;
+}
+
+int main( int argc, char** argv )
+{
+  unsigned width = X_GRID;
+  unsigned height = Y_GRID;
+  unsigned seed = 1;
+  unsigned density = 0;     // 0 = glider guns
+  bool check = false;
+  ShardConfig config;
+
+  for ( int i = 1; i < argc; ++i )
+  {
+    const std::string arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+    if ( arg == "--check" ) check = true;
+    else if ( arg == "--width" && hasValue ) width = std::stoul( argv[++i] );
+    else if ( arg == "--height" && hasValue ) height = std::stoul( argv[++i] );
+    else if ( arg == "--processes" && hasValue ) config.processes = std::stoul( argv[++i] );
+    else if ( arg == "--halo" && hasValue ) config.halo = std::stoul( argv[++i] );
+    else if ( arg == "--generations" && hasValue ) config.generations = std::stoul( argv[++i] );
+    else if ( arg == "--seed" && hasValue ) seed = std::stoul( argv[++i] );
+    else if ( arg == "--density" && hasValue ) density = std::stoul( argv[++i] );
+    else {
+      std::cerr << "usage: " << argv[0] << " [--width W] [--height H] [--processes P] "
+                << "[--halo K] [--generations N] [--seed S] [--density PERCENT] [--check]\n";
+      return 2;
+    }
+  }
+
+  try {
+    PackedBoard board( width, height );
+    if ( density ) fillRandom( board, density, seed );
+    else seedGliderGuns( board, seed );
+    const PackedBoard start = board;
+
+    const auto begin = std::chrono::steady_clock::now();
+    if ( !runSharded( board, config ))
+    {
+      std::cerr << "a worker process failed\n";
+      return 1;
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+
+    std::cout << width << "x" << height << " " << config.generations << " generations, "
+              << config.processes << " processes, halo " << config.halo << ": "
+              << elapsed.count() << " s, "
+              << config.generations / elapsed.count() << " generations/s, population "
+              << board.population() << "\n";
+
+    if ( check )
+    {
+      const PackedBoard expected = reference( start, config.generations );
+      for ( unsigned y = 0; y < height; ++y )
+      {
+        if ( std::memcmp( expected.row( y ), board.row( y ), board.wordsPerRow() * sizeof( uint64_t )))
+        {
+          std::cerr << "check FAILED: row " << y << " differs from the reference\n";
+          return 1;
+        }
+      }
+      std::cout << "check passed\n";
+    }
+  }
+  catch ( const std::exception& e ) {
+    std::cerr << e.what() << "\n";
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,62 @@
+///
+/// Writes snapshot.h, a start board baked into the web build.
+/// (C) Andrew Brownbill 2019
+///
+/// gol_snapshot [--seed S] [--generations N] > snapshot.h
+///
+/// Build the page with -DGOL_SNAPSHOT to start from the snapshot instead
+/// of randomly placed glider guns.  Only the non zero words are stored.
+///
+
+#include <iostream>
+#include <string>
+
+#include "life.h"
+#include "packed_board.h"
+
+int main( int argc, char** argv )
+{
+  unsigned seed = 1;
+  unsigned generations = 0;
+  for ( int i = 1; i < argc; ++i )
+  {
+    const std::string arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+    if ( arg == "--seed" && hasValue ) seed = std::stoul( argv[++i] );
+    else if ( arg == "--generations" && hasValue ) generations = std::stoul( argv[++i] );
+    else {
+      std::cerr << "usage: " << argv[0] << " [--seed S] [--generations N] > snapshot.h\n";
+      return 2;
+    }
+  }
+
+  PackedBoard board( X_GRID, Y_GRID );
+  PackedBoard other( X_GRID, Y_GRID );
+  seedGliderGuns( board, seed );
+  for ( unsigned i = 0; i < generations; ++i )
+  {
+    advancePacked( board, other );
+    std::swap( board, other );
+  }
+
+  std::cout << "///\n/// Start board for the web build.  Generated by\n"
+            << "/// gol_snapshot --seed " << seed << " --generations " << generations
+            << ", don't edit.\n///\n\n"
+            << "#ifndef SNAPSHOT_H\n#define SNAPSHOT_H\n\n"
+            << "#include <cstdint>\n\n"
+            << "constexpr unsigned SNAPSHOT_WIDTH = " << board.width() << ";\n"
+            << "constexpr unsigned SNAPSHOT_HEIGHT = " << board.height() << ";\n\n"
+            << "// Word index into the packed board, then the word.\n"
+            << "const uint64_t snapshotWords[] = {\n";
+  size_t count = 0;
+  for ( unsigned y = 0; y < board.height(); ++y ) {
+    for ( unsigned w = 0; w < board.wordsPerRow(); ++w ) {
+      const uint64_t word = board.row( y )[w];
+      if ( !word ) continue;
+      std::cout << "  " << y * board.wordsPerRow() + w << "u, 0x" << std::hex << word << std::dec << "ull,\n";
+      ++count;
+    }
+  }
+  std::cout << "};\n\nconstexpr unsigned SNAPSHOT_WORDS = " << count << ";\n\n#endif\n";
+  return 0;
+}
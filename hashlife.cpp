@@ -0,0 +1,514 @@
+///
+/// HashLife.  The universe is a quadtree of shared, hash consed nodes
+/// and each node remembers its own future.
+/// (C) Andrew Brownbill 2019
+///
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+#include "hashlife.h"
+#include "lut_engine.h"
+
+// Node store limit unless setMemoryLimit() says otherwise.
+constexpr size_t DEFAULT_LIMIT = size_t( 256 ) << 20;
+
+// The smallest root, 8x8 cells.
+constexpr unsigned MIN_LEVEL = 3;
+
+// Past this the generation counter overflows.
+constexpr unsigned MAX_STEP_LOG2 = 62;
+
+constexpr size_t MIN_BUCKETS = 1024;
+
+constexpr HashLife::NodeId HashLife::NONE;
+constexpr HashLife::NodeId HashLife::DEAD;
+constexpr HashLife::NodeId HashLife::ALIVE;
+
+static size_t hashOf( uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se )
+{
+  uint64_t h = nw;
+  h = h * 0x9E3779B97F4A7C15ull + ne;
+  h = h * 0x9E3779B97F4A7C15ull + sw;
+  h = h * 0x9E3779B97F4A7C15ull + se;
+  return size_t( h ^ ( h >> 29 ));
+}
+
+HashLife::HashLife() :
+  stepSize( 0 ), limitBytes( DEFAULT_LIMIT ), gcPolicy( GcPolicy::LruResults )
+{
+  clear();
+}
+
+void HashLife::reset()
+{
+  nodes.clear();
+  nodes.resize( 3 );
+  nodes[ NONE ].level = FREE;
+  nodes[ DEAD ].level = 0;
+  nodes[ ALIVE ].level = 0;
+  nodes[ ALIVE ].population = 1;
+  buckets.assign( MIN_BUCKETS, NONE );
+  empties.clear();
+  freeList = NONE;
+  inUse = 0;
+  root = empty( MIN_LEVEL );
+}
+
+void HashLife::clear()
+{
+  reset();
+  generations = 0;
+  clock = 0;
+  statistics = Stats();
+}
+
+size_t HashLife::bytesHeld() const
+{
+  return nodes.capacity() * sizeof( Node ) + buckets.capacity() * sizeof( NodeId );
+}
+
+size_t HashLife::bytesInUse() const
+{
+  return inUse * sizeof( Node ) + buckets.size() * sizeof( NodeId );
+}
+
+HashLife::NodeId HashLife::join( NodeId nw, NodeId ne, NodeId sw, NodeId se )
+{
+  size_t bucket = hashOf( nw, ne, sw, se ) & ( buckets.size() - 1 );
+  for ( NodeId id = buckets[ bucket ]; id != NONE; id = nodes[ id ].next )
+  {
+    const Node& n = nodes[ id ];
+    if ( n.nw == nw && n.ne == ne && n.sw == sw && n.se == se ) return id;
+  }
+
+  if ( inUse >= buckets.size() )
+  {
+    rehash( buckets.size() * 2 );
+    bucket = hashOf( nw, ne, sw, se ) & ( buckets.size() - 1 );
+  }
+
+  NodeId id = freeList;
+  if ( id != NONE ) freeList = nodes[ id ].next;
+  else
+  {
+    id = NodeId( nodes.size() );
+    nodes.emplace_back();
+  }
+  Node& n = nodes[ id ];
+  n.nw = nw;
+  n.ne = ne;
+  n.sw = sw;
+  n.se = se;
+  n.result = NONE;
+  n.resultLog2 = 0;
+  n.used = 0;
+  n.level = uint8_t( nodes[ nw ].level + 1 );
+  n.mark = 0;
+  n.population = nodes[ nw ].population + nodes[ ne ].population +
+                 nodes[ sw ].population + nodes[ se ].population;
+  n.next = buckets[ bucket ];
+  buckets[ bucket ] = id;
+  ++inUse;
+  return id;
+}
+
+HashLife::NodeId HashLife::empty( unsigned level )
+{
+  if ( empties.empty() ) empties.push_back( DEAD );
+  while ( empties.size() <= level )
+  {
+    const NodeId e = empties.back();
+    empties.push_back( join( e, e, e, e ));
+  }
+  return empties[ level ];
+}
+
+HashLife::NodeId HashLife::center( NodeId id )
+{
+  const Node n = nodes[ id ];
+  return join( nodes[ n.nw ].se, nodes[ n.ne ].sw, nodes[ n.sw ].ne, nodes[ n.se ].nw );
+}
+
+// 4x4 cells to the 2x2 center one generation on, by table lookup.
+HashLife::NodeId HashLife::baseResult( NodeId id )
+{
+  const Node n = nodes[ id ];
+  const NodeId quadrants[ 4 ] = { n.nw, n.ne, n.sw, n.se };
+  unsigned index = 0;
+  for ( unsigned q = 0; q < 4; ++q )
+  {
+    const Node& quad = nodes[ quadrants[ q ]];
+    const unsigned x = ( q & 1 ) * 2;
+    const unsigned y = ( q >> 1 ) * 2;
+    index |= ( quad.nw == ALIVE ) << ( y * 4 + x );
+    index |= ( quad.ne == ALIVE ) << ( y * 4 + x + 1 );
+    index |= ( quad.sw == ALIVE ) << (( y + 1 ) * 4 + x );
+    index |= ( quad.se == ALIVE ) << (( y + 1 ) * 4 + x + 1 );
+  }
+  const unsigned bits = blockTable()[ index ];
+  auto cell = [&]( unsigned bit ) { return (( bits >> bit ) & 1 ) ? ALIVE : DEAD; };
+  return join( cell( 0 ), cell( 1 ), cell( 2 ), cell( 3 ));
+}
+
+// The center of a level k node, 2^min( stepSize, k - 2 ) generations on.
+// At full speed both halves of the recursion advance; below it the first
+// half only recenters.
+HashLife::NodeId HashLife::result( NodeId id )
+{
+  const unsigned log2 = std::min( stepSize, nodes[ id ].level - 2u );
+  if ( nodes[ id ].result != NONE && nodes[ id ].resultLog2 == log2 )
+  {
+    ++statistics.hits;
+    nodes[ id ].used = clock;
+    return nodes[ id ].result;
+  }
+  ++statistics.misses;
+
+  const Node n = nodes[ id ];
+  NodeId out;
+  if ( n.population == 0 ) out = empty( n.level - 1u );
+  else if ( n.level == 2 ) out = baseResult( id );
+  else
+  {
+    const Node a = nodes[ n.nw ];
+    const Node b = nodes[ n.ne ];
+    const Node c = nodes[ n.sw ];
+    const Node d = nodes[ n.se ];
+
+    // Nine overlapping level k - 1 squares, three rows of three.
+    NodeId parts[ 9 ] = {
+      n.nw, join( a.ne, b.nw, a.se, b.sw ), n.ne,
+      join( a.sw, a.se, c.nw, c.ne ), join( a.se, b.sw, c.ne, d.nw ), join( b.sw, b.se, d.nw, d.ne ),
+      n.sw, join( c.ne, d.nw, c.se, d.sw ), n.se };
+
+    const bool fast = log2 + 2 == n.level;
+    for ( NodeId& part : parts ) part = fast ? result( part ) : center( part );
+
+    const NodeId nw = result( join( parts[ 0 ], parts[ 1 ], parts[ 3 ], parts[ 4 ] ));
+    const NodeId ne = result( join( parts[ 1 ], parts[ 2 ], parts[ 4 ], parts[ 5 ] ));
+    const NodeId sw = result( join( parts[ 3 ], parts[ 4 ], parts[ 6 ], parts[ 7 ] ));
+    const NodeId se = result( join( parts[ 4 ], parts[ 5 ], parts[ 7 ], parts[ 8 ] ));
+    out = join( nw, ne, sw, se );
+  }
+  nodes[ id ].result = out;
+  nodes[ id ].resultLog2 = uint8_t( log2 );
+  nodes[ id ].used = clock;
+  return out;
+}
+
+HashLife::NodeId HashLife::setCell( NodeId id, int64_t x, int64_t y, bool alive )
+{
+  const Node n = nodes[ id ];
+  if ( n.level == 0 ) return alive ? ALIVE : DEAD;
+  const int64_t half = int64_t( 1 ) << ( n.level - 1 );
+  if ( y < half )
+  {
+    if ( x < half ) return join( setCell( n.nw, x, y, alive ), n.ne, n.sw, n.se );
+    return join( n.nw, setCell( n.ne, x - half, y, alive ), n.sw, n.se );
+  }
+  if ( x < half ) return join( n.nw, n.ne, setCell( n.sw, x, y - half, alive ), n.se );
+  return join( n.nw, n.ne, n.sw, setCell( n.se, x - half, y - half, alive ));
+}
+
+void HashLife::set( int64_t x, int64_t y, bool alive )
+{
+  for (;;)
+  {
+    const int64_t origin = rootOrigin();
+    if ( x >= origin && x < -origin && y >= origin && y < -origin ) break;
+    expand();
+  }
+  const int64_t origin = rootOrigin();
+  root = setCell( root, x - origin, y - origin, alive );
+}
+
+bool HashLife::get( int64_t x, int64_t y ) const
+{
+  int64_t origin = rootOrigin();
+  if ( x < origin || x >= -origin || y < origin || y >= -origin ) return false;
+  x -= origin;
+  y -= origin;
+  NodeId id = root;
+  while ( nodes[ id ].level > 0 && nodes[ id ].population )
+  {
+    const Node& n = nodes[ id ];
+    const int64_t half = int64_t( 1 ) << ( n.level - 1 );
+    const bool east = x >= half;
+    const bool south = y >= half;
+    id = south ? ( east ? n.se : n.sw ) : ( east ? n.ne : n.nw );
+    if ( east ) x -= half;
+    if ( south ) y -= half;
+  }
+  return id == ALIVE;
+}
+
+// The 2^level square at x, y in board coordinates.
+HashLife::NodeId HashLife::build( const PackedBoard& board, int64_t x, int64_t y, unsigned level )
+{
+  const int64_t side = int64_t( 1 ) << level;
+  if ( x >= board.width() || y >= board.height() || x + side <= 0 || y + side <= 0 ) {
+    return empty( level );
+  }
+  if ( level == 0 ) return board.get( unsigned( x ), unsigned( y )) ? ALIVE : DEAD;
+
+  // Skip empty word aligned squares without visiting every cell.
+  if ( side == CELLS_PER_WORD && x >= 0 && x % CELLS_PER_WORD == 0 && y >= 0 &&
+       y + side <= board.height() )
+  {
+    bool blank = true;
+    for ( int64_t row = y; row < y + side && blank; ++row ) {
+      blank = board.row( unsigned( row ))[ x / CELLS_PER_WORD ] == 0;
+    }
+    if ( blank ) return empty( level );
+  }
+
+  const int64_t half = side / 2;
+  const NodeId nw = build( board, x, y, level - 1 );
+  const NodeId ne = build( board, x + half, y, level - 1 );
+  const NodeId sw = build( board, x, y + half, level - 1 );
+  const NodeId se = build( board, x + half, y + half, level - 1 );
+  return join( nw, ne, sw, se );
+}
+
+void HashLife::load( const PackedBoard& board, int64_t x, int64_t y )
+{
+  clear();
+  const int64_t right = x + board.width();
+  const int64_t bottom = y + board.height();
+  for (;;)
+  {
+    const int64_t origin = rootOrigin();
+    if ( x >= origin && right <= -origin && y >= origin && bottom <= -origin ) break;
+    expand();
+  }
+  const int64_t origin = rootOrigin();
+  root = build( board, origin - x, origin - y, rootLevel() );
+}
+
+void HashLife::extract( int64_t left, int64_t top, PackedBoard& board ) const
+{
+  board.clear();
+  const int64_t origin = rootOrigin();
+  extractNode( root, origin - left, origin - top, board );
+}
+
+// Node id with its top left corner at x, y in board coordinates.
+void HashLife::extractNode( NodeId id, int64_t x, int64_t y, PackedBoard& board ) const
+{
+  const Node& n = nodes[ id ];
+  const int64_t side = int64_t( 1 ) << n.level;
+  if ( n.population == 0 || x >= board.width() || y >= board.height() || x + side <= 0 || y + side <= 0 ) {
+    return;
+  }
+  if ( n.level == 0 )
+  {
+    board.set( unsigned( x ), unsigned( y ), true );
+    return;
+  }
+  const int64_t half = side / 2;
+  extractNode( n.nw, x, y, board );
+  extractNode( n.ne, x + half, y, board );
+  extractNode( n.sw, x, y + half, board );
+  extractNode( n.se, x + half, y + half, board );
+}
+
+// Double the root's side, keeping it centered on 0, 0.
+void HashLife::expand()
+{
+  const Node n = nodes[ root ];
+  const NodeId e = empty( n.level - 1u );
+  const NodeId nw = join( e, e, e, n.nw );
+  const NodeId ne = join( e, e, n.ne, e );
+  const NodeId sw = join( e, n.sw, e, e );
+  const NodeId se = join( n.se, e, e, e );
+  root = join( nw, ne, sw, se );
+}
+
+void HashLife::setStepLog2( unsigned log2 )
+{
+  if ( log2 > MAX_STEP_LOG2 ) throw std::invalid_argument( "HashLife step too large" );
+  stepSize = log2;
+}
+
+void HashLife::step()
+{
+  maybeCollect();
+
+  // The result is the root's center half, so the pattern has to sit in
+  // the center quarter, with room for light speed growth over the step.
+  while ( rootLevel() < stepSize + 3 ||
+          nodes[ root ].population != nodes[ center( center( root )) ].population ) {
+    expand();
+  }
+  ++clock;
+  root = result( root );
+  generations += uint64_t( 1 ) << stepSize;
+}
+
+uint64_t HashLife::population() const
+{
+  return nodes[ root ].population;
+}
+
+void HashLife::rehash( size_t count )
+{
+  buckets.assign( std::max( count, MIN_BUCKETS ), NONE );
+  for ( NodeId id = ALIVE + 1; id < nodes.size(); ++id )
+  {
+    Node& n = nodes[ id ];
+    if ( n.level == FREE ) continue;
+    const size_t bucket = hashOf( n.nw, n.ne, n.sw, n.se ) & ( buckets.size() - 1 );
+    n.next = buckets[ bucket ];
+    buckets[ bucket ] = id;
+  }
+}
+
+void HashLife::mark( bool followResults )
+{
+  for ( Node& n : nodes ) n.mark = 0;
+  std::vector< NodeId > pending( empties.begin(), empties.end() );
+  pending.push_back( root );
+  pending.push_back( DEAD );
+  pending.push_back( ALIVE );
+  while ( !pending.empty() )
+  {
+    const NodeId id = pending.back();
+    pending.pop_back();
+    Node& n = nodes[ id ];
+    if ( id == NONE || n.mark ) continue;
+    n.mark = 1;
+    if ( n.level > 0 )
+    {
+      pending.push_back( n.nw );
+      pending.push_back( n.ne );
+      pending.push_back( n.sw );
+      pending.push_back( n.se );
+    }
+    if ( followResults && n.result != NONE ) pending.push_back( n.result );
+  }
+}
+
+// Free what mark() didn't reach and drop results that point there.
+size_t HashLife::sweep()
+{
+  size_t freed = 0;
+  for ( NodeId id = ALIVE + 1; id < nodes.size(); ++id )
+  {
+    Node& n = nodes[ id ];
+    if ( n.level == FREE ) continue;
+    if ( n.mark )
+    {
+      if ( n.result != NONE && !nodes[ n.result ].mark ) n.result = NONE;
+      continue;
+    }
+    n.level = FREE;
+    n.result = NONE;
+    n.next = freeList;
+    freeList = id;
+    ++freed;
+  }
+  inUse -= freed;
+  rehash( buckets.size() );
+  return freed;
+}
+
+HashLife::NodeId HashLife::copyFrom( const std::vector< Node >& old, std::vector< NodeId >& remap, NodeId id )
+{
+  if ( remap[ id ] != NONE ) return remap[ id ];
+  const Node& n = old[ id ];
+  const NodeId nw = copyFrom( old, remap, n.nw );
+  const NodeId ne = copyFrom( old, remap, n.ne );
+  const NodeId sw = copyFrom( old, remap, n.sw );
+  const NodeId se = copyFrom( old, remap, n.se );
+  return remap[ id ] = join( nw, ne, sw, se );
+}
+
+// Move the current pattern into a fresh store, so the old one's memory
+// goes back to the allocator.
+void HashLife::compact()
+{
+  std::vector< Node > old;
+  old.swap( nodes );
+  const NodeId oldRoot = root;
+  reset();
+  std::vector< NodeId > remap( old.size(), NONE );
+  remap[ DEAD ] = DEAD;
+  remap[ ALIVE ] = ALIVE;
+  root = copyFrom( old, remap, oldRoot );
+}
+
+void HashLife::collect( GcPolicy policy )
+{
+  const auto begin = std::chrono::steady_clock::now();
+  const size_t before = inUse;
+
+  switch ( policy )
+  {
+    case GcPolicy::MarkSweep:
+      mark( true );
+      sweep();
+      break;
+    case GcPolicy::LruResults:
+    {
+      std::vector< uint32_t > stamps;
+      for ( const Node& n : nodes ) {
+        if ( n.level != FREE && n.result != NONE ) stamps.push_back( n.used );
+      }
+      if ( !stamps.empty() )
+      {
+        auto middle = stamps.begin() + stamps.size() / 2;
+        std::nth_element( stamps.begin(), middle, stamps.end() );
+        const uint32_t oldest = std::max( *middle, uint32_t( 1 ));
+        for ( Node& n : nodes ) {
+          if ( n.level != FREE && n.used < oldest ) n.result = NONE;
+        }
+      }
+      mark( true );
+      sweep();
+      break;
+    }
+    case GcPolicy::Rebuild:
+      compact();
+      break;
+  }
+
+  const std::chrono::duration< double, std::milli > pause = std::chrono::steady_clock::now() - begin;
+  ++statistics.collections;
+  statistics.freedNodes += before > inUse ? before - inUse : 0;
+  statistics.lastPauseMs = pause.count();
+  statistics.maxPauseMs = std::max( statistics.maxPauseMs, pause.count() );
+  statistics.totalPauseMs += pause.count();
+}
+
+// Collect with the chosen policy, then rebuild if that didn't get the
+// store well under the limit; results reachable from the root can pin
+// most of it.
+void HashLife::maybeCollect()
+{
+  if ( limitBytes == 0 || bytesInUse() <= limitBytes ) return;
+  collect( gcPolicy );
+  if ( gcPolicy != GcPolicy::Rebuild && bytesInUse() > limitBytes / 4 * 3 ) collect( GcPolicy::Rebuild );
+}
+
+const HashLife::Stats& HashLife::stats()
+{
+  statistics.nodes = inUse;
+  statistics.bytes = bytesHeld();
+  return statistics;
+}
+
+void HashLife::memoryUsage( std::vector< MemoryUse >& report ) const
+{
+  report.push_back( MemoryUse{ "hashlife", bytesHeld() } );
+}
+
+size_t HashLife::trimMemory( size_t bytes )
+{
+  (void) bytes;
+  const size_t before = bytesHeld();
+  collect( GcPolicy::Rebuild );
+  const size_t after = bytesHeld();
+  return before > after ? before - after : 0;
+}
@@ -0,0 +1,150 @@
+///
+/// HashLife.  The universe is a quadtree of shared, hash consed nodes
+/// and each node remembers its own future, so repeating patterns step in
+/// huge jumps.  Unlike the other engines the universe doesn't wrap, it
+/// grows as the pattern does.
+/// (C) Andrew Brownbill 2019
+///
+
+#ifndef HASHLIFE_H
+#define HASHLIFE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "memory_budget.h"
+#include "packed_board.h"
+
+class HashLife : public MemoryClient
+{
+  public:
+
+  // What to throw away when the node store reaches the memory limit.
+  enum class GcPolicy
+  {
+    MarkSweep,    // Keep everything reachable from the root, results too
+    LruResults,   // Forget the least recently used half of the results first
+    Rebuild,      // Keep only the current pattern, compacted, no results
+  };
+
+  class Stats
+  {
+    public:
+
+    size_t nodes = 0;             // Nodes in use
+    size_t bytes = 0;             // Held by the node store and hash table
+    uint64_t hits = 0;            // Results found in the cache
+    uint64_t misses = 0;          // Results that had to be computed
+    unsigned collections = 0;
+    size_t freedNodes = 0;        // By all collections
+    double lastPauseMs = 0;
+    double maxPauseMs = 0;
+    double totalPauseMs = 0;
+
+    double hitRate() const { return hits + misses ? double( hits ) / double( hits + misses ) : 0; }
+  };
+
+  HashLife();
+
+  void clear();
+  void set( int64_t x, int64_t y, bool alive );
+  bool get( int64_t x, int64_t y ) const;
+
+  // Replace the universe with board, its top left corner at x, y.
+  void load( const PackedBoard& board, int64_t x, int64_t y );
+
+  // Copy the cells at left, top out to board, which says how many.  Cell
+  // ages don't fit in a shared tree, so renderers that color by age keep
+  // them for a window like this one.
+  void extract( int64_t left, int64_t top, PackedBoard& board ) const;
+
+  // Each step() advances 2^stepLog2 generations.  Results remember the
+  // step they were made for, so switching back and forth is cheap; nodes
+  // up to level stepLog2 + 2 always step at full speed and share theirs.
+  void setStepLog2( unsigned log2 );
+  unsigned stepLog2() const { return stepSize; }
+  void step();
+
+  uint64_t generation() const { return generations; }
+  uint64_t population() const;
+
+  // Memory discipline.  The limit is checked between steps; a step that
+  // needs more than the limit still finishes.
+  void setMemoryLimit( size_t bytes ) { limitBytes = bytes; }
+  size_t memoryLimit() const { return limitBytes; }
+  void setGcPolicy( GcPolicy policy ) { gcPolicy = policy; }
+  GcPolicy policy() const { return gcPolicy; }
+  void collect( GcPolicy policy );
+  const Stats& stats();
+
+  void memoryUsage( std::vector< MemoryUse >& report ) const override;
+  size_t trimMemory( size_t bytes ) override;
+
+  // Read only access to the tree, for renderers.
+  using NodeId = uint32_t;
+
+  // Node 0 is "none", 1 and 2 are the dead and live cells.
+  static constexpr NodeId NONE = 0;
+  static constexpr NodeId DEAD = 1;
+  static constexpr NodeId ALIVE = 2;
+
+  class Node
+  {
+    public:
+
+    NodeId nw, ne, sw, se;      // Quadrants, level - 1
+    NodeId result;              // Center after the step, level - 1
+    NodeId next;                // Hash chain, or free list
+    uint32_t used;              // Step the result was last used in
+    uint8_t level;              // Side is 2^level cells
+    uint8_t resultLog2;         // Result is 2^resultLog2 generations on
+    uint8_t mark;
+    uint64_t population;
+  };
+
+  const Node& node( NodeId id ) const { return nodes[ id ]; }
+  NodeId rootNode() const { return root; }
+  unsigned rootLevel() const { return nodes[ root ].level; }
+
+  // The root covers [-2^(level-1), 2^(level-1)) on both axes.
+  int64_t rootOrigin() const { return -( int64_t( 1 ) << ( rootLevel() - 1 )); }
+
+  private:
+
+  static constexpr uint8_t FREE = 0xff;
+
+  void reset();
+  size_t bytesHeld() const;
+  size_t bytesInUse() const;
+
+  NodeId join( NodeId nw, NodeId ne, NodeId sw, NodeId se );
+  NodeId empty( unsigned level );
+  NodeId center( NodeId id );
+  NodeId result( NodeId id );
+  NodeId baseResult( NodeId id );
+  NodeId setCell( NodeId id, int64_t x, int64_t y, bool alive );
+  NodeId build( const PackedBoard& board, int64_t x, int64_t y, unsigned level );
+  void extractNode( NodeId id, int64_t x, int64_t y, PackedBoard& board ) const;
+  void expand();
+  void rehash( size_t count );
+  void mark( bool followResults );
+  size_t sweep();
+  void compact();
+  NodeId copyFrom( const std::vector< Node >& old, std::vector< NodeId >& remap, NodeId id );
+  void maybeCollect();
+
+  std::vector< Node > nodes;
+  std::vector< NodeId > buckets;
+  std::vector< NodeId > empties;
+  NodeId freeList;
+  size_t inUse;
+  NodeId root;
+  unsigned stepSize;
+  uint64_t generations;
+  uint32_t clock;
+  size_t limitBytes;
+  GcPolicy gcPolicy;
+  Stats statistics;
+};
+
+#endif
@@ -0,0 +1,131 @@
+///
+/// Showing a HashLife universe: picking the step size for smooth display
+/// and drawing straight from the quadtree.
+/// (C) Andrew Brownbill 2019
+///
+
+#include <algorithm>
+#include <cmath>
+
+#include "hashlife_view.h"
+
+// A step may use this much of the frame before the step shrinks, and
+// below this much it may grow.
+constexpr double SLOW_STEP = 0.75;
+constexpr double FAST_STEP = 0.25;
+
+// Weight of the newest step in the average.
+constexpr double SMOOTHING = 0.25;
+
+constexpr unsigned SETTLE_FRAMES = 8;
+
+// HashLife::setStepLog2 takes up to 62, leave headroom for the root.
+constexpr unsigned MAX_STEP_LOG2 = 48;
+
+StepController::StepController( double framesPerSecond, double generationsPerSecond ) :
+  log2( 0 ), average( 0 ), settle( SETTLE_FRAMES )
+{
+  setTargets( framesPerSecond, generationsPerSecond );
+}
+
+void StepController::setTargets( double framesPerSecond, double generationsPerSecond )
+{
+  fps = std::max( framesPerSecond, 1.0 );
+  gps = std::max( generationsPerSecond, 1.0 );
+  log2 = std::min( log2, maxLog2() );
+}
+
+// The biggest step that doesn't go over the generation rate.
+unsigned StepController::maxLog2() const
+{
+  const double perFrame = gps / fps;
+  if ( perFrame < 2 ) return 0;
+  return std::min( unsigned( std::log2( perFrame )), MAX_STEP_LOG2 );
+}
+
+bool StepController::frameDone( double stepSeconds )
+{
+  const unsigned before = log2;
+  if ( settle )
+  {
+    --settle;
+    average = stepSeconds;
+  }
+  else average += SMOOTHING * ( stepSeconds - average );
+
+  const double budget = 1 / fps;
+  if ( stepSeconds > SLOW_STEP * budget && log2 > 0 ) --log2;
+  else if ( !settle && average < FAST_STEP * budget && log2 < maxLog2() ) ++log2;
+  log2 = std::min( log2, maxLog2() );
+
+  if ( log2 == before ) return false;
+  settle = SETTLE_FRAMES;
+  return true;
+}
+
+class Renderer
+{
+  public:
+
+  const HashLife& life;
+  const Viewport& view;
+  const std::vector< uint32_t >& colors;
+  uint32_t* pixels;
+  unsigned pitch;
+
+  // Pixel of a cell coordinate, rounding down when zoomed out.
+  int64_t pixel( int64_t cell ) const
+  {
+    return view.zoom >= 0 ? cell * ( int64_t( 1 ) << view.zoom ) : cell >> -view.zoom;
+  }
+
+  void fill( int64_t x, int64_t y, int64_t size, uint32_t color ) const
+  {
+    const int64_t x0 = std::max< int64_t >( x, 0 );
+    const int64_t y0 = std::max< int64_t >( y, 0 );
+    const int64_t x1 = std::min< int64_t >( x + size, view.width );
+    const int64_t y1 = std::min< int64_t >( y + size, view.height );
+    for ( int64_t py = y0; py < y1; ++py ) {
+      std::fill( pixels + py * pitch + x0, pixels + py * pitch + x1, color );
+    }
+  }
+
+  // Node id with its top left corner at cell x, y, relative to the view.
+  void draw( HashLife::NodeId id, int64_t x, int64_t y ) const
+  {
+    const HashLife::Node& n = life.node( id );
+    if ( n.population == 0 ) return;
+
+    const int64_t px = pixel( x );
+    const int64_t py = pixel( y );
+    const int64_t size = std::max< int64_t >( pixel( int64_t( 1 ) << n.level ), 1 );
+    if ( px >= view.width || py >= view.height || px + size <= 0 || py + size <= 0 ) return;
+
+    if ( n.level == 0 || view.zoom + int( n.level ) <= 0 )
+    {
+      const double full = std::ldexp( 1.0, 2 * n.level );
+      const size_t color = n.level == 0 ? 0 : size_t(( colors.size() - 1 ) * ( n.population - 1 ) / ( full - 1 ));
+      fill( px, py, size, colors[ color ] );
+      return;
+    }
+
+    const int64_t half = int64_t( 1 ) << ( n.level - 1 );
+    draw( n.nw, x, y );
+    draw( n.ne, x + half, y );
+    draw( n.sw, x, y + half );
+    draw( n.se, x + half, y + half );
+  }
+};
+
+void renderHashLife( const HashLife& life, const Viewport& view, const std::vector< uint32_t >& colors,
+                     uint32_t background, uint32_t* pixels, unsigned pitch )
+{
+  for ( unsigned y = 0; y < view.height; ++y ) {
+    std::fill( pixels + size_t( y ) * pitch, pixels + size_t( y ) * pitch + view.width, background );
+  }
+  if ( colors.empty() ) return;
+
+  const Renderer renderer{ life, view, colors, pixels, pitch };
+  const int64_t origin = life.rootOrigin();
+  renderer.draw( life.rootNode(), origin - view.left, origin - view.top );
+}
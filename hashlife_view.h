@@ -0,0 +1,69 @@
+///
+/// Showing a HashLife universe: picking the step size for smooth display
+/// and drawing straight from the quadtree.
+/// (C) Andrew Brownbill 2019
+///
+
+#ifndef HASHLIFE_VIEW_H
+#define HASHLIFE_VIEW_H
+
+#include <cstdint>
+#include <vector>
+
+#include "hashlife.h"
+
+// Picks the HashLife step, 2^stepLog2() generations a frame, to get as
+// many generations per second as the targets allow.  It grows the step
+// while steps are cheap next to the frame budget and the generation rate
+// is under target, and shrinks it as soon as a step eats too much of the
+// frame.  After a change it waits a few frames, the first steps at a new
+// size fill the cache and aren't representative.
+class StepController
+{
+  public:
+
+  explicit StepController( double framesPerSecond = 60, double generationsPerSecond = 1e6 );
+
+  void setTargets( double framesPerSecond, double generationsPerSecond );
+  double framesPerSecond() const { return fps; }
+  double generationsPerSecond() const { return gps; }
+
+  unsigned stepLog2() const { return log2; }
+
+  // Call once a frame with how long the step took.  Returns true if
+  // stepLog2() changed.
+  bool frameDone( double stepSeconds );
+
+  private:
+
+  unsigned maxLog2() const;
+
+  double fps;
+  double gps;
+  unsigned log2;
+  double average;       // Step time at this size, smoothed
+  unsigned settle;      // Frames to ignore after a change
+};
+
+// Which part of the plane is on screen.  Cell left, top lands on pixel
+// 0, 0 and a cell is 2^zoom pixels wide; negative zooms have several
+// cells per pixel.
+class Viewport
+{
+  public:
+
+  int64_t left;
+  int64_t top;
+  int zoom;
+  unsigned width;       // Pixels
+  unsigned height;
+};
+
+// Draw the universe into pixels, pitch pixels per row, without going
+// through a grid.  Empty and off screen nodes are skipped whole, and a
+// node that fits in a pixel is drawn as one, colored by how full it is:
+// colors[ 0 ] for a lone cell up to colors.back() for a full pixel.
+void renderHashLife( const HashLife& life, const Viewport& view, const std::vector< uint32_t >& colors,
+                     uint32_t background, uint32_t* pixels, unsigned pitch );
+
+#endif
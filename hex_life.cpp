@@ -0,0 +1,129 @@
+///
+/// Game of life on a hexagonal grid, packed like the square one.
+/// (C) Andrew Brownbill 2019
+///
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "bit_ops.h"
+#include "hex_life.h"
+
+// Most neighbors a hex cell has.
+constexpr unsigned HEX_NEIGHBORS = 6;
+
+// Word w of row y's neighbors: west, east, then the rows above and below
+// and their cells to the west on even rows, to the east on odd ones.
+class HexNeighbors
+{
+  public:
+
+  HexNeighbors( unsigned y, const uint64_t* up, const uint64_t* mid, const uint64_t* down,
+                unsigned w, unsigned words )
+  {
+    const unsigned p = w ? w - 1 : words - 1;         // wrap around x
+    const unsigned n = ( w + 1 < words ) ? w + 1 : 0;
+    west = westOf( mid[ p ], mid[ w ] );
+    east = eastOf( mid[ w ], mid[ n ] );
+    above = up[ w ];
+    below = down[ w ];
+    aboveSide = y % 2 ? eastOf( up[ w ], up[ n ] ) : westOf( up[ p ], up[ w ] );
+    belowSide = y % 2 ? eastOf( down[ w ], down[ n ] ) : westOf( down[ p ], down[ w ] );
+  }
+
+  uint64_t west, east, above, aboveSide, below, belowSide;
+};
+
+static void checkHex( const PackedBoard& board )
+{
+  if ( board.height() % 2 ) throw std::invalid_argument( "hex boards need an even height" );
+}
+
+void hexNeighborhoodRow(
+  unsigned y,
+  const uint64_t* up,
+  const uint64_t* mid,
+  const uint64_t* down,
+  uint64_t* out,
+  unsigned words )
+{
+  for ( unsigned w = 0; w < words; ++w )
+  {
+    const HexNeighbors cells( y, up, mid, down, w, words );
+    out[ w ] = cells.west | cells.east | cells.above | cells.aboveSide | cells.below | cells.belowSide;
+  }
+}
+
+void advanceHex( const PackedBoard& src, PackedBoard& dst, const LifeRule& rule )
+{
+  if ( dst.width() != src.width() || dst.height() != src.height() ) {
+    throw std::invalid_argument( "advanceHex board size mismatch" );
+  }
+  if (( rule.birth | rule.survive ) >> ( HEX_NEIGHBORS + 1 )) {
+    throw std::invalid_argument( "hex rules count at most " + std::to_string( HEX_NEIGHBORS ) + " neighbors" );
+  }
+  checkHex( src );
+
+  // The counts each mask makes alive, so the loop below skips the rest.
+  uint64_t births[ HEX_NEIGHBORS + 1 ], survivals[ HEX_NEIGHBORS + 1 ];
+  for ( unsigned n = 0; n <= HEX_NEIGHBORS; ++n )
+  {
+    births[ n ] = ( rule.birth >> n ) & 1 ? ~uint64_t( 0 ) : 0;
+    survivals[ n ] = ( rule.survive >> n ) & 1 ? ~uint64_t( 0 ) : 0;
+  }
+
+  const unsigned height = src.height();
+  const unsigned words = src.wordsPerRow();
+  for ( unsigned y = 0; y < height; ++y )
+  {
+    const uint64_t* up = src.row( y ? y - 1 : height - 1 );     // wrap around y
+    const uint64_t* mid = src.row( y );
+    const uint64_t* down = src.row(( y + 1 < height ) ? y + 1 : 0 );
+    uint64_t* out = dst.row( y );
+    for ( unsigned w = 0; w < words; ++w )
+    {
+      // Bit sliced sum of the six neighbors, 0 to 6 in three planes.
+      const HexNeighbors cells( y, up, mid, down, w, words );
+      uint64_t s0, c0, s1, c1, twos, fours;
+      fullAdd( cells.west, cells.east, cells.above, s0, c0 );
+      fullAdd( cells.aboveSide, cells.below, cells.belowSide, s1, c1 );
+      const uint64_t ones = s0 ^ s1;
+      fullAdd( c0, c1, s0 & s1, twos, fours );
+
+      const uint64_t alive = mid[ w ];
+      uint64_t next = 0;
+      for ( unsigned n = 0; n <= HEX_NEIGHBORS; ++n )
+      {
+        const uint64_t wanted = ( births[ n ] & ~alive ) | ( survivals[ n ] & alive );
+        if ( wanted ) {
+          next |= wanted & ( n & 1 ? ones : ~ones ) & ( n & 2 ? twos : ~twos ) & ( n & 4 ? fours : ~fours );
+        }
+      }
+      out[ w ] = next;
+    }
+  }
+}
+
+void storeHexNeighborhood( const PackedBoard& previous, const PackedBoard& current, LifeBuffer& buffer )
+{
+  checkHex( previous );
+  buffer.clear();
+  const unsigned height = previous.height();
+  const unsigned words = previous.wordsPerRow();
+  std::vector< uint64_t > neighbors( words );
+  for ( unsigned y = 0; y < height; ++y )
+  {
+    const uint64_t* up = previous.row( y ? y - 1 : height - 1 );
+    const uint64_t* down = previous.row(( y + 1 < height ) ? y + 1 : 0 );
+    hexNeighborhoodRow( y, up, previous.row( y ), down, neighbors.data(), words );
+    const uint64_t* now = current.row( y );
+    for ( unsigned w = 0; w < words; ++w )
+    {
+      for ( uint64_t bits = neighbors[ w ]; bits; bits &= bits - 1 ) {
+        const unsigned bit = __builtin_ctzll( bits );
+        buffer[ LifeCoord( w * CELLS_PER_WORD + bit, y ) ].value = ( now[ w ] >> bit ) & 1;
+      }
+    }
+  }
+}
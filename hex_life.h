@@ -0,0 +1,52 @@
+///
+/// Game of life on a hexagonal grid, packed like the square one.
+/// (C) Andrew Brownbill 2019
+///
+
+#ifndef HEX_LIFE_H
+#define HEX_LIFE_H
+
+#include <cstdint>
+
+#include "life.h"
+#include "life_rule.h"
+#include "packed_board.h"
+
+// How the cells of a packed board touch.
+enum class CellGrid
+{
+  Square,       // Eight neighbors, advanceSim's
+  Hex           // Six, see advanceHex
+};
+
+// Hexagonal life, B2/S34, the usual hex rule.
+inline LifeRule hexLife() { return LifeRule( 1u << 2, ( 1u << 3 ) | ( 1u << 4 )); }
+
+// A hex grid in a PackedBoard, offset rows: odd rows sit half a cell to
+// the right of even ones, so cell x of an even row touches x - 1 and x
+// in the rows above and below, and of an odd row x and x + 1.  With its
+// two neighbors in the row itself that's every neighbor one shift from
+// a word of the row it's in, like the square board.  Wraps around in
+// both directions, which needs an even height to keep the offsets
+// lined up.
+//
+// The six neighbors of row y, up and down being the rows around it.
+void hexNeighborhoodRow(
+  unsigned y,
+  const uint64_t* up,
+  const uint64_t* mid,
+  const uint64_t* down,
+  uint64_t* out,
+  unsigned words );
+
+// Move src forward one generation into dst under rule, the neighbor
+// count bit sliced into three planes (it tops out at 6).  Throws
+// std::invalid_argument for odd heights and rules counting past 6
+// neighbors.
+void advanceHex( const PackedBoard& src, PackedBoard& dst, const LifeRule& rule );
+
+// storeNeighborhood for hex boards: the cells with one of their six
+// neighbors alive in previous, value 1 if they're alive in current.
+void storeHexNeighborhood( const PackedBoard& previous, const PackedBoard& current, LifeBuffer& buffer );
+
+#endif
@@ -0,0 +1,76 @@
+///
+/// Large zeroed buffers backed by huge pages where the OS has them.
+/// (C) Andrew Brownbill 2019
+///
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <utility>
+
+#include "huge_pages.h"
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+PageBuffer::PageBuffer( size_t size, bool hugePages ) :
+  words( nullptr ), count( size ), huge( hugePages ), advised( false )
+{
+  allocate();
+}
+
+PageBuffer::PageBuffer( const PageBuffer& other ) :
+  words( nullptr ), count( other.count ), huge( other.huge ), advised( false )
+{
+  allocate();
+  if ( count ) std::memcpy( words, other.words, bytes() );
+}
+
+PageBuffer::PageBuffer( PageBuffer&& other ) :
+  words( other.words ), count( other.count ), huge( other.huge ), advised( other.advised )
+{
+  other.words = nullptr;
+  other.count = 0;
+  other.advised = false;
+}
+
+PageBuffer& PageBuffer::operator=( PageBuffer other )
+{
+  swap( other );
+  return *this;
+}
+
+PageBuffer::~PageBuffer()
+{
+  std::free( words );
+}
+
+void PageBuffer::swap( PageBuffer& other )
+{
+  std::swap( words, other.words );
+  std::swap( count, other.count );
+  std::swap( huge, other.huge );
+  std::swap( advised, other.advised );
+}
+
+void PageBuffer::allocate()
+{
+  if ( !count ) return;
+#ifdef __linux__
+  if ( huge && bytes() >= HUGE_PAGE_BYTES )
+  {
+    // Round up to whole huge pages so the tail isn't left on small ones.
+    const size_t rounded = ( bytes() + HUGE_PAGE_BYTES - 1 ) / HUGE_PAGE_BYTES * HUGE_PAGE_BYTES;
+    void* memory = nullptr;
+    if ( posix_memalign( &memory, HUGE_PAGE_BYTES, rounded ) != 0 ) throw std::bad_alloc();
+    // Advise before touching, so the first faults can take huge pages.
+    advised = madvise( memory, rounded, MADV_HUGEPAGE ) == 0;
+    words = static_cast< uint64_t* >( memory );
+    std::memset( words, 0, bytes() );
+    return;
+  }
+#endif
+  words = static_cast< uint64_t* >( std::calloc( count, sizeof( uint64_t )));
+  if ( !words ) throw std::bad_alloc();
+}
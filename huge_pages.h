@@ -0,0 +1,54 @@
+///
+/// Large zeroed buffers backed by huge pages where the OS has them.
+/// (C) Andrew Brownbill 2019
+///
+
+#ifndef HUGE_PAGES_H
+#define HUGE_PAGES_H
+
+#include <cstddef>
+#include <cstdint>
+
+// 2 MB, the x86-64 and arm64 transparent huge page size.
+constexpr size_t HUGE_PAGE_BYTES = size_t( 2 ) << 20;
+
+// A zeroed array of words.  With huge set, buffers of a huge page or more
+// are aligned to one and madvise'd MADV_HUGEPAGE, so a big board takes a
+// TLB entry per 2 MB rather than per 4 KB.  That only happens on Linux
+// with transparent huge pages in "madvise" or "always" mode; elsewhere,
+// wasm included, it's a plain allocation and usingHugePages() is false.
+class PageBuffer
+{
+  public:
+
+  explicit PageBuffer( size_t words = 0, bool huge = true );
+  PageBuffer( const PageBuffer& other );
+  PageBuffer( PageBuffer&& other );
+  PageBuffer& operator=( PageBuffer other );
+  ~PageBuffer();
+
+  void swap( PageBuffer& other );
+
+  size_t size() const { return count; }
+  size_t bytes() const { return count * sizeof( uint64_t ); }
+  const uint64_t* data() const { return words; }
+  uint64_t* data() { return words; }
+  uint64_t operator[]( size_t i ) const { return words[ i ]; }
+  uint64_t& operator[]( size_t i ) { return words[ i ]; }
+
+  bool hugeRequested() const { return huge; }
+  bool usingHugePages() const { return advised; }
+
+  private:
+
+  void allocate();
+
+  uint64_t* words;
+  size_t count;
+  bool huge;
+  bool advised;
+};
+
+inline void swap( PageBuffer& a, PageBuffer& b ) { a.swap( b ); }
+
+#endif
@@ -0,0 +1,324 @@
+///
+/// Continuous game of life, Lenia style, with FFT convolution.
+/// (C) Andrew Brownbill 2019
+///
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+
+#include "lenia.h"
+
+constexpr unsigned Lenia::DIRECT_MAX_RADIUS;
+
+// Rows or columns an FFT call takes, the lanes of a Vec4.
+constexpr unsigned LANES = 4;
+
+static inline Vec4 load4( const float* p )
+{
+  Vec4 v;
+  std::memcpy( &v, p, sizeof( v ));
+  return v;
+}
+
+static inline void store4( float* p, Vec4 v )
+{
+  std::memcpy( p, &v, sizeof( v ));
+}
+
+// Lenia's kernel shell at r, 0 to 1 radii out: a smooth bump, 1 at the
+// middle and 0 at both ends.
+static float shell( double r )
+{
+  return r <= 0 || r >= 1 ? 0.0f : float( std::exp( 4 - 1 / ( r * ( 1 - r ))));
+}
+
+Lenia::Lenia( unsigned width, unsigned height, const LeniaParams& params, unsigned threads,
+              Convolution convolution ) :
+  xSize( width ), ySize( height ), leniaParams( params ),
+  fft( convolution == Convolution::Fft ||
+       ( convolution == Convolution::Auto && params.radius > DIRECT_MAX_RADIUS )),
+  generations( 0 ), cells( size_t( width ) * height ), job( nullptr ), stopping( false ),
+  start( std::max( 1u, std::min( threads, std::min( width, height ) / LANES ))),
+  done( std::max( 1u, std::min( threads, std::min( width, height ) / LANES )))
+{
+  if ( width % LANES || height % LANES ) throw std::invalid_argument( "Lenia sizes must be multiples of 4" );
+  if ( params.radius == 0 || width <= 2 * params.radius || height <= 2 * params.radius ) {
+    throw std::invalid_argument( "Lenia radius must be non zero and under half the world" );
+  }
+  const unsigned bands = std::max( 1u, std::min( threads, std::min( width, height ) / LANES ));
+  scratch.resize( bands );
+  for ( Scratch& s : scratch )
+  {
+    const unsigned longest = std::max( width, height );
+    s.re.resize( longest );
+    s.im.resize( longest );
+    s.work.resize( 2 * size_t( longest ));
+  }
+
+  // The kernel, normalized so the average of a world of 1s is 1.
+  const int radius = int( params.radius );
+  double total = 0;
+  for ( int dy = -radius; dy <= radius; ++dy ) {
+    for ( int dx = -radius; dx <= radius; ++dx )
+    {
+      const float weight = shell( std::sqrt( double( dx * dx + dy * dy )) / radius );
+      if ( weight <= 0 ) continue;
+      taps.push_back( Tap{ dx, dy, weight } );
+      total += weight;
+    }
+  }
+  for ( Tap& tap : taps ) tap.weight = float( tap.weight / total );
+
+  if ( fft )
+  {
+    rowFft.reset( new Fft( width ));
+    columnFft.reset( new Fft( height ));
+    spectrumRe.resize( cells.size() );
+    spectrumIm.resize( cells.size() );
+
+    // Transform the kernel the way forwardRows and convolveColumns do the
+    // world, on this thread, before there are others.  The inverse isn't
+    // scaled, so that goes in here.
+    for ( const Tap& tap : taps )
+    {
+      const unsigned x = unsigned( tap.dx + int( width )) % width;
+      const unsigned y = unsigned( tap.dy + int( height )) % height;
+      cells[ size_t( y ) * width + x ] = tap.weight / float( size_t( width ) * height );
+    }
+    forwardRows( 0 );
+    Scratch& s = scratch[ 0 ];
+    for ( unsigned c = 0; c < width; c += LANES )
+    {
+      for ( unsigned y = 0; y < height; ++y )
+      {
+        s.re[ y ] = load4( &spectrumRe[ size_t( y ) * width + c ] );
+        s.im[ y ] = load4( &spectrumIm[ size_t( y ) * width + c ] );
+      }
+      columnFft->forward( s.re.data(), s.im.data(), s.work.data() );
+      for ( unsigned y = 0; y < height; ++y ) store4( &spectrumRe[ size_t( y ) * width + c ], s.re[ y ] );
+    }
+    kernelSpectrum = spectrumRe;
+    std::fill( cells.begin(), cells.end(), 0.0f );
+    taps.clear();
+  }
+  else
+  {
+    averages.resize( cells.size() );
+    for ( Scratch& s : scratch ) s.padded.resize( width + 2 * params.radius );
+  }
+
+  // The calling thread runs band 0.
+  for ( unsigned id = 1; id < bands; ++id )
+  {
+    workers.emplace_back( &Lenia::workerLoop, this, id );
+  }
+}
+
+Lenia::~Lenia()
+{
+  stopping = true;
+  if ( !workers.empty() ) start.wait();
+  for ( auto& worker : workers ) worker.join();
+}
+
+void Lenia::seedPatches( unsigned count, unsigned seed )
+{
+  std::mt19937 rng( seed );
+  std::uniform_real_distribution< float > value( 0.0f, 1.0f );
+  std::fill( cells.begin(), cells.end(), 0.0f );
+  const unsigned side = 4 * leniaParams.radius;
+  for ( unsigned i = 0; i < count; ++i )
+  {
+    const unsigned left = rng() % xSize;
+    const unsigned top = rng() % ySize;
+    for ( unsigned y = 0; y < side; ++y ) {
+      for ( unsigned x = 0; x < side; ++x ) row(( top + y ) % ySize )[ ( left + x ) % xSize ] = value( rng );
+    }
+  }
+}
+
+void Lenia::advance()
+{
+  if ( fft )
+  {
+    everyThread( &Lenia::forwardRows );
+    everyThread( &Lenia::convolveColumns );
+    everyThread( &Lenia::inverseRowsAndGrow );
+  }
+  else
+  {
+    everyThread( &Lenia::averageDirect );
+    everyThread( &Lenia::growDirect );
+  }
+  ++generations;
+}
+
+void Lenia::everyThread( void (Lenia::*work)( unsigned ))
+{
+  job = work;
+  if ( !workers.empty() ) start.wait();
+  ( this->*job )( 0 );
+  if ( !workers.empty() ) done.wait();
+}
+
+void Lenia::workerLoop( unsigned id )
+{
+  for (;;)
+  {
+    start.wait();
+    if ( stopping ) return;
+    ( this->*job )( id );
+    done.wait();
+  }
+}
+
+void Lenia::band( unsigned id, unsigned count, unsigned& first, unsigned& last ) const
+{
+  const size_t groups = count / LANES;
+  first = unsigned( groups * id / threads() ) * LANES;
+  last = unsigned( groups * ( id + 1 ) / threads() ) * LANES;
+}
+
+void Lenia::forwardRows( unsigned id )
+{
+  Scratch& s = scratch[ id ];
+  unsigned first, last;
+  band( id, ySize, first, last );
+  for ( unsigned y = first; y < last; y += LANES )
+  {
+    for ( unsigned x = 0; x < xSize; ++x )
+    {
+      s.re[ x ] = Vec4{ row( y )[ x ], row( y + 1 )[ x ], row( y + 2 )[ x ], row( y + 3 )[ x ] };
+      s.im[ x ] = Vec4{};
+    }
+    rowFft->forward( s.re.data(), s.im.data(), s.work.data() );
+    for ( unsigned lane = 0; lane < LANES; ++lane )
+    {
+      float* re = &spectrumRe[ size_t( y + lane ) * xSize ];
+      float* im = &spectrumIm[ size_t( y + lane ) * xSize ];
+      for ( unsigned x = 0; x < xSize; ++x )
+      {
+        re[ x ] = s.re[ x ][ lane ];
+        im[ x ] = s.im[ x ][ lane ];
+      }
+    }
+  }
+}
+
+void Lenia::convolveColumns( unsigned id )
+{
+  Scratch& s = scratch[ id ];
+  unsigned first, last;
+  band( id, xSize, first, last );
+  for ( unsigned c = first; c < last; c += LANES )
+  {
+    for ( unsigned y = 0; y < ySize; ++y )
+    {
+      s.re[ y ] = load4( &spectrumRe[ size_t( y ) * xSize + c ] );
+      s.im[ y ] = load4( &spectrumIm[ size_t( y ) * xSize + c ] );
+    }
+    columnFft->forward( s.re.data(), s.im.data(), s.work.data() );
+    for ( unsigned y = 0; y < ySize; ++y )
+    {
+      const Vec4 k = load4( &kernelSpectrum[ size_t( y ) * xSize + c ] );
+      s.re[ y ] *= k;
+      s.im[ y ] *= k;
+    }
+    columnFft->inverse( s.re.data(), s.im.data(), s.work.data() );
+    for ( unsigned y = 0; y < ySize; ++y )
+    {
+      store4( &spectrumRe[ size_t( y ) * xSize + c ], s.re[ y ] );
+      store4( &spectrumIm[ size_t( y ) * xSize + c ], s.im[ y ] );
+    }
+  }
+}
+
+void Lenia::inverseRowsAndGrow( unsigned id )
+{
+  Scratch& s = scratch[ id ];
+  unsigned first, last;
+  band( id, ySize, first, last );
+  for ( unsigned y = first; y < last; y += LANES )
+  {
+    const float* re[ LANES ], * im[ LANES ];
+    for ( unsigned lane = 0; lane < LANES; ++lane )
+    {
+      re[ lane ] = &spectrumRe[ size_t( y + lane ) * xSize ];
+      im[ lane ] = &spectrumIm[ size_t( y + lane ) * xSize ];
+    }
+    for ( unsigned x = 0; x < xSize; ++x )
+    {
+      s.re[ x ] = Vec4{ re[ 0 ][ x ], re[ 1 ][ x ], re[ 2 ][ x ], re[ 3 ][ x ] };
+      s.im[ x ] = Vec4{ im[ 0 ][ x ], im[ 1 ][ x ], im[ 2 ][ x ], im[ 3 ][ x ] };
+    }
+    rowFft->inverse( s.re.data(), s.im.data(), s.work.data() );
+    for ( unsigned lane = 0; lane < LANES; ++lane )
+    {
+      float* out = row( y + lane );
+      for ( unsigned x = 0; x < xSize; ++x ) out[ x ] = grow( out[ x ], s.re[ x ][ lane ] );
+    }
+  }
+}
+
+void Lenia::averageDirect( unsigned id )
+{
+  Scratch& s = scratch[ id ];
+  const unsigned radius = leniaParams.radius;
+  unsigned first, last;
+  band( id, ySize, first, last );
+  for ( unsigned y = first; y < last; ++y )
+  {
+    float* out = &averages[ size_t( y ) * xSize ];
+    std::fill( out, out + xSize, 0.0f );
+
+    // The taps come a kernel row at a time; pad each source row once,
+    // wrapped around x, so the taps along it run without wrapping.
+    int paddedRow = -int( radius ) - 1;
+    for ( const Tap& tap : taps )
+    {
+      if ( tap.dy != paddedRow )
+      {
+        paddedRow = tap.dy;
+        const float* in = row( unsigned( int( y ) + tap.dy + int( ySize )) % ySize );
+        std::copy( in + xSize - radius, in + xSize, s.padded.begin() );
+        std::copy( in, in + xSize, s.padded.begin() + radius );
+        std::copy( in, in + radius, s.padded.begin() + radius + xSize );
+      }
+      const float* from = &s.padded[ size_t( int( radius ) + tap.dx ) ];
+      const float weight = tap.weight;
+      for ( unsigned x = 0; x < xSize; ++x ) out[ x ] += weight * from[ x ];
+    }
+  }
+}
+
+void Lenia::growDirect( unsigned id )
+{
+  unsigned first, last;
+  band( id, ySize, first, last );
+  for ( unsigned y = first; y < last; ++y )
+  {
+    float* out = row( y );
+    const float* average = &averages[ size_t( y ) * xSize ];
+    for ( unsigned x = 0; x < xSize; ++x ) out[ x ] = grow( out[ x ], average[ x ] );
+  }
+}
+
+float Lenia::grow( float value, float average ) const
+{
+  const float d = ( average - leniaParams.mu ) / leniaParams.sigma;
+  const float growth = 2 * std::exp( -0.5f * d * d ) - 1;
+  return std::min( 1.0f, std::max( 0.0f, value + leniaParams.dt * growth ));
+}
+
+void Lenia::memoryUsage( std::vector< MemoryUse >& report ) const
+{
+  size_t bytes = ( cells.capacity() + spectrumRe.capacity() + spectrumIm.capacity() + kernelSpectrum.capacity() +
+                   averages.capacity() ) * sizeof( float ) + taps.capacity() * sizeof( Tap );
+  for ( const Scratch& s : scratch ) {
+    bytes += ( s.re.capacity() + s.im.capacity() + s.work.capacity() ) * sizeof( Vec4 ) + s.padded.capacity() * sizeof( float );
+  }
+  report.push_back( MemoryUse{ "lenia", bytes } );
+}
@@ -0,0 +1,145 @@
+///
+/// Continuous game of life, Lenia style, with FFT convolution.
+/// (C) Andrew Brownbill 2019
+///
+
+#ifndef LENIA_H
+#define LENIA_H
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "barrier.h"
+#include "fft.h"
+#include "memory_budget.h"
+
+// What a Lenia world runs under.  Every cell holds a value from 0 to 1.
+// Each step it sees the average of the cells around it, weighted by a
+// ring radius cells out, peaking halfway, and grows by dt times
+// 2 e^( -( average - mu )^2 / 2 sigma^2 ) - 1, clipped back to 0 to 1.
+// The defaults are the ones Orbium, Lenia's glider, lives under.
+class LeniaParams
+{
+  public:
+
+  unsigned radius = 13;
+  float mu = 0.15f;
+  float sigma = 0.015f;
+  float dt = 0.1f;
+};
+
+// How the neighborhood average is worked out.  Directly it's a multiply
+// per cell in the ring, about 3 radius^2, for every cell.  Through the
+// FFT it's a transform of the whole world there and back, about
+// 10 log2( cells ) a cell whatever the radius, with the kernel's
+// transform made once.  Auto takes the direct path up to
+// Lenia::DIRECT_MAX_RADIUS, where gol_bench's lenia suite finds them
+// crossing.
+enum class Convolution
+{
+  Auto,
+  Fft,
+  Direct
+};
+
+// A width x height torus of floats stepped by threads, each on a band of
+// rows and then of columns, the calling thread taking the first band,
+// the others waiting on barriers between passes like ParallelEngine's.
+// Width and height must be multiples of 4, the FFTs run four rows or
+// columns at a time, and more than twice the radius.
+class Lenia : public MemoryClient
+{
+  public:
+
+  static constexpr unsigned DIRECT_MAX_RADIUS = 3;
+
+  Lenia( unsigned width, unsigned height, const LeniaParams& params, unsigned threads,
+         Convolution convolution = Convolution::Auto );
+  Lenia( const Lenia& ) = delete;
+  Lenia& operator=( const Lenia& ) = delete;
+  ~Lenia();
+
+  unsigned width() const { return xSize; }
+  unsigned height() const { return ySize; }
+  const LeniaParams& params() const { return leniaParams; }
+  unsigned threads() const { return unsigned( workers.size() ) + 1; }
+  bool usesFft() const { return fft; }
+  uint64_t generation() const { return generations; }
+
+  float* row( unsigned y ) { return &cells[ size_t( y ) * xSize ]; }
+  const float* row( unsigned y ) const { return &cells[ size_t( y ) * xSize ]; }
+
+  // Scatter count squares, four radii across, of random values over an
+  // empty world.
+  void seedPatches( unsigned count, unsigned seed );
+
+  void advance();
+
+  void memoryUsage( std::vector< MemoryUse >& report ) const override;
+
+  private:
+
+  // Run job( thread id ) on every thread, back when they're all done.
+  void everyThread( void (Lenia::*job)( unsigned ));
+  void workerLoop( unsigned id );
+
+  // The rows or columns of a band, [ first, last ) in steps of four.
+  void band( unsigned id, unsigned count, unsigned& first, unsigned& last ) const;
+
+  // FFT passes: rows there, columns there and back times the kernel,
+  // rows back and grow.
+  void forwardRows( unsigned id );
+  void convolveColumns( unsigned id );
+  void inverseRowsAndGrow( unsigned id );
+
+  // Direct passes: the average, then grow.
+  void averageDirect( unsigned id );
+  void growDirect( unsigned id );
+
+  // Step a cell given its neighborhood average.
+  float grow( float value, float average ) const;
+
+  // Per thread scratch for four rows or columns.
+  class Scratch
+  {
+    public:
+    std::vector< Vec4 > re, im, work;
+    std::vector< float > padded;
+  };
+
+  unsigned xSize;
+  unsigned ySize;
+  LeniaParams leniaParams;
+  bool fft;
+  uint64_t generations;
+  std::vector< float > cells;
+
+  // FFT: the world's transform, the kernel's (real, the kernel being
+  // symmetric) and the transforms along each axis.
+  std::vector< float > spectrumRe;
+  std::vector< float > spectrumIm;
+  std::vector< float > kernelSpectrum;
+  std::unique_ptr< Fft > rowFft;
+  std::unique_ptr< Fft > columnFft;
+
+  // Direct: the kernel's taps, row by row, and the averages.
+  class Tap
+  {
+    public:
+    int dx;
+    int dy;
+    float weight;
+  };
+  std::vector< Tap > taps;
+  std::vector< float > averages;
+
+  std::vector< Scratch > scratch;
+  void (Lenia::*job)( unsigned );
+  bool stopping;
+  Barrier start;
+  Barrier done;
+  std::vector< std::thread > workers;
+};
+
+#endif
@@ -0,0 +1,91 @@
+///
+/// Game of life simulation core.
+/// (C) Andrew Brownbill 2019
+///
+
+#include "life.h"
+
+// A Glider Gun
+const Pattern gliderGun = {
+  "                         X             ",
+  "                       X X             ",
+  "             XX      XX            XX  ",
+  "            X   X    XX            XX  ",
+  " XX        X     X   XX                ",
+  " XX        X   X XX    X X             ",
+  "           X     X       X             ",
+  "            X   X                      ",
+  "             XX                        ",
+};
+
+// Move the game forward one iteration.
+void advanceSim( LifeDBuffer &dbuffer )
+{
+  // Swap old for new.
+  std::swap( dbuffer.first, dbuffer.second );
+
+  // Clear out the new buffer.
+  dbuffer.first.clear();
+
+  // Figure out hold many neighbors each cell has.
+  for ( const auto& i : dbuffer.second )
+  {
+    if ( i.second.value == 0 ) continue;
+    const LifeCoord& c = i.first;
+    for ( int x = -1; x <=1; ++x ) {
+      for ( int y = -1; y <=1; ++y ) {
+        if ( x !=0 || y != 0 ) {    // I can't be a neighbor of myself
+          const int xc = (x+c.first  + X_GRID) % X_GRID; // wrap around x
+          const int yc = (y+c.second + Y_GRID) % Y_GRID; // wrap around y
+          dbuffer.first[ LifeCoord( xc, yc )].value += 1;
+        }
+      }
+    }
+  }
+
+  // Apply the game of life rules to any cells with neighbors from
+  // the old buffer.
+  for ( auto& i : dbuffer.first )
+  {
+    if ( i.second.value <= 1 ) i.second.value = 0;         // Starve
+    else if ( i.second.value == 3 ) i.second.value = 1;    // Expand
+    else if ( i.second.value >= 4 ) i.second.value = 0;    // Overpopulate
+    else i.second.value = dbuffer.second[ i.first ].value; // Same as before
+  }
+}
+
+void advanceAge( LifeBuffer& age, const LifeBuffer& current )
+{
+  std::vector< LifeCoord > toErase;   // Erase all cells not in current
+  for ( auto& cell : age )
+  {
+    if ( current.count( cell.first ) == 0 ) toErase.push_back( cell.first );
+  }
+  for ( const auto& key : toErase ) age.erase( key );
+
+  for ( const auto& cell : current )
+  {
+    age[ cell.first ].value += 1;
+  }
+}
+
+void dropPattern(
+  LifeBuffer& grid,           // Destination
+  const unsigned x,           // x target location
+  const unsigned y,           // y target location
+  const Pattern& pattern,     // The pattern to write to that location
+  const unsigned int rotate ) // How should the pattern be rotated? (0-3).
+{
+  int yp=0;
+  for ( const auto& row : pattern )
+  {
+    int xp=0;
+    for ( char c : row ) {
+      const unsigned xc = ( x + xp + X_GRID ) % X_GRID;
+      const unsigned yc = ( y + yp + Y_GRID ) % Y_GRID;
+      grid[ LifeCoord( xc, yc ) ].value = (c == 'X') ? 1 : 0;
+      xp += ( rotate & 1 ) ? 1 : -1;
+    }
+    yp += ( rotate & 2 ) ? 1 : -1;
+  }
+}
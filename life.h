@@ -0,0 +1,75 @@
+///
+/// Game of life simulation core, shared by the web build and the
+/// native tools.
+/// (C) Andrew Brownbill 2019
+///
+
+#ifndef LIFE_H
+#define LIFE_H
+
+#include <utility>
+#include <unordered_map>
+#include <vector>
+#include <string>
+
+// X and Y screen resolution
+constexpr int X_SCREEN=1024;
+constexpr int Y_SCREEN=768;
+
+// For bigger game of life cells
+constexpr int PIXEL_PER_GRID=2;
+
+// Create the game of life play board.
+constexpr int X_GRID=X_SCREEN/PIXEL_PER_GRID;
+constexpr int Y_GRID=Y_SCREEN/PIXEL_PER_GRID;
+
+// Game of life co-ordinate.  X = first, Y = second.
+using LifeCoord = std::pair<unsigned,unsigned>;
+
+// For making patterns using ASCII art.
+using Pattern = std::vector< std::string >;
+
+// A Glider Gun
+extern const Pattern gliderGun;
+
+// Hash function for a game of life coordinate.
+namespace std {
+  template<>
+  struct hash<LifeCoord>
+  {
+    std::size_t operator()(const LifeCoord& k) const {
+      return hash<unsigned>()(k.first ^ (k.second << 16));
+    }
+  };
+}
+
+// A simple game of life cell state. Defaults to 0
+class CellState
+{
+  public:
+
+  CellState(void) { value = 0; }
+  unsigned value;
+};
+
+// The game of life buffer.  Maps coordinates to cell states.
+using LifeBuffer = std::unordered_map<LifeCoord,CellState>;
+
+// We need a double buffer to build the next state.
+using LifeDBuffer = std::pair<LifeBuffer,LifeBuffer>;
+
+// Move the game forward one iteration.
+void advanceSim( LifeDBuffer &dbuffer );
+
+// Age every cell in current by one, forget cells that are gone.
+void advanceAge( LifeBuffer& age, const LifeBuffer& current );
+
+// Write an ASCII art pattern into the grid.
+void dropPattern(
+  LifeBuffer& grid,           // Destination
+  const unsigned x,           // x target location
+  const unsigned y,           // y target location
+  const Pattern& pattern,     // The pattern to write to that location
+  const unsigned int rotate );// How should the pattern be rotated? (0-3).
+
+#endif
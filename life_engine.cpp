@@ -0,0 +1,544 @@
+///
+/// Interchangeable game of life engines for the web page.
+/// (C) Andrew Brownbill 2019
+///
+
+#include <algorithm>
+#include <thread>
+
+#include "life_engine.h"
+#include "lut_engine.h"
+#include "packed_simd.h"
+#include "rule_compiler.h"
+
+// Give back the cells() copy the packed engines keep.  The next cells()
+// rebuilds it from the boards.
+static size_t trimExport( LifeBuffer& buffer, bool& bufferStale )
+{
+  const size_t freed = memoryUsed( buffer );
+  LifeBuffer().swap( buffer );
+  bufferStale = true;
+  return freed;
+}
+
+void HashEngine::load( const LifeBuffer& buffer )
+{
+  life.first = buffer;
+  life.second.clear();
+}
+
+void HashEngine::load( const PackedBoard& board )
+{
+  board.store( life.first );
+  life.second.clear();
+}
+
+void HashEngine::advance()
+{
+  advanceSim( life );
+}
+
+size_t HashEngine::population()
+{
+  size_t count = 0;
+  for ( const auto& i : life.first ) count += i.second.value ? 1 : 0;
+  return count;
+}
+
+void HashEngine::memoryUsage( std::vector< MemoryUse >& report ) const
+{
+  report.push_back( MemoryUse{ "board", memoryUsed( life.first ) + memoryUsed( life.second ) } );
+}
+
+PackedEngine::PackedEngine( const char* name, Kernel engineKernel ) :
+  engineName( name ), kernel( engineKernel ),
+  current( X_GRID, Y_GRID ), previous( X_GRID, Y_GRID ), bufferStale( true )
+{
+}
+
+void PackedEngine::load( const LifeBuffer& cells )
+{
+  current.load( cells );
+  previous = current;
+
+  // There's no previous generation to work the neighborhood out from,
+  // but cells already has it.
+  buffer = cells;
+  bufferStale = false;
+}
+
+void PackedEngine::load( const PackedBoard& board )
+{
+  current = board;
+  previous = current;
+  bufferStale = true;
+}
+
+void PackedEngine::advance()
+{
+  std::swap( current, previous );
+  kernel( previous, current );
+  bufferStale = true;
+}
+
+const LifeBuffer& PackedEngine::cells()
+{
+  if ( bufferStale ) storeNeighborhood( previous, current, buffer );
+  bufferStale = false;
+  return buffer;
+}
+
+void PackedEngine::memoryUsage( std::vector< MemoryUse >& report ) const
+{
+  report.push_back( MemoryUse{ "board", current.memoryUsed() + previous.memoryUsed() } );
+  report.push_back( MemoryUse{ "export", memoryUsed( buffer ) } );
+}
+
+size_t PackedEngine::trimMemory( size_t )
+{
+  return trimExport( buffer, bufferStale );
+}
+
+RuleEngine::RuleEngine( const LifeRule& rule ) :
+  lifeRule( rule ), circuit( RuleCircuit::synthesize( rule )), kernel( linkRuleKernel( rule )),
+  engineName( "rule " + rule.toString() + ( kernel ? " compiled" : "" )),
+  current( X_GRID, Y_GRID ), previous( X_GRID, Y_GRID ), bufferStale( true )
+{
+}
+
+void RuleEngine::load( const LifeBuffer& cells )
+{
+  current.load( cells );
+  previous = current;
+  buffer = cells;
+  bufferStale = false;
+}
+
+void RuleEngine::load( const PackedBoard& board )
+{
+  current = board;
+  previous = current;
+  bufferStale = true;
+}
+
+void RuleEngine::advance()
+{
+  std::swap( current, previous );
+  if ( kernel ) advanceRule( previous, current, kernel );
+  else advanceCircuit( previous, current, circuit );
+  bufferStale = true;
+}
+
+const LifeBuffer& RuleEngine::cells()
+{
+  if ( bufferStale ) storeNeighborhood( previous, current, buffer );
+  bufferStale = false;
+  return buffer;
+}
+
+void RuleEngine::memoryUsage( std::vector< MemoryUse >& report ) const
+{
+  report.push_back( MemoryUse{ "board", current.memoryUsed() + previous.memoryUsed() } );
+  report.push_back( MemoryUse{ "export", memoryUsed( buffer ) } );
+}
+
+size_t RuleEngine::trimMemory( size_t )
+{
+  return trimExport( buffer, bufferStale );
+}
+
+HexEngine::HexEngine( const LifeRule& rule ) :
+  lifeRule( rule ), engineName( "hex " + rule.toString() ),
+  current( X_GRID, Y_GRID ), previous( X_GRID, Y_GRID ), bufferStale( true )
+{
+  // Fail here rather than on the first step.
+  advanceHex( previous, current, lifeRule );
+}
+
+void HexEngine::load( const LifeBuffer& cells )
+{
+  current.load( cells );
+  previous = current;
+  bufferStale = true;
+}
+
+void HexEngine::load( const PackedBoard& board )
+{
+  current = board;
+  previous = current;
+  bufferStale = true;
+}
+
+void HexEngine::advance()
+{
+  std::swap( current, previous );
+  advanceHex( previous, current, lifeRule );
+  bufferStale = true;
+}
+
+const LifeBuffer& HexEngine::cells()
+{
+  if ( bufferStale ) storeHexNeighborhood( previous, current, buffer );
+  bufferStale = false;
+  return buffer;
+}
+
+void HexEngine::memoryUsage( std::vector< MemoryUse >& report ) const
+{
+  report.push_back( MemoryUse{ "board", current.memoryUsed() + previous.memoryUsed() } );
+  report.push_back( MemoryUse{ "export", memoryUsed( buffer ) } );
+}
+
+size_t HexEngine::trimMemory( size_t )
+{
+  return trimExport( buffer, bufferStale );
+}
+
+ThreadedEngine::ThreadedEngine( unsigned threads ) :
+  bands( X_GRID, Y_GRID, threads, 1 ),
+  current( X_GRID, Y_GRID ), previous( X_GRID, Y_GRID ), bufferStale( true )
+{
+}
+
+void ThreadedEngine::load( const LifeBuffer& cells )
+{
+  current.load( cells );
+  previous = current;
+  bands.load( current );
+  buffer = cells;
+  bufferStale = false;
+}
+
+void ThreadedEngine::load( const PackedBoard& board )
+{
+  current = board;
+  previous = current;
+  bands.load( current );
+  bufferStale = true;
+}
+
+void ThreadedEngine::advance()
+{
+  std::swap( current, previous );
+  bands.advance( 1 );
+  bands.store( current );
+  bufferStale = true;
+}
+
+const LifeBuffer& ThreadedEngine::cells()
+{
+  if ( bufferStale ) storeNeighborhood( previous, current, buffer );
+  bufferStale = false;
+  return buffer;
+}
+
+void ThreadedEngine::memoryUsage( std::vector< MemoryUse >& report ) const
+{
+  report.push_back( MemoryUse{ "board", bands.memoryUsed() + current.memoryUsed() + previous.memoryUsed() } );
+  report.push_back( MemoryUse{ "export", memoryUsed( buffer ) } );
+}
+
+size_t ThreadedEngine::trimMemory( size_t )
+{
+  return trimExport( buffer, bufferStale );
+}
+
+OccupiedEngine::OccupiedEngine() :
+  current( X_GRID, Y_GRID ), previous( X_GRID, Y_GRID ), currentMap( X_GRID, Y_GRID ),
+  previousMap( X_GRID, Y_GRID ), near( X_GRID, Y_GRID ), bufferStale( true )
+{
+}
+
+void OccupiedEngine::rebuildMaps()
+{
+  currentMap.rebuild( current );
+  previousMap.rebuild( previous );
+}
+
+void OccupiedEngine::load( const LifeBuffer& cells )
+{
+  current.load( cells );
+  previous = current;
+  rebuildMaps();
+  buffer = cells;
+  bufferStale = false;
+}
+
+void OccupiedEngine::load( const PackedBoard& board )
+{
+  current = board;
+  previous = current;
+  rebuildMaps();
+  bufferStale = true;
+}
+
+void OccupiedEngine::advance()
+{
+  std::swap( current, previous );
+  std::swap( currentMap, previousMap );
+  advanceOccupied( previous, previousMap, current, currentMap, near );
+  bufferStale = true;
+}
+
+const LifeBuffer& OccupiedEngine::cells()
+{
+  if ( bufferStale ) storeNeighborhood( previous, current, buffer );
+  bufferStale = false;
+  return buffer;
+}
+
+void OccupiedEngine::memoryUsage( std::vector< MemoryUse >& report ) const
+{
+  report.push_back( MemoryUse{ "board", current.memoryUsed() + previous.memoryUsed() + currentMap.memoryUsed() +
+                                        previousMap.memoryUsed() + near.memoryUsed() } );
+  report.push_back( MemoryUse{ "export", memoryUsed( buffer ) } );
+}
+
+size_t OccupiedEngine::trimMemory( size_t )
+{
+  return trimExport( buffer, bufferStale );
+}
+
+InPlaceEngine::InPlaceEngine() :
+  board( X_GRID, Y_GRID ), ages( nullptr ), bufferStale( true )
+{
+}
+
+void InPlaceEngine::load( const LifeBuffer& cells )
+{
+  board.load( cells );
+  buffer = cells;
+  bufferStale = false;
+}
+
+void InPlaceEngine::load( const PackedBoard& start )
+{
+  board = start;
+  bufferStale = true;
+}
+
+void InPlaceEngine::advance()
+{
+  if ( ages ) {
+    advancePackedInPlace( board, rows, [this]( unsigned y, const uint64_t* up, const uint64_t* mid,
+                                               const uint64_t* down ) {
+      ages->advanceRow( y, up, mid, down );
+    });
+  }
+  else {
+    advancePackedInPlace( board, rows );
+  }
+  bufferStale = true;
+}
+
+const LifeBuffer& InPlaceEngine::cells()
+{
+  if ( !bufferStale ) return buffer;
+  buffer.clear();
+  std::vector< uint64_t > aged( board.wordsPerRow() );
+  for ( unsigned y = 0; y < board.height(); ++y )
+  {
+    const uint64_t* alive = board.row( y );
+    if ( ages ) ages->agedRow( y, aged.data() );
+    for ( unsigned w = 0; w < board.wordsPerRow(); ++w ) {
+      for ( uint64_t bits = alive[ w ] | ( ages ? aged[ w ] : 0 ); bits; bits &= bits - 1 )
+      {
+        const unsigned bit = __builtin_ctzll( bits );
+        buffer[ LifeCoord( w * CELLS_PER_WORD + bit, y ) ].value = ( alive[ w ] >> bit ) & 1;
+      }
+    }
+  }
+  bufferStale = false;
+  return buffer;
+}
+
+void InPlaceEngine::memoryUsage( std::vector< MemoryUse >& report ) const
+{
+  report.push_back( MemoryUse{ "board", board.memoryUsed() + rows.capacity() * sizeof( uint64_t ) } );
+  report.push_back( MemoryUse{ "export", memoryUsed( buffer ) } );
+}
+
+size_t InPlaceEngine::trimMemory( size_t )
+{
+  return trimExport( buffer, bufferStale );
+}
+
+BlockEngine::BlockEngine() :
+  blocks( X_GRID, Y_GRID ), next( X_GRID, Y_GRID ),
+  current( X_GRID, Y_GRID ), previous( X_GRID, Y_GRID ), bufferStale( true )
+{
+}
+
+void BlockEngine::load( const LifeBuffer& cells )
+{
+  current.load( cells );
+  previous = current;
+  blocks.load( current );
+  buffer = cells;
+  bufferStale = false;
+}
+
+void BlockEngine::load( const PackedBoard& board )
+{
+  current = board;
+  previous = current;
+  blocks.load( current );
+  bufferStale = true;
+}
+
+void BlockEngine::advance()
+{
+  std::swap( current, previous );
+  advanceBlocks( blocks, next );
+  std::swap( blocks, next );
+  blocks.store( current );
+  bufferStale = true;
+}
+
+const LifeBuffer& BlockEngine::cells()
+{
+  if ( bufferStale ) storeNeighborhood( previous, current, buffer );
+  bufferStale = false;
+  return buffer;
+}
+
+void BlockEngine::memoryUsage( std::vector< MemoryUse >& report ) const
+{
+  report.push_back( MemoryUse{ "board", blocks.memoryUsed() + next.memoryUsed() +
+                                        current.memoryUsed() + previous.memoryUsed() } );
+  report.push_back( MemoryUse{ "export", memoryUsed( buffer ) } );
+}
+
+size_t BlockEngine::trimMemory( size_t )
+{
+  return trimExport( buffer, bufferStale );
+}
+
+SortedEngine::SortedEngine() : life( X_GRID, Y_GRID ), bufferStale( true )
+{
+}
+
+void SortedEngine::load( const LifeBuffer& cells )
+{
+  PackedBoard board( X_GRID, Y_GRID );
+  board.load( cells );
+  life.load( board );
+  buffer = cells;
+  bufferStale = false;
+}
+
+void SortedEngine::load( const PackedBoard& board )
+{
+  life.load( board );
+  bufferStale = true;
+}
+
+void SortedEngine::advance()
+{
+  life.advance();
+  bufferStale = true;
+}
+
+const LifeBuffer& SortedEngine::cells()
+{
+  if ( bufferStale ) life.storeNeighborhood( buffer );
+  bufferStale = false;
+  return buffer;
+}
+
+void SortedEngine::memoryUsage( std::vector< MemoryUse >& report ) const
+{
+  report.push_back( MemoryUse{ "board", life.memoryUsed() } );
+  report.push_back( MemoryUse{ "export", memoryUsed( buffer ) } );
+}
+
+size_t SortedEngine::trimMemory( size_t )
+{
+  return trimExport( buffer, bufferStale );
+}
+
+ListEngine::ListEngine() : life( X_GRID, Y_GRID ), bufferStale( true )
+{
+}
+
+void ListEngine::load( const LifeBuffer& cells )
+{
+  PackedBoard board( X_GRID, Y_GRID );
+  board.load( cells );
+  life.load( board );
+  buffer = cells;
+  bufferStale = false;
+}
+
+void ListEngine::load( const PackedBoard& board )
+{
+  life.load( board );
+  bufferStale = true;
+}
+
+void ListEngine::advance()
+{
+  life.advance();
+  bufferStale = true;
+}
+
+const LifeBuffer& ListEngine::cells()
+{
+  if ( bufferStale ) life.storeNeighborhood( buffer );
+  bufferStale = false;
+  return buffer;
+}
+
+void ListEngine::memoryUsage( std::vector< MemoryUse >& report ) const
+{
+  report.push_back( MemoryUse{ "board", life.memoryUsed() } );
+  report.push_back( MemoryUse{ "export", memoryUsed( buffer ) } );
+}
+
+size_t ListEngine::trimMemory( size_t )
+{
+  return trimExport( buffer, bufferStale );
+}
+
+PlatformFeatures PlatformFeatures::probe()
+{
+  PlatformFeatures features;
+#if defined( __wasm_simd128__ ) || defined( __SSE2__ ) || defined( __ARM_NEON )
+  features.simd = true;
+#endif
+#if !defined( __EMSCRIPTEN__ ) || defined( __EMSCRIPTEN_PTHREADS__ )
+  features.threads = true;
+  features.cores = std::max( 1u, std::thread::hardware_concurrency() );
+#endif
+  return features;
+}
+
+std::vector< std::string > engineNames()
+{
+  std::vector< std::string > names = { "hash", "packed", "lut", "sorted", "list", "block", "inplace", "occupied" };
+  const PlatformFeatures features = PlatformFeatures::probe();
+  if ( features.simd ) names.push_back( "simd" );
+  if ( features.threads && features.cores > 1 ) names.push_back( "parallel" );
+  return names;
+}
+
+std::unique_ptr< LifeEngine > makeEngine( const std::string& name )
+{
+  const std::vector< std::string > names = engineNames();
+  if ( std::find( names.begin(), names.end(), name ) == names.end() ) return nullptr;
+
+  if ( name == "hash" ) return std::unique_ptr< LifeEngine >( new HashEngine );
+  if ( name == "packed" ) return std::unique_ptr< LifeEngine >( new PackedEngine( "packed", advancePacked ));
+  if ( name == "lut" ) return std::unique_ptr< LifeEngine >( new PackedEngine( "lut", advanceLut ));
+  if ( name == "sorted" ) return std::unique_ptr< LifeEngine >( new SortedEngine );
+  if ( name == "list" ) return std::unique_ptr< LifeEngine >( new ListEngine );
+  if ( name == "block" ) return std::unique_ptr< LifeEngine >( new BlockEngine );
+  if ( name == "inplace" ) return std::unique_ptr< LifeEngine >( new InPlaceEngine );
+  if ( name == "occupied" ) return std::unique_ptr< LifeEngine >( new OccupiedEngine );
+  if ( name == "simd" ) return std::unique_ptr< LifeEngine >( new PackedEngine( "simd", advancePackedSimd ));
+  if ( name == "parallel" ) {
+    const unsigned threads = std::min( PlatformFeatures::probe().cores, 8u );
+    return std::unique_ptr< LifeEngine >( new ThreadedEngine( threads ));
+  }
+  return nullptr;
+}
@@ -0,0 +1,374 @@
+///
+/// Interchangeable game of life engines for the web page.
+/// (C) Andrew Brownbill 2019
+///
+
+#ifndef LIFE_ENGINE_H
+#define LIFE_ENGINE_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "age_planes.h"
+#include "block_board.h"
+#include "hex_life.h"
+#include "life.h"
+#include "list_life.h"
+#include "memory_budget.h"
+#include "occupancy.h"
+#include "packed_board.h"
+#include "parallel_engine.h"
+#include "rule_kernel.h"
+#include "sorted_life.h"
+
+// A game of life engine on the X_GRID by Y_GRID torus.  Reports its
+// memory as "board" (the simulation state) and "export" (the cells()
+// copy some engines keep).
+class LifeEngine : public MemoryClient
+{
+  public:
+
+  virtual ~LifeEngine() {}
+
+  virtual const char* name() const = 0;
+
+  // Replace the board with the live cells in buffer.
+  virtual void load( const LifeBuffer& buffer ) = 0;
+
+  // Replace the board, without going through a hash map.  For start up.
+  virtual void load( const PackedBoard& board ) = 0;
+
+  // Move the game forward one iteration.
+  virtual void advance() = 0;
+
+  // Number of live cells.
+  virtual size_t population() = 0;
+
+  // The board in advanceSim's form: every cell that had a live neighbor
+  // last iteration, value 1 if it's alive now.  advanceAge and
+  // drawScreen work off this.
+  virtual const LifeBuffer& cells() = 0;
+
+  // The last two generations, for engines that keep them packed.  The
+  // page ages cells off these with AgePlanes rather than going through
+  // cells().
+  virtual const PackedBoard* currentBoard() const { return nullptr; }
+  virtual const PackedBoard* previousBoard() const { return nullptr; }
+
+  // The current generation in blocks, for engines that keep it that way,
+  // so the page can draw in the same order the engine steps.
+  virtual const BlockBoard* currentBlocks() const { return nullptr; }
+
+  // Which words of currentBoard() hold live cells, for engines that track
+  // it, so drawing can skip the empty ones.
+  virtual const Occupancy* currentOccupancy() const { return nullptr; }
+
+  // Age the cells in ages while stepping, for engines that don't keep the
+  // last generation around to age them from afterwards.  Returns false
+  // for engines that can't; nullptr stops it.
+  virtual bool trackAges( AgePlanes* ages ) { (void) ages; return false; }
+
+  // False for engines that have to step on the thread that made them,
+  // e.g. ones calling code linked in at run time, which the other
+  // threads' function tables don't have.
+  virtual bool stepsOnAnyThread() const { return true; }
+
+  // How the cells of currentBoard() touch, so the page ages and draws
+  // them to match.
+  virtual CellGrid grid() const { return CellGrid::Square; }
+};
+
+// The original hash map engine.
+class HashEngine : public LifeEngine
+{
+  public:
+
+  const char* name() const override { return "hash"; }
+  void load( const LifeBuffer& buffer ) override;
+  void load( const PackedBoard& board ) override;
+  void advance() override;
+  size_t population() override;
+  const LifeBuffer& cells() override { return life.first; }
+  void memoryUsage( std::vector< MemoryUse >& report ) const override;
+
+  private:
+  LifeDBuffer life;
+};
+
+// An engine that steps a packed board with a kernel like advancePacked.
+class PackedEngine : public LifeEngine
+{
+  public:
+
+  using Kernel = void (*)( const PackedBoard& src, PackedBoard& dst );
+
+  PackedEngine( const char* name, Kernel engineKernel );
+
+  const char* name() const override { return engineName; }
+  void load( const LifeBuffer& buffer ) override;
+  void load( const PackedBoard& board ) override;
+  void advance() override;
+  size_t population() override { return current.population(); }
+  const LifeBuffer& cells() override;
+  const PackedBoard* currentBoard() const override { return &current; }
+  const PackedBoard* previousBoard() const override { return &previous; }
+  void memoryUsage( std::vector< MemoryUse >& report ) const override;
+  size_t trimMemory( size_t bytes ) override;
+
+  private:
+  const char* engineName;
+  Kernel kernel;
+  PackedBoard current;
+  PackedBoard previous;
+  LifeBuffer buffer;      // cells(), rebuilt when stale
+  bool bufferStale;
+};
+
+// The packed board under any life-like rule.  Steps with a kernel
+// compiled for the rule where the build can link one at run time (see
+// linkRuleKernel), running the rule's circuit otherwise.  Not in engineNames(),
+// the other engines only know B3/S23; the page makes one for setRule.
+class RuleEngine : public LifeEngine
+{
+  public:
+
+  explicit RuleEngine( const LifeRule& rule );
+
+  const char* name() const override { return engineName.c_str(); }
+  void load( const LifeBuffer& buffer ) override;
+  void load( const PackedBoard& board ) override;
+  void advance() override;
+  size_t population() override { return current.population(); }
+  const LifeBuffer& cells() override;
+  const PackedBoard* currentBoard() const override { return &current; }
+  const PackedBoard* previousBoard() const override { return &previous; }
+  bool stepsOnAnyThread() const override { return kernel == nullptr; }
+  void memoryUsage( std::vector< MemoryUse >& report ) const override;
+  size_t trimMemory( size_t bytes ) override;
+
+  const LifeRule& rule() const { return lifeRule; }
+  RowKernel compiledKernel() const { return kernel; }
+
+  private:
+  LifeRule lifeRule;
+  RuleCircuit circuit;
+  RowKernel kernel;       // nullptr = advanceCircuit
+  std::string engineName;
+  PackedBoard current;
+  PackedBoard previous;
+  LifeBuffer buffer;
+  bool bufferStale;
+};
+
+// The packed board as a hex grid, see advanceHex, under a rule counting
+// six neighbors.  Not in engineNames(), it doesn't play the same game;
+// the page makes one for setHexRule.
+class HexEngine : public LifeEngine
+{
+  public:
+
+  explicit HexEngine( const LifeRule& rule = hexLife() );
+
+  const char* name() const override { return engineName.c_str(); }
+  void load( const LifeBuffer& buffer ) override;
+  void load( const PackedBoard& board ) override;
+  void advance() override;
+  size_t population() override { return current.population(); }
+  const LifeBuffer& cells() override;
+  const PackedBoard* currentBoard() const override { return &current; }
+  const PackedBoard* previousBoard() const override { return &previous; }
+  CellGrid grid() const override { return CellGrid::Hex; }
+  void memoryUsage( std::vector< MemoryUse >& report ) const override;
+  size_t trimMemory( size_t bytes ) override;
+
+  private:
+  LifeRule lifeRule;
+  std::string engineName;
+  PackedBoard current;
+  PackedBoard previous;
+  LifeBuffer buffer;
+  bool bufferStale;
+};
+
+// Bands of the board on several threads, see ParallelEngine.
+class ThreadedEngine : public LifeEngine
+{
+  public:
+
+  explicit ThreadedEngine( unsigned threads );
+
+  const char* name() const override { return "parallel"; }
+  void load( const LifeBuffer& buffer ) override;
+  void load( const PackedBoard& board ) override;
+  void advance() override;
+  size_t population() override { return current.population(); }
+  const LifeBuffer& cells() override;
+  const PackedBoard* currentBoard() const override { return &current; }
+  const PackedBoard* previousBoard() const override { return &previous; }
+  void memoryUsage( std::vector< MemoryUse >& report ) const override;
+  size_t trimMemory( size_t bytes ) override;
+
+  private:
+  ParallelEngine bands;
+  PackedBoard current;
+  PackedBoard previous;
+  LifeBuffer buffer;
+  bool bufferStale;
+};
+
+// The packed engine stepping only the words next to live ones, found
+// through summary bitmaps, see advanceOccupied.  For sparse boards.
+class OccupiedEngine : public LifeEngine
+{
+  public:
+
+  OccupiedEngine();
+
+  const char* name() const override { return "occupied"; }
+  void load( const LifeBuffer& buffer ) override;
+  void load( const PackedBoard& board ) override;
+  void advance() override;
+  size_t population() override { return ::population( current, currentMap ); }
+  const LifeBuffer& cells() override;
+  const PackedBoard* currentBoard() const override { return &current; }
+  const PackedBoard* previousBoard() const override { return &previous; }
+  const Occupancy* currentOccupancy() const override { return &currentMap; }
+  void memoryUsage( std::vector< MemoryUse >& report ) const override;
+  size_t trimMemory( size_t bytes ) override;
+
+  private:
+  void rebuildMaps();
+
+  PackedBoard current;
+  PackedBoard previous;
+  Occupancy currentMap;
+  Occupancy previousMap;
+  Occupancy near;
+  LifeBuffer buffer;
+  bool bufferStale;
+};
+
+// The packed engine stepping in place, with three rows of scratch rather
+// than a second board, see advancePackedInPlace.  There's no previous
+// generation to export from, so cells() takes the cells with a live
+// neighbor last generation from the tracked ages; untracked, it exports
+// just the live cells.
+class InPlaceEngine : public LifeEngine
+{
+  public:
+
+  InPlaceEngine();
+
+  const char* name() const override { return "inplace"; }
+  void load( const LifeBuffer& buffer ) override;
+  void load( const PackedBoard& board ) override;
+  void advance() override;
+  size_t population() override { return board.population(); }
+  const LifeBuffer& cells() override;
+  const PackedBoard* currentBoard() const override { return &board; }
+  bool trackAges( AgePlanes* planes ) override { ages = planes; return true; }
+  void memoryUsage( std::vector< MemoryUse >& report ) const override;
+  size_t trimMemory( size_t bytes ) override;
+
+  private:
+  PackedBoard board;
+  std::vector< uint64_t > rows;
+  AgePlanes* ages;
+  LifeBuffer buffer;
+  bool bufferStale;
+};
+
+// 8x8 blocks in Morton order, see BlockBoard.
+class BlockEngine : public LifeEngine
+{
+  public:
+
+  BlockEngine();
+
+  const char* name() const override { return "block"; }
+  void load( const LifeBuffer& buffer ) override;
+  void load( const PackedBoard& board ) override;
+  void advance() override;
+  size_t population() override { return current.population(); }
+  const LifeBuffer& cells() override;
+  const PackedBoard* currentBoard() const override { return &current; }
+  const PackedBoard* previousBoard() const override { return &previous; }
+  const BlockBoard* currentBlocks() const override { return &blocks; }
+  void memoryUsage( std::vector< MemoryUse >& report ) const override;
+  size_t trimMemory( size_t bytes ) override;
+
+  private:
+  BlockBoard blocks;
+  BlockBoard next;
+  PackedBoard current;    // blocks, row packed for ages and drawing
+  PackedBoard previous;
+  LifeBuffer buffer;
+  bool bufferStale;
+};
+
+// Live cells as a sorted key list, see SortedLife.  For sparse boards.
+class SortedEngine : public LifeEngine
+{
+  public:
+
+  SortedEngine();
+
+  const char* name() const override { return "sorted"; }
+  void load( const LifeBuffer& buffer ) override;
+  void load( const PackedBoard& board ) override;
+  void advance() override;
+  size_t population() override { return life.population(); }
+  const LifeBuffer& cells() override;
+  void memoryUsage( std::vector< MemoryUse >& report ) const override;
+  size_t trimMemory( size_t bytes ) override;
+
+  private:
+  SortedLife life;
+  LifeBuffer buffer;
+  bool bufferStale;
+};
+
+// Rows as sorted lists of live cells, see ListLife.  For sparse boards.
+class ListEngine : public LifeEngine
+{
+  public:
+
+  ListEngine();
+
+  const char* name() const override { return "list"; }
+  void load( const LifeBuffer& buffer ) override;
+  void load( const PackedBoard& board ) override;
+  void advance() override;
+  size_t population() override { return life.population(); }
+  const LifeBuffer& cells() override;
+  void memoryUsage( std::vector< MemoryUse >& report ) const override;
+  size_t trimMemory( size_t bytes ) override;
+
+  private:
+  ListLife life;
+  LifeBuffer buffer;
+  bool bufferStale;
+};
+
+// What this build can use.  In wasm this is fixed when the module is
+// compiled; the page loads the build that matches the browser.
+class PlatformFeatures
+{
+  public:
+
+  static PlatformFeatures probe();
+
+  bool simd = false;          // 128 bit vectors
+  bool threads = false;       // std::thread works
+  unsigned cores = 1;
+};
+
+// Names that makeEngine understands on this platform.
+std::vector< std::string > engineNames();
+
+// Make an engine by name.  Returns nullptr for unknown names and for
+// engines this platform can't run.
+std::unique_ptr< LifeEngine > makeEngine( const std::string& name );
+
+#endif
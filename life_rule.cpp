@@ -0,0 +1,64 @@
+///
+/// Life-like rules: which neighbor counts give birth and which survive.
+/// (C) Andrew Brownbill 2019
+///
+
+#include <cctype>
+#include <stdexcept>
+
+#include "life_rule.h"
+
+constexpr unsigned LifeRule::MAX_NEIGHBORS;
+
+static constexpr uint16_t ALL_COUNTS = ( 1u << ( LifeRule::MAX_NEIGHBORS + 1 )) - 1;
+
+LifeRule::LifeRule( uint16_t birthMask, uint16_t surviveMask ) : birth( birthMask ), survive( surviveMask )
+{
+  if (( birth | survive ) & ~ALL_COUNTS ) {
+    throw std::invalid_argument( "LifeRule neighbor counts go from 0 to 8" );
+  }
+}
+
+LifeRule LifeRule::parse( const std::string& text )
+{
+  uint16_t masks[ 2 ] = { 0, 0 };
+  bool seen[ 2 ] = { false, false };
+  uint16_t* mask = nullptr;
+  for ( char c : text )
+  {
+    const char upper = char( std::toupper( static_cast< unsigned char >( c )));
+    if ( upper == 'B' || upper == 'S' )
+    {
+      const unsigned part = upper == 'B' ? 0 : 1;
+      if ( seen[ part ] ) throw std::invalid_argument( "LifeRule::parse has two " + std::string( 1, upper ) + " parts in " + text );
+      seen[ part ] = true;
+      mask = &masks[ part ];
+    }
+    else if ( c == '/' && mask ) {
+      mask = nullptr;
+    }
+    else if ( c >= '0' && c <= '8' && mask ) {
+      *mask |= uint16_t( 1u << ( c - '0' ));
+    }
+    else {
+      throw std::invalid_argument( "LifeRule::parse expects B/S notation like B3/S23, not " + text );
+    }
+  }
+  if ( !seen[ 0 ] || !seen[ 1 ] ) {
+    throw std::invalid_argument( "LifeRule::parse expects B/S notation like B3/S23, not " + text );
+  }
+  return LifeRule( masks[ 0 ], masks[ 1 ] );
+}
+
+std::string LifeRule::toString() const
+{
+  std::string text = "B";
+  for ( unsigned n = 0; n <= MAX_NEIGHBORS; ++n ) {
+    if (( birth >> n ) & 1 ) text += char( '0' + n );
+  }
+  text += "/S";
+  for ( unsigned n = 0; n <= MAX_NEIGHBORS; ++n ) {
+    if (( survive >> n ) & 1 ) text += char( '0' + n );
+  }
+  return text;
+}
@@ -0,0 +1,45 @@
+///
+/// Life-like rules: which neighbor counts give birth and which survive.
+/// (C) Andrew Brownbill 2019
+///
+
+#ifndef LIFE_RULE_H
+#define LIFE_RULE_H
+
+#include <cstdint>
+#include <string>
+
+// A rule in B/S notation, e.g. B3/S23 for Conway's, B36/S23 for
+// HighLife.  Bit n of birth is set if a dead cell with n live neighbors
+// comes alive, bit n of survive if a live one with n stays alive.
+class LifeRule
+{
+  public:
+
+  static constexpr unsigned MAX_NEIGHBORS = 8;
+
+  LifeRule() : birth( 1u << 3 ), survive(( 1u << 2 ) | ( 1u << 3 )) {}
+  LifeRule( uint16_t birthMask, uint16_t surviveMask );
+
+  // Parse "B3/S23", case insensitive, either part may come first or be
+  // empty.  Throws std::invalid_argument on anything else.
+  static LifeRule parse( const std::string& text );
+
+  static LifeRule conway() { return LifeRule(); }
+
+  // Back to B/S notation.
+  std::string toString() const;
+
+  bool next( bool alive, unsigned neighbors ) const
+  {
+    return ((( alive ? survive : birth ) >> neighbors ) & 1 ) != 0;
+  }
+
+  bool operator==( const LifeRule& other ) const { return birth == other.birth && survive == other.survive; }
+  bool operator!=( const LifeRule& other ) const { return !( *this == other ); }
+
+  uint16_t birth;
+  uint16_t survive;
+};
+
+#endif
@@ -0,0 +1,165 @@
+///
+/// Multi process game of life over shared memory.
+/// (C) Andrew Brownbill 2019
+///
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include <pthread.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "life_shard.h"
+#include "life_slab.h"
+
+// Layout of the shared memory segment.  After the header come the
+// mailboxes, two per process (even and odd exchanges) each holding the
+// top edge then the bottom edge, then the result board.
+class SharedSegment
+{
+  public:
+
+  SharedSegment( unsigned processes, size_t edgeWords, size_t boardWords ) :
+    edge( edgeWords ),
+    mailboxWords( 2 * edgeWords ),
+    mailboxes( processes * 2 ),
+    bytes( headerBytes() + ( mailboxes * mailboxWords + boardWords ) * sizeof( uint64_t ))
+  {
+    base = mmap( nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0 );
+    if ( base == MAP_FAILED ) throw std::runtime_error( "mmap of shared segment failed" );
+
+    pthread_barrierattr_t attr;
+    pthread_barrierattr_init( &attr );
+    pthread_barrierattr_setpshared( &attr, PTHREAD_PROCESS_SHARED );
+    pthread_barrier_init( barrier(), &attr, processes );
+    pthread_barrierattr_destroy( &attr );
+  }
+  SharedSegment( const SharedSegment& ) = delete;
+  SharedSegment& operator=( const SharedSegment& ) = delete;
+  ~SharedSegment()
+  {
+    pthread_barrier_destroy( barrier() );
+    munmap( base, bytes );
+  }
+
+  pthread_barrier_t* barrier() { return static_cast<pthread_barrier_t*>( base ); }
+
+  uint64_t* topEdge( unsigned process, unsigned parity ) { return mailbox( process, parity ); }
+  uint64_t* bottomEdge( unsigned process, unsigned parity ) { return mailbox( process, parity ) + edge; }
+  uint64_t* board() { return mailbox( 0, 0 ) + mailboxes * mailboxWords; }
+
+  private:
+
+  static size_t headerBytes()
+  {
+    constexpr size_t ALIGN = 64;
+    return ( sizeof( pthread_barrier_t ) + ALIGN - 1 ) / ALIGN * ALIGN;
+  }
+
+  uint64_t* mailbox( unsigned process, unsigned parity )
+  {
+    uint64_t* first = reinterpret_cast<uint64_t*>( static_cast<char*>( base ) + headerBytes() );
+    return first + ( process * 2 + parity ) * mailboxWords;
+  }
+
+  size_t edge;
+  size_t mailboxWords;
+  size_t mailboxes;
+  size_t bytes;
+  void* base;
+};
+
+// The body of one worker process.
+static void runWorker(
+  const PackedBoard& board,   // Copy on write snapshot of the start state
+  SharedSegment& shared,
+  const ShardConfig& config,
+  unsigned id )
+{
+  const unsigned height = board.height();
+  const unsigned firstRow = unsigned( size_t( height ) * id / config.processes );
+  const unsigned lastRow = unsigned( size_t( height ) * ( id + 1 ) / config.processes );
+  const unsigned above = ( id + config.processes - 1 ) % config.processes;
+  const unsigned below = ( id + 1 ) % config.processes;
+
+  LifeSlab slab( board.width(), firstRow, lastRow - firstRow, config.halo );
+  slab.loadFrom( board );
+
+  unsigned done = 0;
+  for ( unsigned exchange = 0; done < config.generations; ++exchange )
+  {
+    // Mailboxes alternate between exchanges, so a neighbor still reading
+    // the last exchange never sees this one's edges.  Everyone is past
+    // the previous barrier, so the exchange before that is finished.
+    const unsigned parity = exchange & 1;
+    if ( exchange > 0 )
+    {
+      std::copy( slab.topEdge(), slab.topEdge() + slab.edgeWords(), shared.topEdge( id, parity ));
+      std::copy( slab.bottomEdge(), slab.bottomEdge() + slab.edgeWords(), shared.bottomEdge( id, parity ));
+      pthread_barrier_wait( shared.barrier() );
+      slab.setTopHalo( shared.bottomEdge( above, parity ));
+      slab.setBottomHalo( shared.topEdge( below, parity ));
+    }
+    const unsigned batch = std::min( config.halo, config.generations - done );
+    slab.advance( batch );
+    done += batch;
+  }
+
+  for ( unsigned y = 0; y < slab.rows(); ++y )
+  {
+    std::copy( slab.row( int( y )), slab.row( int( y )) + slab.wordsPerRow(),
+               shared.board() + size_t( firstRow + y ) * slab.wordsPerRow() );
+  }
+}
+
+bool runSharded( PackedBoard& board, const ShardConfig& config )
+{
+  if ( config.processes == 0 || board.height() / config.processes < config.halo ) {
+    throw std::invalid_argument( "runSharded needs at least halo rows per process" );
+  }
+  const size_t boardWords = size_t( board.height() ) * board.wordsPerRow();
+  SharedSegment shared( config.processes, size_t( config.halo ) * board.wordsPerRow(), boardWords );
+
+  std::vector<pid_t> workers;
+  for ( unsigned id = 0; id < config.processes; ++id )
+  {
+    const pid_t pid = fork();
+    if ( pid == 0 )
+    {
+      int status = 0;
+      try {
+        runWorker( board, shared, config, id );
+      }
+      catch ( ... ) {
+        status = 1;
+      }
+      _exit( status );
+    }
+    if ( pid < 0 ) break;
+    workers.push_back( pid );
+  }
+
+  // A worker that dies leaves the others stuck on the barrier, so take
+  // them all down.
+  bool ok = workers.size() == config.processes;
+  if ( !ok ) for ( pid_t pid : workers ) kill( pid, SIGTERM );
+  for ( size_t i = 0; i < workers.size(); ++i )
+  {
+    int status = 0;
+    const pid_t pid = wait( &status );
+    if ( pid < 0 ) break;
+    if ( !WIFEXITED( status ) || WEXITSTATUS( status ) != 0 )
+    {
+      if ( ok ) for ( pid_t other : workers ) kill( other, SIGTERM );
+      ok = false;
+    }
+  }
+
+  if ( ok ) std::copy( shared.board(), shared.board() + boardWords, board.row( 0 ));
+  return ok;
+}
@@ -0,0 +1,28 @@
+///
+/// Multi process game of life.  The torus is cut into horizontal slabs,
+/// one per worker process, and the processes swap halo rows through
+/// shared memory.  Linux only.
+/// (C) Andrew Brownbill 2019
+///
+
+#ifndef LIFE_SHARD_H
+#define LIFE_SHARD_H
+
+#include "packed_board.h"
+
+// How to split up a run.
+class ShardConfig
+{
+  public:
+
+  unsigned processes = 4;     // Worker processes, one slab each
+  unsigned halo = 1;          // Halo rows = generations per exchange
+  unsigned generations = 100; // Total generations to run
+};
+
+// Advance the board config.generations generations using worker
+// processes.  Every slab must be at least config.halo rows high.
+// Returns false if a worker process failed.
+bool runSharded( PackedBoard& board, const ShardConfig& config );
+
+#endif
@@ -0,0 +1,70 @@
+///
+/// A horizontal band of a packed board with halo rows.
+/// (C) Andrew Brownbill 2019
+///
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "life_slab.h"
+
+LifeSlab::LifeSlab( unsigned width, unsigned firstRow, unsigned rows, unsigned halo ) :
+  first( firstRow ), count( rows ), haloRows( halo ), words( width / CELLS_PER_WORD )
+{
+  if ( width == 0 || width % CELLS_PER_WORD != 0 ) {
+    throw std::invalid_argument( "LifeSlab width must be a non zero multiple of 64" );
+  }
+  if ( halo == 0 || rows < halo ) {
+    throw std::invalid_argument( "LifeSlab needs a halo of at least 1 and no more than rows" );
+  }
+  cells.resize( size_t( rows + 2 * halo ) * words );
+  scratch.resize( cells.size() );
+}
+
+void LifeSlab::setTopHalo( const uint64_t* aboveBottomEdge )
+{
+  std::copy( aboveBottomEdge, aboveBottomEdge + edgeWords(), row( -int( haloRows )));
+}
+
+void LifeSlab::setBottomHalo( const uint64_t* belowTopEdge )
+{
+  std::copy( belowTopEdge, belowTopEdge + edgeWords(), row( int( count )));
+}
+
+void LifeSlab::loadFrom( const PackedBoard& board )
+{
+  const long height = board.height();
+  for ( int y = -int( haloRows ); y < int( count + haloRows ); ++y )
+  {
+    const unsigned by = unsigned((( long( first ) + y ) % height + height ) % height );
+    std::copy( board.row( by ), board.row( by ) + words, row( y ));
+  }
+}
+
+void LifeSlab::storeTo( PackedBoard& board ) const
+{
+  for ( unsigned y = 0; y < count; ++y )
+  {
+    std::copy( row( int( y )), row( int( y )) + words, board.row(( first + y ) % board.height() ));
+  }
+}
+
+void LifeSlab::advance( unsigned generations )
+{
+  if ( generations > haloRows ) {
+    throw std::invalid_argument( "LifeSlab can't advance more generations than it has halo" );
+  }
+  const int top = -int( haloRows );
+  const int bottom = int( count + haloRows );
+  for ( unsigned g = 1; g <= generations; ++g )
+  {
+    // Each generation the rows next to the stale part of the halo
+    // become stale too, so the computed band shrinks by one each side.
+    for ( int y = top + int( g ); y < bottom - int( g ); ++y )
+    {
+      uint64_t* out = &scratch[ size_t( y - top ) * words ];
+      stepPackedRow( row( y - 1 ), row( y ), row( y + 1 ), out, words );
+    }
+    std::swap( cells, scratch );
+  }
+}
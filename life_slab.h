@@ -0,0 +1,64 @@
+///
+/// A horizontal band of a packed board with halo rows.
+/// (C) Andrew Brownbill 2019
+///
+
+#ifndef LIFE_SLAB_H
+#define LIFE_SLAB_H
+
+#include <cstdint>
+#include <vector>
+
+#include "packed_board.h"
+
+// A band of rows [firstRow, firstRow + rows) from a packed torus, plus
+// halo copies of the rows above and below it.  With a halo of k rows
+// the band can be advanced k generations without looking at anything
+// outside the slab; each generation the valid part of the halo shrinks
+// by one row.  Whoever owns the slab refills the halos before the next
+// batch, either from a shared board (threads) or from the neighbor's
+// edge rows (processes).
+class LifeSlab
+{
+  public:
+
+  LifeSlab( unsigned width, unsigned firstRow, unsigned rows, unsigned halo );
+
+  unsigned firstRow() const { return first; }
+  unsigned rows() const { return count; }
+  unsigned halo() const { return haloRows; }
+  unsigned wordsPerRow() const { return words; }
+
+  // Local row access, y in [-halo, rows + halo).
+  uint64_t* row( int y ) { return &cells[ size_t( y + int( haloRows )) * words ]; }
+  const uint64_t* row( int y ) const { return &cells[ size_t( y + int( haloRows )) * words ]; }
+
+  // The first and last halo() owned rows, stored contiguously.  These are
+  // what the neighbors need for their halos.
+  const uint64_t* topEdge() const { return row( 0 ); }
+  const uint64_t* bottomEdge() const { return row( int( count ) - int( haloRows )); }
+  size_t edgeWords() const { return size_t( haloRows ) * words; }
+
+  // Fill the halos from the neighbors' edges.
+  void setTopHalo( const uint64_t* aboveBottomEdge );
+  void setBottomHalo( const uint64_t* belowTopEdge );
+
+  // Copy owned rows and halos from / owned rows to a full board.
+  void loadFrom( const PackedBoard& board );
+  void storeTo( PackedBoard& board ) const;
+
+  size_t memoryUsed() const { return ( cells.capacity() + scratch.capacity() ) * sizeof( uint64_t ); }
+
+  // Advance up to halo() generations using the current halos.
+  void advance( unsigned generations );
+
+  private:
+  unsigned first;
+  unsigned count;
+  unsigned haloRows;
+  unsigned words;
+  std::vector<uint64_t> cells;
+  std::vector<uint64_t> scratch;
+};
+
+#endif
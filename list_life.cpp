@@ -0,0 +1,166 @@
+///
+/// "List life": each row a sorted list of live x coordinates.
+/// (C) Andrew Brownbill 2019
+///
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "list_life.h"
+
+// Coord is 16 bits.
+constexpr unsigned MAX_WIDTH = 65536;
+
+// Lists are reserved this much past the population they expect and
+// shrunk once they're more than twice that past what they hold, plus a
+// little so tiny populations don't reallocate every generation.
+constexpr size_t HEADROOM_EIGHTHS = 1;
+constexpr size_t SLACK_CELLS = 256;
+
+template < typename T >
+static inline void boundCapacity( std::vector< T >& list )
+{
+  if ( list.capacity() > list.size() + 2 * ( list.size() * HEADROOM_EIGHTHS / 8 ) + SLACK_CELLS ) {
+    std::vector< T >( list ).swap( list );
+  }
+}
+
+ListLife::ListLife( unsigned width, unsigned height ) :
+  xSize( width ), ySize( height ), rowStart( height + 1, 0 ), previousStart( height + 1, 0 )
+{
+  if ( width < 3 || width > MAX_WIDTH || height == 0 ) {
+    throw std::invalid_argument( "ListLife needs a width from 3 to 65536 and a height" );
+  }
+}
+
+void ListLife::load( const PackedBoard& board )
+{
+  if ( board.width() != xSize || board.height() != ySize ) {
+    throw std::invalid_argument( "ListLife::load board size mismatch" );
+  }
+  xs.clear();
+  for ( unsigned y = 0; y < ySize; ++y )
+  {
+    rowStart[ y ] = uint32_t( xs.size() );
+    const uint64_t* row = board.row( y );
+    for ( unsigned w = 0; w < board.wordsPerRow(); ++w ) {
+      for ( uint64_t bits = row[w]; bits; bits &= bits - 1 ) {
+        xs.push_back( Coord( w * CELLS_PER_WORD + __builtin_ctzll( bits )));
+      }
+    }
+  }
+  rowStart[ ySize ] = uint32_t( xs.size() );
+  boundCapacity( xs );
+  previousXs = xs;
+  previousStart = rowStart;
+}
+
+void ListLife::store( PackedBoard& board ) const
+{
+  board.clear();
+  for ( unsigned y = 0; y < ySize; ++y ) {
+    for ( uint32_t i = rowStart[ y ]; i < rowStart[ y + 1 ]; ++i ) board.set( xs[ i ], y, true );
+  }
+}
+
+// Call visit( x, neighbors, alive ) for every cell of row y with a live
+// neighbor in cells.
+template < typename Visit >
+void ListLife::stepRow( const std::vector< Coord >& cells, const std::vector< uint32_t >& starts,
+                        unsigned y, Visit visit ) const
+{
+  const unsigned u = y ? y - 1 : ySize - 1;         // wrap around y
+  const unsigned d = ( y + 1 < ySize ) ? y + 1 : 0;
+  const Coord* up = cells.data() + starts[ u ];
+  const Coord* upEnd = cells.data() + starts[ u + 1 ];
+  const Coord* mid = cells.data() + starts[ y ];
+  const Coord* midEnd = cells.data() + starts[ y + 1 ];
+  const Coord* down = cells.data() + starts[ d ];
+  const Coord* downEnd = cells.data() + starts[ d + 1 ];
+  if ( up == upEnd && mid == midEnd && down == downEnd ) return;
+
+  // Merge the three rows into columns.  Slot 0 is for a copy of the last
+  // column at x = -1, so the window wraps around x.
+  columns.clear();
+  columns.push_back( Column{ 0, 0, 0 } );
+  while ( up != upEnd || mid != midEnd || down != downEnd )
+  {
+    int32_t x = int32_t( xSize );
+    if ( up != upEnd ) x = std::min< int32_t >( x, *up );
+    if ( mid != midEnd ) x = std::min< int32_t >( x, *mid );
+    if ( down != downEnd ) x = std::min< int32_t >( x, *down );
+    Column column{ x, 0, 0 };
+    if ( up != upEnd && *up == x ) { ++column.count; ++up; }
+    if ( mid != midEnd && *mid == x ) { ++column.count; column.mid = 1; ++mid; }
+    if ( down != downEnd && *down == x ) { ++column.count; ++down; }
+    columns.push_back( column );
+  }
+  size_t first = 1;
+  if ( columns.back().x == int32_t( xSize ) - 1 )
+  {
+    columns[ 0 ] = columns.back();
+    columns[ 0 ].x = -1;
+    first = 0;
+  }
+  if ( columns[ 1 ].x == 0 )
+  {
+    columns.push_back( columns[ 1 ] );
+    columns.back().x = int32_t( xSize );
+  }
+
+  // Every cell next to a column, in order, with a three column window.
+  int32_t last = -1;
+  size_t low = first;
+  for ( size_t i = first; i < columns.size(); ++i ) {
+    for ( int32_t x = columns[ i ].x - 1; x <= columns[ i ].x + 1; ++x )
+    {
+      if ( x <= last || x < 0 || x >= int32_t( xSize )) continue;
+      last = x;
+      while ( columns[ low ].x < x - 1 ) ++low;
+      unsigned sum = 0;
+      bool alive = false;
+      for ( size_t k = low; k < columns.size() && columns[ k ].x <= x + 1; ++k )
+      {
+        sum += columns[ k ].count;
+        if ( columns[ k ].x == x ) alive = columns[ k ].mid;
+      }
+      const unsigned neighbors = sum - ( alive ? 1 : 0 );
+      if ( neighbors ) visit( Coord( x ), neighbors, alive );
+    }
+  }
+}
+
+void ListLife::advance()
+{
+  previousXs.swap( xs );
+  previousStart.swap( rowStart );
+  xs.clear();
+  xs.reserve( previousXs.size() + previousXs.size() * HEADROOM_EIGHTHS / 8 );
+  for ( unsigned y = 0; y < ySize; ++y )
+  {
+    rowStart[ y ] = uint32_t( xs.size() );
+    stepRow( previousXs, previousStart, y, [&]( Coord x, unsigned neighbors, bool alive ) {
+      if ( neighbors == 3 || ( neighbors == 2 && alive )) xs.push_back( x );
+    });
+  }
+  rowStart[ ySize ] = uint32_t( xs.size() );
+  boundCapacity( xs );
+}
+
+size_t ListLife::memoryUsed() const
+{
+  return ( xs.capacity() + previousXs.capacity() ) * sizeof( Coord ) +
+         ( rowStart.capacity() + previousStart.capacity() ) * sizeof( uint32_t ) +
+         columns.capacity() * sizeof( Column );
+}
+
+void ListLife::storeNeighborhood( LifeBuffer& buffer ) const
+{
+  buffer.clear();
+  for ( unsigned y = 0; y < ySize; ++y )
+  {
+    stepRow( previousXs, previousStart, y, [&]( Coord x, unsigned neighbors, bool alive ) {
+      buffer[ LifeCoord( x, y ) ].value = ( neighbors == 3 || ( neighbors == 2 && alive )) ? 1 : 0;
+    });
+  }
+}
@@ -0,0 +1,73 @@
+///
+/// "List life": each row a sorted list of live x coordinates.
+/// (C) Andrew Brownbill 2019
+///
+
+#ifndef LIST_LIFE_H
+#define LIST_LIFE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "life.h"
+#include "packed_board.h"
+
+// Rows of a torus as sorted lists of live x coordinates, all rows in one
+// array with an index of where each starts.  A row steps by merging the
+// lists of the rows above, at and below it into columns, then sliding a
+// three column window along them.  A generation's list takes 2 bytes a
+// live cell plus up to a quarter over in reserve, and the previous one
+// is kept for cells(), so about 5 bytes a live cell all told, plus 8
+// bytes a row for the two row indexes.  Small sparse boards come out
+// higher, the row indexes dominating.  Rows are at most 65536 cells
+// wide.
+class ListLife
+{
+  public:
+
+  ListLife( unsigned width, unsigned height );
+
+  unsigned width() const { return xSize; }
+  unsigned height() const { return ySize; }
+
+  void load( const PackedBoard& board );
+  void store( PackedBoard& board ) const;
+
+  void advance();
+
+  size_t population() const { return xs.size(); }
+  size_t memoryUsed() const;
+
+  // Write the board in advanceSim's form: every cell with a live
+  // neighbor last generation, value 1 if it's alive now.  After load()
+  // the neighborhood is the loaded board's.
+  void storeNeighborhood( LifeBuffer& buffer ) const;
+
+  private:
+
+  using Coord = uint16_t;
+
+  // Cells in the rows above, at and below one being stepped.
+  class Column
+  {
+    public:
+
+    int32_t x;
+    uint8_t count;        // Rows live here
+    uint8_t mid;          // Live in the row being stepped
+  };
+
+  template < typename Visit >
+  void stepRow( const std::vector< Coord >& cells, const std::vector< uint32_t >& starts,
+                unsigned y, Visit visit ) const;
+
+  unsigned xSize;
+  unsigned ySize;
+  std::vector< Coord > xs;                // Live cells, row by row
+  std::vector< uint32_t > rowStart;       // Row y is xs[ rowStart[y], rowStart[y+1] )
+  std::vector< Coord > previousXs;
+  std::vector< uint32_t > previousStart;
+  mutable std::vector< Column > columns;  // Scratch for stepRow
+};
+
+#endif
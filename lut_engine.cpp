@@ -0,0 +1,98 @@
+///
+/// Lookup table game of life.  Steps the packed board in 2x2 blocks.
+/// (C) Andrew Brownbill 2019
+///
+
+#include <stdexcept>
+
+#include "lut_engine.h"
+
+// Cells on a side of the lookup block and of its result.
+constexpr unsigned BLOCK = 4;
+constexpr unsigned CENTER = 2;
+
+static std::vector<uint8_t> buildBlockTable()
+{
+  std::vector<uint8_t> table( 1 << ( BLOCK * BLOCK ));
+  for ( unsigned index = 0; index < table.size(); ++index )
+  {
+    auto cell = [&]( unsigned x, unsigned y ) { return ( index >> ( y * BLOCK + x )) & 1; };
+    uint8_t result = 0;
+    for ( unsigned y = 1; y <= CENTER; ++y ) {
+      for ( unsigned x = 1; x <= CENTER; ++x ) {
+        unsigned neighbors = 0;
+        for ( unsigned ny = y - 1; ny <= y + 1; ++ny ) {
+          for ( unsigned nx = x - 1; nx <= x + 1; ++nx ) {
+            if ( nx != x || ny != y ) neighbors += cell( nx, ny );
+          }
+        }
+        const bool alive = neighbors == 3 || ( neighbors == 2 && cell( x, y ));
+        result |= alive << (( y - 1 ) * CENTER + ( x - 1 ));
+      }
+    }
+    table[ index ] = result;
+  }
+  return table;
+}
+
+const std::vector<uint8_t>& blockTable()
+{
+  static const std::vector<uint8_t> table = buildBlockTable();
+  return table;
+}
+
+void advanceLut( const PackedBoard& src, PackedBoard& dst )
+{
+  const unsigned height = src.height();
+  const unsigned words = src.wordsPerRow();
+  if ( height % CENTER != 0 ) {
+    throw std::invalid_argument( "advanceLut needs an even board height" );
+  }
+  const uint8_t* table = blockTable().data();
+
+  for ( unsigned y = 0; y < height; y += CENTER )
+  {
+    // The 4 rows that cover output rows y and y + 1.
+    const uint64_t* rows[ BLOCK ] = {
+      src.row(( y + height - 1 ) % height ), src.row( y ),
+      src.row( y + 1 ), src.row(( y + 2 ) % height ) };
+    uint64_t* top = dst.row( y );
+    uint64_t* bottom = dst.row( y + 1 );
+
+    for ( unsigned w = 0; w < words; ++w )
+    {
+      const unsigned p = w ? w - 1 : words - 1;         // wrap around x
+      const unsigned n = ( w + 1 < words ) ? w + 1 : 0;
+
+      // lo holds the word moved one cell right so bits 2j..2j+3 are the
+      // 4 cells around output cells 2j and 2j + 1.  The last block pokes
+      // into the next word, which hi supplies.
+      uint64_t lo[ BLOCK ];
+      uint64_t hi[ BLOCK ];
+      for ( unsigned r = 0; r < BLOCK; ++r ) {
+        lo[r] = ( rows[r][w] << 1 ) | ( rows[r][p] >> 63 );
+        hi[r] = ( rows[r][w] >> 63 ) | ( rows[r][n] << 1 );
+      }
+
+      uint64_t outTop = 0;
+      uint64_t outBottom = 0;
+      constexpr unsigned BLOCKS_PER_WORD = CELLS_PER_WORD / CENTER;
+      for ( unsigned j = 0; j < BLOCKS_PER_WORD - 1; ++j )
+      {
+        const unsigned result = table[
+          ( lo[0] & 0xf ) | (( lo[1] & 0xf ) << 4 ) | (( lo[2] & 0xf ) << 8 ) | (( lo[3] & 0xf ) << 12 ) ];
+        outTop |= uint64_t( result & 3 ) << ( 2 * j );
+        outBottom |= uint64_t( result >> 2 ) << ( 2 * j );
+        for ( unsigned r = 0; r < BLOCK; ++r ) lo[r] >>= 2;
+      }
+      const unsigned last = table[
+        ( lo[0] | (( hi[0] & 3 ) << 2 )) | (( lo[1] | (( hi[1] & 3 ) << 2 )) << 4 ) |
+        (( lo[2] | (( hi[2] & 3 ) << 2 )) << 8 ) | (( lo[3] | (( hi[3] & 3 ) << 2 )) << 12 ) ];
+      outTop |= uint64_t( last & 3 ) << 62;
+      outBottom |= uint64_t( last >> 2 ) << 62;
+
+      top[w] = outTop;
+      bottom[w] = outBottom;
+    }
+  }
+}
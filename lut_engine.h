@@ -0,0 +1,26 @@
+///
+/// Lookup table game of life.  Steps the packed board in 2x2 blocks.
+/// (C) Andrew Brownbill 2019
+///
+
+#ifndef LUT_ENGINE_H
+#define LUT_ENGINE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "packed_board.h"
+
+// The next state of the 2x2 center of every possible 4x4 block.  The
+// index holds the block a row per nibble, top row in bits 0-3, and the
+// leftmost cell of a row in the low bit.  The result has the top row of
+// the center in bits 0-1 and the bottom row in bits 2-3.
+const std::vector<uint8_t>& blockTable();
+
+// Move the packed board forward one iteration into dst, one table
+// lookup per 2x2 block.  Only needs 64 bit integer ops, so it's the
+// fast path for wasm builds without simd128.  Width and height must be
+// even.
+void advanceLut( const PackedBoard& src, PackedBoard& dst );
+
+#endif
@@ -0,0 +1,123 @@
+///
+/// Keeps track of who holds memory, and makes them give some back when
+/// the total goes over a limit.
+/// (C) Andrew Brownbill 2019
+///
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#ifndef __EMSCRIPTEN__
+#include <unistd.h>
+#endif
+
+#include "memory_budget.h"
+
+MemoryBudget::MemoryBudget( size_t limit ) : limitBytes( limit ), peakBytes( 0 )
+{
+}
+
+size_t MemoryBudget::defaultLimit()
+{
+  constexpr size_t GB = size_t( 1 ) << 30;
+  return sizeof( void* ) == 4 ? 3 * GB : 16 * GB;
+}
+
+size_t MemoryBudget::heapSize()
+{
+#ifdef __EMSCRIPTEN__
+  constexpr size_t WASM_PAGE = 65536;
+  return __builtin_wasm_memory_size( 0 ) * WASM_PAGE;
+#else
+  size_t pages = 0;
+  size_t resident = 0;
+  std::ifstream statm( "/proc/self/statm" );
+  statm >> pages >> resident;
+  return resident * size_t( sysconf( _SC_PAGESIZE ));
+#endif
+}
+
+void MemoryBudget::attach( MemoryClient* client, unsigned priority )
+{
+  clients.push_back( Attached{ client, priority } );
+  std::stable_sort( clients.begin(), clients.end(), []( const Attached& a, const Attached& b ) {
+    return a.priority < b.priority;
+  });
+}
+
+void MemoryBudget::detach( MemoryClient* client )
+{
+  clients.erase( std::remove_if( clients.begin(), clients.end(), [&]( const Attached& a ) {
+    return a.client == client;
+  }), clients.end() );
+}
+
+std::vector< MemoryUse > MemoryBudget::usage() const
+{
+  std::vector< MemoryUse > lines;
+  for ( const auto& attached : clients ) attached.client->memoryUsage( lines );
+
+  // Keep the order subsystems first show up in.
+  std::vector< MemoryUse > merged;
+  for ( const auto& line : lines )
+  {
+    auto same = std::find_if( merged.begin(), merged.end(), [&]( const MemoryUse& m ) {
+      return m.subsystem == line.subsystem;
+    });
+    if ( same == merged.end() ) merged.push_back( line );
+    else same->bytes += line.bytes;
+  }
+
+  size_t total = 0;
+  for ( const auto& line : merged ) total += line.bytes;
+  peakBytes = std::max( peakBytes, total );
+  return merged;
+}
+
+size_t MemoryBudget::used() const
+{
+  size_t total = 0;
+  for ( const auto& line : usage() ) total += line.bytes;
+  return total;
+}
+
+bool MemoryBudget::enforce()
+{
+  size_t current = used();
+  for ( const auto& attached : clients )
+  {
+    if ( current <= limitBytes ) break;
+    attached.client->trimMemory( current - limitBytes );
+    current = used();
+  }
+  return current <= limitBytes;
+}
+
+std::string MemoryBudget::report() const
+{
+  auto mb = []( size_t bytes ) {
+    char text[ 32 ];
+    std::snprintf( text, sizeof( text ), "%.1fMB", bytes / 1048576.0 );
+    return std::string( text );
+  };
+  std::ostringstream out;
+  size_t total = 0;
+  for ( const auto& line : usage() )
+  {
+    out << line.subsystem << " " << mb( line.bytes ) << "  ";
+    total += line.bytes;
+  }
+  out << "total " << mb( total ) << " (peak " << mb( peakBytes ) << ", limit "
+      << mb( limitBytes ) << ")  heap " << mb( heapSize() );
+  return out.str();
+}
+
+size_t memoryUsed( const LifeBuffer& buffer )
+{
+  // A node holds the next pointer, the cached hash and the value, and
+  // malloc adds a header.  Close enough for libstdc++ and libc++.
+  constexpr size_t NODE = sizeof( LifeBuffer::value_type ) + 3 * sizeof( void* );
+  return buffer.size() * NODE + buffer.bucket_count() * sizeof( void* );
+}
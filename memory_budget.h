@@ -0,0 +1,90 @@
+///
+/// Keeps track of who holds memory, and makes them give some back when
+/// the total goes over a limit.
+/// (C) Andrew Brownbill 2019
+///
+
+#ifndef MEMORY_BUDGET_H
+#define MEMORY_BUDGET_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "life.h"
+
+// One line of the memory report.
+class MemoryUse
+{
+  public:
+
+  std::string subsystem;
+  size_t bytes;
+};
+
+// Something that holds memory the budget should know about.
+class MemoryClient
+{
+  public:
+
+  virtual ~MemoryClient() {}
+
+  // Add a line per subsystem to report.
+  virtual void memoryUsage( std::vector< MemoryUse >& report ) const = 0;
+
+  // Free at least bytes if possible, caches first.  Returns what was
+  // freed.  Called when the budget is over its limit.
+  virtual size_t trimMemory( size_t bytes ) { (void) bytes; return 0; }
+};
+
+// The limit covers what the clients report, not the whole heap; the heap
+// size is reported next to it.
+class MemoryBudget
+{
+  public:
+
+  explicit MemoryBudget( size_t limitBytes = defaultLimit() );
+
+  // 3 GB of a wasm32 address space, 16 GB with 64 bit pointers.
+  static size_t defaultLimit();
+
+  // The whole heap: linear memory in wasm, resident set natively.
+  static size_t heapSize();
+
+  void setLimit( size_t bytes ) { limitBytes = bytes; }
+  size_t limit() const { return limitBytes; }
+
+  // Clients with lower priority numbers are trimmed first.
+  void attach( MemoryClient* client, unsigned priority );
+  void detach( MemoryClient* client );
+
+  // Per subsystem, lines with the same name added up.
+  std::vector< MemoryUse > usage() const;
+  size_t used() const;
+  size_t peak() const { return peakBytes; }
+
+  // Trim clients until we're under the limit.  Returns false if they
+  // couldn't free enough.
+  bool enforce();
+
+  // One line summary for the stats overlay.
+  std::string report() const;
+
+  private:
+
+  class Attached
+  {
+    public:
+    MemoryClient* client;
+    unsigned priority;
+  };
+
+  size_t limitBytes;
+  mutable size_t peakBytes;
+  std::vector< Attached > clients;
+};
+
+// Bytes held by a hash map buffer, nodes and bucket array.
+size_t memoryUsed( const LifeBuffer& buffer );
+
+#endif
@@ -0,0 +1,159 @@
+///
+/// Summary bitmaps of the non-empty words of a packed board.
+/// (C) Andrew Brownbill 2019
+///
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "occupancy.h"
+
+Occupancy::Occupancy( unsigned width, unsigned height ) :
+  boardWords( size_t( width / CELLS_PER_WORD ) * height ), rowWords( width / CELLS_PER_WORD ),
+  level1(( boardWords + 63 ) / 64 ), level2(( level1.size() + 63 ) / 64 )
+{
+  if ( width == 0 || width % CELLS_PER_WORD != 0 || height == 0 ) {
+    throw std::invalid_argument( "Occupancy width must be a non zero multiple of 64" );
+  }
+}
+
+void Occupancy::clear()
+{
+  for ( size_t i2 = 0; i2 < level2.size(); ++i2 ) {
+    for ( uint64_t bits2 = level2[ i2 ]; bits2; bits2 &= bits2 - 1 ) {
+      level1[ i2 * 64 + __builtin_ctzll( bits2 ) ] = 0;
+    }
+  }
+  std::fill( level2.begin(), level2.end(), 0 );
+}
+
+void Occupancy::rebuild( const PackedBoard& board )
+{
+  if ( size_t( board.wordsPerRow() ) * board.height() != boardWords ) {
+    throw std::invalid_argument( "Occupancy::rebuild board size mismatch" );
+  }
+  clear();
+  const uint64_t* cells = board.row( 0 );
+  for ( size_t i = 0; i < boardWords; ++i ) if ( cells[ i ] ) mark( i );
+}
+
+void Occupancy::markNear( const Occupancy& occupied )
+{
+  const size_t count = level1.size();
+  const std::vector< uint64_t >& from = occupied.level1;
+
+  // Across: the words either side in the linear order.  At the ends of a
+  // row that marks the end of the next / last row, which is harmless.
+  std::vector< uint64_t >& across = scratch;
+  across.resize( count );
+  for ( size_t j = 0; j < count; ++j )
+  {
+    const uint64_t before = j ? from[ j - 1 ] >> 63 : 0;
+    const uint64_t after = ( j + 1 < count ) ? from[ j + 1 ] << 63 : 0;
+    across[ j ] = from[ j ] | ( from[ j ] << 1 ) | before | ( from[ j ] >> 1 ) | after;
+  }
+
+  // Down and up: a row is rowWords bits.
+  const size_t q = rowWords / 64;
+  const unsigned r = rowWords % 64;
+  for ( size_t j = 0; j < count; ++j )
+  {
+    uint64_t near = across[ j ];
+    if ( j >= q ) {
+      near |= across[ j - q ] << r;
+      if ( r && j > q ) near |= across[ j - q - 1 ] >> ( 64 - r );
+    }
+    if ( j + q < count ) {
+      near |= across[ j + q ] >> r;
+      if ( r && j + q + 1 < count ) near |= across[ j + q + 1 ] << ( 64 - r );
+    }
+    level1[ j ] = near;
+  }
+  // Bits past the board in the last word.
+  if ( boardWords % 64 ) level1[ count - 1 ] &= ( uint64_t( 1 ) << ( boardWords % 64 )) - 1;
+  for ( size_t i2 = 0; i2 < level2.size(); ++i2 )
+  {
+    uint64_t bits = 0;
+    for ( size_t k = 0; k < 64 && i2 * 64 + k < count; ++k ) {
+      if ( level1[ i2 * 64 + k ] ) bits |= uint64_t( 1 ) << k;
+    }
+    level2[ i2 ] = bits;
+  }
+
+  // What the linear shifts miss: wrapping around x from the first and
+  // last columns, and around y from the first and last rows.
+  const unsigned height = unsigned( boardWords / rowWords );
+  auto markAround = [&]( unsigned y, unsigned w ) {
+    const unsigned ys[ 3 ] = { y ? y - 1 : height - 1, y, ( y + 1 < height ) ? y + 1 : 0 };
+    const unsigned ws[ 3 ] = { w ? w - 1 : rowWords - 1, w, ( w + 1 < rowWords ) ? w + 1 : 0 };
+    for ( unsigned ny : ys ) {
+      for ( unsigned nw : ws ) mark( size_t( ny ) * rowWords + nw );
+    }
+  };
+  for ( unsigned y = 0; y < height; ++y )
+  {
+    if ( occupied.test( size_t( y ) * rowWords )) markAround( y, 0 );
+    if ( occupied.test( size_t( y ) * rowWords + rowWords - 1 )) markAround( y, rowWords - 1 );
+  }
+  for ( unsigned w = 0; w < rowWords; ++w )
+  {
+    if ( occupied.test( w )) markAround( 0, w );
+    if ( occupied.test( size_t( height - 1 ) * rowWords + w )) markAround( height - 1, w );
+  }
+}
+
+size_t population( const PackedBoard& board, const Occupancy& occupied )
+{
+  const uint64_t* cells = board.row( 0 );
+  size_t count = 0;
+  occupied.forEach( [&]( size_t i ) { count += __builtin_popcountll( cells[ i ] ); } );
+  return count;
+}
+
+void advanceOccupied( const PackedBoard& src, const Occupancy& srcOccupied,
+                      PackedBoard& dst, Occupancy& dstOccupied, Occupancy& near )
+{
+  const unsigned words = src.wordsPerRow();
+  const unsigned height = src.height();
+  if ( dst.wordsPerRow() != words || dst.height() != height || srcOccupied.words() != near.words() ||
+       dstOccupied.words() != near.words() || near.words() != size_t( words ) * height ) {
+    throw std::invalid_argument( "advanceOccupied board size mismatch" );
+  }
+
+  // Every word next to an occupied one may change.
+  near.markNear( srcOccupied );
+
+  // Empty what dst held, then step the words that can be alive.
+  uint64_t* out = dst.row( 0 );
+  dstOccupied.forEach( [&]( size_t i ) { out[ i ] = 0; } );
+  dstOccupied.clear();
+  near.forEachGroup( [&]( size_t group, uint64_t bits ) {
+    // Row and column of the group's first word, then walk along.
+    const size_t base = group * 64;
+    unsigned y = unsigned( base / words );
+    unsigned w = unsigned( base % words );
+    unsigned at = 0;
+    const uint64_t* up = src.row( y ? y - 1 : height - 1 );
+    const uint64_t* mid = src.row( y );
+    const uint64_t* down = src.row(( y + 1 < height ) ? y + 1 : 0 );
+    uint64_t alive = 0;
+    for ( ; bits; bits &= bits - 1 )
+    {
+      const unsigned b = __builtin_ctzll( bits );
+      w += b - at;
+      at = b;
+      if ( w >= words )
+      {
+        y += w / words;
+        w %= words;
+        up = src.row( y ? y - 1 : height - 1 );
+        mid = src.row( y );
+        down = src.row(( y + 1 < height ) ? y + 1 : 0 );
+      }
+      const uint64_t next = stepPackedWord( up, mid, down, w, words );
+      out[ base + b ] = next;
+      alive |= uint64_t( next != 0 ) << b;
+    }
+    dstOccupied.markGroup( group, alive );
+  });
+}
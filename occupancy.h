@@ -0,0 +1,106 @@
+///
+/// Summary bitmaps of the non-empty words of a packed board.
+/// (C) Andrew Brownbill 2019
+///
+
+#ifndef OCCUPANCY_H
+#define OCCUPANCY_H
+
+#include <cstdint>
+#include <vector>
+
+#include "packed_board.h"
+
+// Which words of a packed board hold a live cell, in two levels: bit i of
+// the first level is set if board word i (row major, y * wordsPerRow + w)
+// is non zero, bit j of the second if first level word j is.  Walking the
+// set bits with ctz visits only the occupied words and, two levels up,
+// skips 4096 empty board words per zero summary word.  A set bit for an
+// empty word is allowed, just slower.
+class Occupancy
+{
+  public:
+
+  Occupancy( unsigned width, unsigned height );
+
+  size_t words() const { return boardWords; }
+  unsigned wordsPerRow() const { return rowWords; }
+
+  // Clears only the summary words that are set.
+  void clear();
+
+  void mark( size_t word )
+  {
+    level1[ word / 64 ] |= uint64_t( 1 ) << ( word % 64 );
+    level2[ word / 4096 ] |= uint64_t( 1 ) << ( word / 64 % 64 );
+  }
+  bool test( size_t word ) const { return ( level1[ word / 64 ] >> ( word % 64 )) & 1; }
+
+  // Mark words group * 64 + b for the set bits b of bits.
+  void markGroup( size_t group, uint64_t bits )
+  {
+    level1[ group ] |= bits;
+    if ( bits ) level2[ group / 64 ] |= uint64_t( 1 ) << ( group % 64 );
+  }
+
+  // Mark every non zero word of board.
+  void rebuild( const PackedBoard& board );
+
+  // Mark the words next to or on a word marked in occupied, wrapping
+  // around both ways: the words a step from occupied's board can change.
+  // Done on the first level 64 words at a time.
+  void markNear( const Occupancy& occupied );
+
+  // visit( word ) for each marked word, in increasing order.
+  template < typename Visit >
+  void forEach( Visit visit ) const
+  {
+    for ( size_t i2 = 0; i2 < level2.size(); ++i2 ) {
+      for ( uint64_t bits2 = level2[ i2 ]; bits2; bits2 &= bits2 - 1 )
+      {
+        const size_t i1 = i2 * 64 + __builtin_ctzll( bits2 );
+        for ( uint64_t bits1 = level1[ i1 ]; bits1; bits1 &= bits1 - 1 ) {
+          visit( i1 * 64 + __builtin_ctzll( bits1 ));
+        }
+      }
+    }
+  }
+
+  // visit( group, bits ) for each first level word with bits set: board
+  // words group * 64 + b for the set bits b.
+  template < typename Visit >
+  void forEachGroup( Visit visit ) const
+  {
+    for ( size_t i2 = 0; i2 < level2.size(); ++i2 ) {
+      for ( uint64_t bits2 = level2[ i2 ]; bits2; bits2 &= bits2 - 1 )
+      {
+        const size_t i1 = i2 * 64 + __builtin_ctzll( bits2 );
+        if ( level1[ i1 ] ) visit( i1, level1[ i1 ] );
+      }
+    }
+  }
+
+  size_t memoryUsed() const
+  {
+    return ( level1.capacity() + level2.capacity() + scratch.capacity() ) * sizeof( uint64_t );
+  }
+
+  private:
+  size_t boardWords;
+  unsigned rowWords;
+  std::vector< uint64_t > level1;
+  std::vector< uint64_t > level2;
+  std::vector< uint64_t > scratch;     // For markNear
+};
+
+// Live cells, visiting only the occupied words.
+size_t population( const PackedBoard& board, const Occupancy& occupied );
+
+// advancePacked for mostly empty boards.  Only the words next to an
+// occupied word of src are stepped, wrapping around both ways; dst is
+// cleared through its own map first, and both dst maps are rebuilt.
+// near is scratch, the words to step.
+void advanceOccupied( const PackedBoard& src, const Occupancy& srcOccupied,
+                      PackedBoard& dst, Occupancy& dstOccupied, Occupancy& near );
+
+#endif
@@ -0,0 +1,136 @@
+///
+/// Bit-packed game of life board.
+/// (C) Andrew Brownbill 2019
+///
+
+#ifndef PACKED_BOARD_H
+#define PACKED_BOARD_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "life.h"
+
+// Cells packed into a 64 bit word.
+constexpr unsigned CELLS_PER_WORD = 64;
+
+// A bit-packed game of life board.  Each row is a run of 64 bit words,
+// bit i of word w holding the cell at x = w * 64 + i.  The board wraps
+// around in both directions, like advanceSim.  The width must be a
+// multiple of 64.
+class PackedBoard
+{
+  public:
+
+  PackedBoard( unsigned width, unsigned height );
+
+  unsigned width() const { return xSize; }
+  unsigned height() const { return ySize; }
+  unsigned wordsPerRow() const { return words; }
+
+  uint64_t* row( unsigned y ) { return &cells[ size_t( y ) * words ]; }
+  const uint64_t* row( unsigned y ) const { return &cells[ size_t( y ) * words ]; }
+
+  bool get( unsigned x, unsigned y ) const;
+  void set( unsigned x, unsigned y, bool alive );
+  void clear();
+  size_t population() const;
+  size_t memoryUsed() const { return cells.capacity() * sizeof( uint64_t ); }
+
+  // Convert from / to the hash map representation.
+  void load( const LifeBuffer& buffer );
+  void store( LifeBuffer& buffer ) const;
+
+  private:
+  unsigned xSize;
+  unsigned ySize;
+  unsigned words;
+  std::vector<uint64_t> cells;
+};
+
+// Set the cells in out that have a live neighbor in up, mid or down,
+// the rows around it.  Wraps around x.
+void neighborhoodRow(
+  const uint64_t* up,
+  const uint64_t* mid,
+  const uint64_t* down,
+  uint64_t* out,
+  unsigned words );
+
+// Write the board in advanceSim's form: every cell that had a live
+// neighbor in previous is in the buffer, with value 1 if it's alive in
+// current.  Keeps cell ages the same as with the hash map engine.
+void storeNeighborhood( const PackedBoard& previous, const PackedBoard& current, LifeBuffer& buffer );
+
+// Compute one row of the next generation from the row above, the row
+// itself and the row below.  Wraps around horizontally.
+void stepPackedRow(
+  const uint64_t* up,
+  const uint64_t* mid,
+  const uint64_t* down,
+  uint64_t* out,
+  unsigned words );
+
+// Word w of stepPackedRow's output alone.
+uint64_t stepPackedWord(
+  const uint64_t* up,
+  const uint64_t* mid,
+  const uint64_t* down,
+  unsigned w,
+  unsigned words );
+
+// Move the packed board forward one iteration into dst.
+void advancePacked( const PackedBoard& src, PackedBoard& dst );
+
+// Move the packed board forward one iteration in place, with three rows of
+// scratch rather than a second board.  New row y is held back until row
+// y + 1 is done, since that still needs the old row y; the old first row
+// is kept for the last.  oldRows( y, up, mid, down ) sees the old rows
+// around row y before it's replaced, for anyone who needs the last
+// generation, e.g. to age cells.
+template < typename OldRows >
+void advancePackedInPlace( PackedBoard& board, std::vector< uint64_t >& scratch, OldRows oldRows )
+{
+  const unsigned words = board.wordsPerRow();
+  const unsigned height = board.height();
+  scratch.resize( size_t( 3 ) * words );
+  uint64_t* first = &scratch[ 0 ];
+  uint64_t* pending[ 2 ] = { &scratch[ words ], &scratch[ 2 * words ] };
+  std::copy( board.row( 0 ), board.row( 0 ) + words, first );
+  for ( unsigned y = 0; y < height; ++y )
+  {
+    const uint64_t* up = board.row( y ? y - 1 : height - 1 );                 // wrap around y
+    const uint64_t* mid = board.row( y );
+    const uint64_t* down = ( y + 1 < height ) ? board.row( y + 1 ) : first;
+    oldRows( y, up, mid, down );
+    stepPackedRow( up, mid, down, pending[ y % 2 ], words );
+    if ( y ) std::copy( pending[ ( y - 1 ) % 2 ], pending[ ( y - 1 ) % 2 ] + words, board.row( y - 1 ));
+  }
+  std::copy( pending[ ( height - 1 ) % 2 ], pending[ ( height - 1 ) % 2 ] + words, board.row( height - 1 ));
+}
+
+inline void advancePackedInPlace( PackedBoard& board, std::vector< uint64_t >& scratch )
+{
+  advancePackedInPlace( board, scratch, []( unsigned, const uint64_t*, const uint64_t*, const uint64_t* ) {} );
+}
+
+// Write an ASCII art pattern into the board.  Same conventions as the
+// LifeBuffer version.
+void dropPattern(
+  PackedBoard& board,
+  const unsigned x,
+  const unsigned y,
+  const Pattern& pattern,
+  const unsigned int rotate );
+
+// Fill the board with random cells, each alive with probability
+// percent / 100.
+void fillRandom( PackedBoard& board, unsigned percent, unsigned seed );
+
+// Drop glider guns at random locations, 10 per X_GRID by Y_GRID area
+// like the web page does.
+void seedGliderGuns( PackedBoard& board, unsigned seed );
+
+#endif
@@ -0,0 +1,90 @@
+///
+/// 128 bit vector version of the packed game of life kernel.
+/// (C) Andrew Brownbill 2019
+///
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "packed_simd.h"
+
+// Two words.
+typedef uint64_t Vec2 __attribute__(( vector_size( 16 )));
+
+static inline Vec2 load2( const uint64_t* p )
+{
+  Vec2 v;
+  std::memcpy( &v, p, sizeof( v ));
+  return v;
+}
+
+static inline void fullAdd( Vec2 a, Vec2 b, Vec2 c, Vec2& sum, Vec2& carry )
+{
+  const Vec2 u = a ^ b;
+  sum = u ^ c;
+  carry = ( a & b ) | ( u & c );
+}
+
+// Copy row y into to with the wrapped around words on either side, so
+// the kernel never has to wrap.  to[1] is the first word of the row.
+static void padRow( const PackedBoard& src, unsigned y, uint64_t* to )
+{
+  const unsigned words = src.wordsPerRow();
+  const uint64_t* row = src.row( y );
+  to[0] = row[ words - 1 ];
+  std::copy( row, row + words, to + 1 );
+  to[ words + 1 ] = row[0];
+  to[ words + 2 ] = row[ words > 1 ? 1 : 0 ];
+}
+
+void advancePackedSimd( const PackedBoard& src, PackedBoard& dst )
+{
+  const unsigned words = src.wordsPerRow();
+  const unsigned height = src.height();
+
+  // Three padded rows, reused as we go down the board.  The extra word
+  // at the end lets an odd last pair run off the row.
+  const unsigned stride = words + 3;
+  std::vector<uint64_t> padded( 3 * stride );
+  auto slot = [&]( unsigned i ) { return &padded[ ( i % 3 ) * stride ]; };
+  padRow( src, height - 1, slot( 0 ));
+  padRow( src, 0, slot( 1 ));
+
+  for ( unsigned y = 0; y < height; ++y )
+  {
+    padRow( src, ( y + 1 ) % height, slot( y + 2 ));
+    const uint64_t* up = slot( y );
+    const uint64_t* mid = slot( y + 1 );
+    const uint64_t* down = slot( y + 2 );
+    uint64_t* out = dst.row( y );
+
+    for ( unsigned w = 0; w < words; w += 2 )
+    {
+      const Vec2 u = load2( up + w + 1 );
+      const Vec2 m = load2( mid + w + 1 );
+      const Vec2 d = load2( down + w + 1 );
+      const Vec2 uw = ( u << 1 ) | ( load2( up + w ) >> 63 );
+      const Vec2 ue = ( u >> 1 ) | ( load2( up + w + 2 ) << 63 );
+      const Vec2 mw = ( m << 1 ) | ( load2( mid + w ) >> 63 );
+      const Vec2 me = ( m >> 1 ) | ( load2( mid + w + 2 ) << 63 );
+      const Vec2 dw = ( d << 1 ) | ( load2( down + w ) >> 63 );
+      const Vec2 de = ( d >> 1 ) | ( load2( down + w + 2 ) << 63 );
+
+      // Same adder tree as stepPackedRow.
+      Vec2 s0, c0, s1, c1, ones, c3, twos, c4;
+      fullAdd( uw, u, ue, s0, c0 );
+      fullAdd( mw, me, dw, s1, c1 );
+      const Vec2 s2 = d ^ de;
+      const Vec2 c2 = d & de;
+      fullAdd( s0, s1, s2, ones, c3 );
+      fullAdd( c0, c1, c2, twos, c4 );
+      const Vec2 fours = c4 | ( twos & c3 );
+      twos ^= c3;
+      const Vec2 next = twos & ~fours & ( ones | m );
+
+      out[w] = next[0];
+      if ( w + 1 < words ) out[ w + 1 ] = next[1];
+    }
+  }
+}
@@ -0,0 +1,17 @@
+///
+/// 128 bit vector version of the packed game of life kernel.
+/// (C) Andrew Brownbill 2019
+///
+
+#ifndef PACKED_SIMD_H
+#define PACKED_SIMD_H
+
+#include "packed_board.h"
+
+// Same as advancePacked, two words at a time.  Written with compiler
+// vector extensions, so it's SSE2 or NEON natively and simd128 in wasm
+// builds made with -msimd128.  Without vector units the compiler splits
+// the vectors back up; PlatformFeatures::simd says which it is.
+void advancePackedSimd( const PackedBoard& src, PackedBoard& dst );
+
+#endif
@@ -0,0 +1,130 @@
+///
+/// Multi threaded packed game of life.
+/// (C) Andrew Brownbill 2019
+///
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "parallel_engine.h"
+
+ParallelEngine::ParallelEngine( unsigned width, unsigned height, unsigned threads, unsigned halo ) :
+  xSize( width ), ySize( height ), haloRows( halo ),
+  exchanges( 0 ), halosFresh( false ), pending( 0 ), stopping( false ),
+  start( threads ), exchange( threads ), done( threads )
+{
+  if ( threads == 0 || height / threads < halo ) {
+    throw std::invalid_argument( "ParallelEngine needs at least halo rows per thread" );
+  }
+  for ( unsigned id = 0; id < threads; ++id )
+  {
+    const unsigned first = unsigned( size_t( height ) * id / threads );
+    const unsigned last = unsigned( size_t( height ) * ( id + 1 ) / threads );
+    slabs.emplace_back( new LifeSlab( width, first, last - first, halo ));
+    for ( unsigned parity = 0; parity < 2; ++parity ) {
+      mailboxes.emplace_back( 2 * slabs.back()->edgeWords() );
+    }
+  }
+
+  // The calling thread runs band 0.  If a thread can't be started, the
+  // ones that were would wait on the barriers for it forever, so let them
+  // go before giving up.
+  try {
+    for ( unsigned id = 1; id < threads; ++id )
+    {
+      workers.emplace_back( &ParallelEngine::workerLoop, this, id );
+    }
+  }
+  catch ( ... ) {
+    stopping = true;
+    start.release();
+    exchange.release();
+    done.release();
+    for ( auto& worker : workers ) worker.join();
+    throw;
+  }
+}
+
+ParallelEngine::~ParallelEngine()
+{
+  stopping = true;
+  if ( !workers.empty() ) start.wait();
+  for ( auto& worker : workers ) worker.join();
+}
+
+void ParallelEngine::load( const PackedBoard& board )
+{
+  if ( board.width() != xSize || board.height() != ySize ) {
+    throw std::invalid_argument( "ParallelEngine::load board size mismatch" );
+  }
+  for ( auto& slab : slabs ) slab->loadFrom( board );
+  halosFresh = true;
+}
+
+void ParallelEngine::store( PackedBoard& board ) const
+{
+  for ( const auto& slab : slabs ) slab->storeTo( board );
+}
+
+size_t ParallelEngine::memoryUsed() const
+{
+  size_t bytes = 0;
+  for ( const auto& slab : slabs ) bytes += slab->memoryUsed();
+  for ( const auto& mailbox : mailboxes ) bytes += mailbox.capacity() * sizeof( uint64_t );
+  return bytes;
+}
+
+void ParallelEngine::advance( unsigned generations )
+{
+  pending = generations;
+  if ( !workers.empty() ) start.wait();
+  runBand( 0 );
+  if ( !workers.empty() ) done.wait();
+
+  // Every band went through the same schedule, so replay it to keep the
+  // mailbox parity in step for the next call.
+  const unsigned rounds = ( generations + haloRows - 1 ) / haloRows;
+  exchanges += rounds - (( halosFresh && rounds ) ? 1 : 0 );
+  if ( rounds ) halosFresh = false;
+}
+
+void ParallelEngine::workerLoop( unsigned id )
+{
+  for (;;)
+  {
+    start.wait();
+    if ( stopping ) return;
+    runBand( id );
+    done.wait();
+  }
+}
+
+void ParallelEngine::runBand( unsigned id )
+{
+  LifeSlab& slab = *slabs[ id ];
+  const unsigned bands = unsigned( slabs.size() );
+  const unsigned above = ( id + bands - 1 ) % bands;
+  const unsigned below = ( id + 1 ) % bands;
+  const size_t edge = slab.edgeWords();
+
+  unsigned serial = exchanges;
+  bool fresh = halosFresh;
+  for ( unsigned finished = 0; finished < pending; )
+  {
+    if ( !fresh )
+    {
+      const unsigned parity = serial++ & 1;
+      uint64_t* mine = mailboxes[ id * 2 + parity ].data();
+      std::copy( slab.topEdge(), slab.topEdge() + edge, mine );
+      std::copy( slab.bottomEdge(), slab.bottomEdge() + edge, mine + edge );
+      exchange.wait();
+      slab.setTopHalo( mailboxes[ above * 2 + parity ].data() + slabs[ above ]->edgeWords() );
+      slab.setBottomHalo( mailboxes[ below * 2 + parity ].data() );
+    }
+    fresh = false;
+
+    const unsigned batch = std::min( haloRows, pending - finished );
+    slab.advance( batch );
+    finished += batch;
+  }
+}
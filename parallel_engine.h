@@ -0,0 +1,69 @@
+///
+/// Multi threaded packed game of life.
+/// (C) Andrew Brownbill 2019
+///
+
+#ifndef PARALLEL_ENGINE_H
+#define PARALLEL_ENGINE_H
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "barrier.h"
+#include "life_slab.h"
+#include "packed_board.h"
+
+// Splits a packed torus into one horizontal band per thread.  Bands
+// carry halo() rows of their neighbors, so they run halo() generations
+// on their own between synchronizations.  A bigger halo means fewer
+// barriers but more redundant work on the halo rows; halo 1 is the
+// usual barrier per generation.
+class ParallelEngine
+{
+  public:
+
+  ParallelEngine( unsigned width, unsigned height, unsigned threads, unsigned halo );
+  ParallelEngine( const ParallelEngine& ) = delete;
+  ParallelEngine& operator=( const ParallelEngine& ) = delete;
+  ~ParallelEngine();
+
+  unsigned width() const { return xSize; }
+  unsigned height() const { return ySize; }
+  unsigned threads() const { return unsigned( slabs.size() ); }
+  unsigned halo() const { return haloRows; }
+
+  void load( const PackedBoard& board );
+  void store( PackedBoard& board ) const;
+
+  // Bands and mailboxes.
+  size_t memoryUsed() const;
+
+  // Move the board forward.
+  void advance( unsigned generations );
+
+  private:
+
+  void workerLoop( unsigned id );
+  void runBand( unsigned id );
+
+  unsigned xSize;
+  unsigned ySize;
+  unsigned haloRows;
+  std::vector< std::unique_ptr< LifeSlab > > slabs;
+
+  // Edge rows published for the neighbors, double buffered so a slow
+  // reader of one exchange never sees the next one.
+  std::vector< std::vector< uint64_t > > mailboxes;
+  unsigned exchanges;
+  bool halosFresh;
+
+  unsigned pending;     // Generations for the current advance()
+  bool stopping;
+  Barrier start;
+  Barrier exchange;
+  Barrier done;
+  std::vector< std::thread > workers;
+};
+
+#endif
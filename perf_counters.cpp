@@ -0,0 +1,96 @@
+///
+/// Hardware event counts around a piece of work, for the benchmarks.
+/// (C) Andrew Brownbill 2019
+///
+
+#include <cstring>
+
+#include "perf_counters.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static int openCounter( uint32_t type, uint64_t config )
+{
+  perf_event_attr attr;
+  std::memset( &attr, 0, sizeof( attr ));
+  attr.size = sizeof( attr );
+  attr.type = type;
+  attr.config = config;
+  attr.disabled = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  return int( syscall( SYS_perf_event_open, &attr, 0, -1, -1, 0 ));
+}
+
+static uint64_t cacheEvent( uint64_t cache )
+{
+  return cache | ( PERF_COUNT_HW_CACHE_OP_READ << 8 ) | ( PERF_COUNT_HW_CACHE_RESULT_MISS << 16 );
+}
+#endif
+
+PerfCounters::PerfCounters()
+{
+  for ( unsigned i = 0; i < COUNTERS; ++i )
+  {
+    fds[ i ] = -1;
+    values[ i ] = 0;
+  }
+#ifdef __linux__
+  fds[ CACHE_MISSES ] = openCounter( PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES );
+  fds[ L1D_MISSES ] = openCounter( PERF_TYPE_HW_CACHE, cacheEvent( PERF_COUNT_HW_CACHE_L1D ));
+  fds[ DTLB_MISSES ] = openCounter( PERF_TYPE_HW_CACHE, cacheEvent( PERF_COUNT_HW_CACHE_DTLB ));
+#endif
+}
+
+PerfCounters::~PerfCounters()
+{
+#ifdef __linux__
+  for ( int fd : fds ) if ( fd >= 0 ) close( fd );
+#endif
+}
+
+const char* PerfCounters::name( Counter counter )
+{
+  switch ( counter )
+  {
+    case CACHE_MISSES: return "llc-miss";
+    case L1D_MISSES: return "l1d-miss";
+    case DTLB_MISSES: return "dtlb-miss";
+    default: return "?";
+  }
+}
+
+bool PerfCounters::anyAvailable() const
+{
+  for ( int fd : fds ) if ( fd >= 0 ) return true;
+  return false;
+}
+
+void PerfCounters::start()
+{
+#ifdef __linux__
+  for ( int fd : fds )
+  {
+    if ( fd < 0 ) continue;
+    ioctl( fd, PERF_EVENT_IOC_RESET, 0 );
+    ioctl( fd, PERF_EVENT_IOC_ENABLE, 0 );
+  }
+#endif
+}
+
+void PerfCounters::stop()
+{
+#ifdef __linux__
+  for ( unsigned i = 0; i < COUNTERS; ++i )
+  {
+    if ( fds[ i ] < 0 ) continue;
+    ioctl( fds[ i ], PERF_EVENT_IOC_DISABLE, 0 );
+    uint64_t count = 0;
+    values[ i ] = read( fds[ i ], &count, sizeof( count )) == sizeof( count ) ? count : 0;
+  }
+#endif
+}
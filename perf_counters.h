@@ -0,0 +1,49 @@
+///
+/// Hardware event counts around a piece of work, for the benchmarks.
+/// (C) Andrew Brownbill 2019
+///
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <cstdint>
+
+// Cache and TLB misses in user space, from perf_event_open.  Only on
+// Linux, and only where the kernel allows it (perf_event_paranoid 2 or
+// lower, a PMU the VM or container passes through).  Counters that
+// couldn't be opened read as unavailable.
+class PerfCounters
+{
+  public:
+
+  enum Counter
+  {
+    CACHE_MISSES,     // Last level cache
+    L1D_MISSES,       // L1 data cache read misses
+    DTLB_MISSES,      // Data TLB read misses
+    COUNTERS
+  };
+
+  PerfCounters();
+  PerfCounters( const PerfCounters& ) = delete;
+  PerfCounters& operator=( const PerfCounters& ) = delete;
+  ~PerfCounters();
+
+  static const char* name( Counter counter );
+
+  bool available( Counter counter ) const { return fds[ counter ] >= 0; }
+  bool anyAvailable() const;
+
+  void start();
+  void stop();
+
+  // What the last start() / stop() counted.
+  uint64_t value( Counter counter ) const { return values[ counter ]; }
+
+  private:
+
+  int fds[ COUNTERS ];
+  uint64_t values[ COUNTERS ];
+};
+
+#endif
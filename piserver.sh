@@ -1,5 +1,5 @@
 #!/bin/sh
 
 cd docs
-python3 -m http.server
+python3 ../serve.py
 
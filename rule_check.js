@@ -0,0 +1,159 @@
+//
+// Runs rule kernels from gol_rulegen under node, no browser needed.
+// (C) Andrew Brownbill 2019
+//
+// node rule_check.js KERNEL.wasm LOOKUP.wasm [RULE] [WIDTH HEIGHT GENERATIONS]
+//
+// Steps a random board with the rule's compiled kernel and with the
+// generic lookup kernel, checks both against a plain cell by cell step in
+// javascript, and prints how fast each kernel went.  RULE (B3/S23 by
+// default) has to be the one KERNEL.wasm was written for, without
+// --shared.
+//
+
+'use strict';
+
+const fs = require( 'fs' );
+
+const args = process.argv.slice( 2 );
+if ( args.length < 2 ) {
+  console.error( 'usage: node rule_check.js KERNEL.wasm LOOKUP.wasm [RULE] [WIDTH HEIGHT GENERATIONS]' );
+  process.exit( 2 );
+}
+const rule = args[ 2 ] || 'B3/S23';
+const width = Number( args[ 3 ] || 1024 );
+const height = Number( args[ 4 ] || 768 );
+const generations = Number( args[ 5 ] || 100 );
+const words = width / 64;
+if ( !Number.isInteger( words ) || words < 1 ) {
+  console.error( 'width must be a multiple of 64' );
+  process.exit( 2 );
+}
+
+// Masks of the neighbor counts that give birth and that survive.
+function parseRule( text ) {
+  const match = /^B([0-8]*)\/S([0-8]*)$/i.exec( text );
+  if ( !match ) throw new Error( 'expected B/S notation like B3/S23, not ' + text );
+  const mask = digits => [ ...digits ].reduce(( m, d ) => m | ( 1 << Number( d )), 0 );
+  return { birth: mask( match[ 1 ] ), survive: mask( match[ 2 ] ) };
+}
+const masks = parseRule( rule );
+
+// Memory layout: two boards, three padded rows and the lookup table, in
+// 64 bit words.
+const boardWords = words * height;
+const padded = words + 2;
+const layout = { a: 0, b: boardWords, rows: 2 * boardWords, table: 2 * boardWords + 3 * padded };
+const bytes = ( layout.table + 4 ) * 8;
+const memory = new WebAssembly.Memory({ initial: Math.ceil( bytes / 65536 ) + 1 });
+
+function instantiate( file ) {
+  const module = new WebAssembly.Module( fs.readFileSync( file ));
+  try {
+    return new WebAssembly.Instance( module, { env: { memory }}).exports.row;
+  }
+  catch ( e ) {
+    // A --shared kernel wants a shared memory.
+    throw new Error( file + ': ' + e.message + ' (write it without --shared)' );
+  }
+}
+const kernel = instantiate( args[ 0 ] );
+const lookup = instantiate( args[ 1 ] );
+
+const cells = new BigUint64Array( memory.buffer );
+const table = new Uint8Array( memory.buffer, layout.table * 8, 32 );
+for ( let n = 0; n <= 8; ++n ) {
+  table[ n ] = ( masks.birth >> n ) & 1;
+  table[ 16 + n ] = ( masks.survive >> n ) & 1;
+}
+
+// Same as advanceRows in rule_kernel.h: pad each row once into a ring of
+// three and step the middle one.
+function advance( src, dst, row ) {
+  const ring = [ 0, 1, 2 ].map( i => layout.rows + i * padded );
+  const pad = ( y, at ) => {
+    const start = src + y * words;
+    cells[ at ] = cells[ start + words - 1 ];
+    cells.copyWithin( at + 1, start, start + words );
+    cells[ at + words + 1 ] = cells[ start ];
+  };
+  pad( height - 1, ring[ 0 ] );
+  pad( 0, ring[ 1 ] );
+  for ( let y = 0; y < height; ++y ) {
+    pad( y + 1 < height ? y + 1 : 0, ring[ ( y + 2 ) % 3 ] );
+    row( ring[ y % 3 ] * 8, ring[ ( y + 1 ) % 3 ] * 8, ring[ ( y + 2 ) % 3 ] * 8, ( dst + y * words ) * 8, words,
+         layout.table * 8 );
+  }
+}
+
+// The reference, a byte per cell.
+function referenceStep( grid ) {
+  const next = new Uint8Array( grid.length );
+  for ( let y = 0; y < height; ++y ) {
+    const up = (( y + height - 1 ) % height ) * width, mid = y * width, down = (( y + 1 ) % height ) * width;
+    for ( let x = 0; x < width; ++x ) {
+      const west = ( x + width - 1 ) % width, east = ( x + 1 ) % width;
+      const n = grid[ up + west ] + grid[ up + x ] + grid[ up + east ] + grid[ mid + west ] + grid[ mid + east ] +
+                grid[ down + west ] + grid[ down + x ] + grid[ down + east ];
+      next[ mid + x ] = (( grid[ mid + x ] ? masks.survive : masks.birth ) >> n ) & 1;
+    }
+  }
+  return next;
+}
+
+let seed = 1;
+function random() {
+  seed = ( seed * 1103515245 + 12345 ) & 0x7fffffff;
+  return seed / 0x80000000;
+}
+const start = new Uint8Array( width * height );
+for ( let i = 0; i < start.length; ++i ) start[ i ] = random() < 0.35 ? 1 : 0;
+
+function loadBoard( grid, at ) {
+  for ( let y = 0; y < height; ++y ) {
+    for ( let w = 0; w < words; ++w ) {
+      let word = 0n;
+      for ( let i = 63; i >= 0; --i ) word = ( word << 1n ) | BigInt( grid[ y * width + w * 64 + i ] );
+      cells[ at + y * words + w ] = word;
+    }
+  }
+}
+
+function sameBoard( grid, at ) {
+  for ( let y = 0; y < height; ++y ) {
+    for ( let x = 0; x < width; ++x ) {
+      const word = cells[ at + y * words + Math.floor( x / 64 ) ];
+      if ( Number(( word >> BigInt( x % 64 )) & 1n ) !== grid[ y * width + x ] ) return false;
+    }
+  }
+  return true;
+}
+
+// Runs the kernel for all the generations, returns seconds and whether
+// it ended where the reference did.
+function run( row, expected ) {
+  loadBoard( start, layout.a );
+  let src = layout.a, dst = layout.b;
+  const begin = process.hrtime.bigint();
+  for ( let g = 0; g < generations; ++g ) {
+    advance( src, dst, row );
+    [ src, dst ] = [ dst, src ];
+  }
+  const seconds = Number( process.hrtime.bigint() - begin ) / 1e9;
+  return { seconds, same: sameBoard( expected, src ) };
+}
+
+let expected = start;
+for ( let g = 0; g < generations; ++g ) expected = referenceStep( expected );
+
+console.log( width + 'x' + height + ', ' + generations + ' generations, ' + rule );
+let failed = false;
+for ( const [ name, row ] of [[ 'compiled', kernel ], [ 'lookup', lookup ]] ) {
+  run( row, expected );                                   // warm up the engine's tiers
+  const result = run( row, expected );
+  const gcells = width * height * generations / result.seconds / 1e9;
+  console.log( name.padEnd( 10 ) + ( generations / result.seconds ).toFixed( 1 ).padStart( 10 ) + ' gen/s ' +
+               gcells.toFixed( 3 ).padStart( 10 ) + ' Gcell/s' + ( result.same ? '' : '  MISMATCH' ));
+  failed = failed || !result.same;
+}
+process.exit( failed ? 1 : 0 );
@@ -0,0 +1,482 @@
+///
+/// Life-like rules as small boolean circuits over bit sliced counts.
+/// (C) Andrew Brownbill 2019
+///
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+
+#include "rule_circuit.h"
+
+// A truth table over the 32 combinations of alive and a 4 bit count,
+// bit alive * 16 + count.  Variable v of a combination is bit v of its
+// index, which is also input v of the circuit.
+using Truth = uint32_t;
+
+constexpr unsigned VARIABLES = RuleCircuit::INPUTS;
+constexpr unsigned COMBINATIONS = 1u << VARIABLES;
+
+// Counts 9 to 15 never happen; what a circuit does with them doesn't
+// matter.
+static Truth possible()
+{
+  Truth truth = 0;
+  for ( unsigned alive = 0; alive < 2; ++alive ) {
+    for ( unsigned n = 0; n <= LifeRule::MAX_NEIGHBORS; ++n ) truth |= 1u << ( alive * 16 + n );
+  }
+  return truth;
+}
+
+// The combinations where the count is in mask, alive or not.
+static Truth countsIn( uint16_t mask )
+{
+  Truth truth = 0;
+  for ( unsigned n = 0; n <= LifeRule::MAX_NEIGHBORS; ++n ) {
+    if (( mask >> n ) & 1 ) truth |= ( 1u << n ) | ( 1u << ( 16 + n ));
+  }
+  return truth;
+}
+
+// A product of variables: the ones in care, each true if its bit in
+// value is set, false if not.
+class Cube
+{
+  public:
+
+  uint32_t value;
+  uint32_t care;
+
+  bool covers( unsigned combination ) const { return ( combination & care ) == value; }
+  bool operator<( const Cube& other ) const { return care != other.care ? care < other.care : value < other.value; }
+  bool operator==( const Cube& other ) const { return care == other.care && value == other.value; }
+
+  Truth truth() const
+  {
+    Truth t = 0;
+    for ( unsigned i = 0; i < COMBINATIONS; ++i ) if ( covers( i )) t |= 1u << i;
+    return t;
+  }
+};
+
+// The prime implicants of on, don't cares allowed to join in, by merging
+// cubes that differ in one variable until nothing merges.  Primes that
+// only cover don't cares are dropped.
+static std::vector< Cube > primes( Truth on, Truth dontCare )
+{
+  const uint32_t all = COMBINATIONS - 1;
+  std::vector< Cube > level;
+  for ( unsigned i = 0; i < COMBINATIONS; ++i ) {
+    if ((( on | dontCare ) >> i ) & 1 ) level.push_back( Cube{ i, all } );
+  }
+  std::vector< Cube > found;
+  while ( !level.empty() )
+  {
+    std::vector< bool > merged( level.size(), false );
+    std::vector< Cube > next;
+    for ( size_t i = 0; i < level.size(); ++i ) {
+      for ( size_t j = i + 1; j < level.size(); ++j )
+      {
+        if ( level[i].care != level[j].care ) continue;
+        const uint32_t differ = level[i].value ^ level[j].value;
+        if ( __builtin_popcount( differ ) != 1 ) continue;
+        next.push_back( Cube{ level[i].value & ~differ, level[i].care & ~differ } );
+        merged[i] = merged[j] = true;
+      }
+    }
+    for ( size_t i = 0; i < level.size(); ++i ) {
+      if ( !merged[i] && ( level[i].truth() & on )) found.push_back( level[i] );
+    }
+    std::sort( next.begin(), next.end() );
+    next.erase( std::unique( next.begin(), next.end() ), next.end() );
+    level.swap( next );
+  }
+  return found;
+}
+
+static unsigned literals( const Cube& cube ) { return unsigned( __builtin_popcount( cube.care )); }
+
+// The fewest primes covering on, then the fewest literals.  An exact
+// search, small enough at five variables: branch on the primes covering
+// the combination fewest of them cover.
+static std::vector< Cube > cover( const std::vector< Cube >& candidates, Truth on )
+{
+  std::vector< Truth > covered;
+  for ( const Cube& cube : candidates ) covered.push_back( cube.truth() );
+
+  std::vector< size_t > chosen, best;
+  unsigned bestCost = ~0u;
+  std::function< void( Truth, unsigned ) > search = [&]( Truth left, unsigned cost ) {
+    if ( cost >= bestCost ) return;
+    if ( !left )
+    {
+      best = chosen;
+      bestCost = cost;
+      return;
+    }
+    unsigned pick = 0;
+    size_t fewest = ~size_t( 0 );
+    for ( unsigned i = 0; i < COMBINATIONS; ++i )
+    {
+      if (!(( left >> i ) & 1 )) continue;
+      size_t count = 0;
+      for ( Truth t : covered ) count += ( t >> i ) & 1;
+      if ( count < fewest ) { fewest = count; pick = i; }
+    }
+    for ( size_t p = 0; p < candidates.size(); ++p )
+    {
+      if (!(( covered[p] >> pick ) & 1 )) continue;
+      chosen.push_back( p );
+      // A cube costs a gate to join in and one per literal past the first.
+      search( left & ~covered[p], cost + literals( candidates[p] ) + 1 );
+      chosen.pop_back();
+    }
+  };
+  search( on, 0 );
+
+  std::vector< Cube > cubes;
+  for ( size_t p : best ) cubes.push_back( candidates[p] );
+  return cubes;
+}
+
+// A node or its complement, one factor of a product.
+class Factor
+{
+  public:
+
+  unsigned node;
+  bool negated;
+
+  bool operator<( const Factor& other ) const
+  {
+    return node != other.node ? node < other.node : negated < other.negated;
+  }
+  bool operator==( const Factor& other ) const { return node == other.node && negated == other.negated; }
+};
+
+using Term = std::vector< Factor >;      // Sorted
+
+static std::vector< Term > terms( const std::vector< Cube >& cubes )
+{
+  std::vector< Term > sum;
+  for ( const Cube& cube : cubes )
+  {
+    Term term;
+    for ( unsigned v = 0; v < VARIABLES; ++v ) {
+      if (( cube.care >> v ) & 1 ) term.push_back( Factor{ v, (( cube.value >> v ) & 1 ) == 0 } );
+    }
+    sum.push_back( term );
+  }
+  return sum;
+}
+
+// p & x & ~y | p & ~x & y is p & ( x ^ y ), and with x and y the same
+// way round in both, p & ~( x ^ y ).  Merge every such pair.
+static void mergeXors( RuleCircuit& circuit, std::vector< Term >& sum )
+{
+  for ( bool again = true; again; )
+  {
+    again = false;
+    for ( size_t i = 0; i < sum.size() && !again; ++i ) {
+      for ( size_t j = i + 1; j < sum.size() && !again; ++j )
+      {
+        Term onlyI, onlyJ, shared;
+        std::set_difference( sum[i].begin(), sum[i].end(), sum[j].begin(), sum[j].end(), std::back_inserter( onlyI ));
+        std::set_difference( sum[j].begin(), sum[j].end(), sum[i].begin(), sum[i].end(), std::back_inserter( onlyJ ));
+        if ( onlyI.size() != 2 || onlyJ.size() != 2 ) continue;
+        if ( onlyI[0].node != onlyJ[0].node || onlyI[1].node != onlyJ[1].node ) continue;
+        if ( onlyI[0].negated == onlyJ[0].negated || onlyI[1].negated == onlyJ[1].negated ) continue;
+        std::set_intersection( sum[i].begin(), sum[i].end(), sum[j].begin(), sum[j].end(), std::back_inserter( shared ));
+        const unsigned x = circuit.gate( RuleCircuit::Op::Xor, onlyI[0].node, onlyI[1].node );
+        shared.push_back( Factor{ x, onlyI[0].negated == onlyI[1].negated } );
+        std::sort( shared.begin(), shared.end() );
+        sum[i] = shared;
+        sum.erase( sum.begin() + j );
+        again = true;
+      }
+    }
+  }
+}
+
+// The product of a term's factors.  The complemented ones go in as
+// and-nots; with nothing to and them into, ~a & ~b is ~( a | b ).
+static unsigned product( RuleCircuit& circuit, const Term& term )
+{
+  unsigned node = 0;
+  bool any = false;
+  for ( const Factor& f : term )
+  {
+    if ( f.negated ) continue;
+    node = any ? circuit.gate( RuleCircuit::Op::And, node, f.node ) : f.node;
+    any = true;
+  }
+  if ( !any )
+  {
+    unsigned either = term[0].node;
+    for ( size_t i = 1; i < term.size(); ++i ) either = circuit.gate( RuleCircuit::Op::Or, either, term[i].node );
+    return circuit.gate( RuleCircuit::Op::Not, either );
+  }
+  for ( const Factor& f : term ) {
+    if ( f.negated ) node = circuit.gate( RuleCircuit::Op::AndNot, node, f.node );
+  }
+  return node;
+}
+
+// A sum of products, the factor most of them share pulled out, over and
+// over.
+static unsigned factor( RuleCircuit& circuit, const std::vector< Term >& sum )
+{
+  if ( sum.empty() ) return circuit.zero();
+  for ( const Term& term : sum ) if ( term.empty() ) return circuit.one();
+
+  std::vector< Factor > all;
+  for ( const Term& term : sum ) all.insert( all.end(), term.begin(), term.end() );
+  std::sort( all.begin(), all.end() );
+  Factor most = all[0];
+  size_t mostCount = 0;
+  for ( size_t i = 0; i < all.size(); )
+  {
+    size_t j = i;
+    while ( j < all.size() && all[j] == all[i] ) ++j;
+    if ( j - i > mostCount ) { mostCount = j - i; most = all[i]; }
+    i = j;
+  }
+
+  if ( mostCount < 2 )
+  {
+    unsigned node = product( circuit, sum[0] );
+    for ( size_t i = 1; i < sum.size(); ++i ) node = circuit.gate( RuleCircuit::Op::Or, node, product( circuit, sum[i] ));
+    return node;
+  }
+
+  std::vector< Term > with, without;
+  for ( const Term& term : sum )
+  {
+    auto found = std::find( term.begin(), term.end(), most );
+    if ( found == term.end() ) { without.push_back( term ); continue; }
+    Term rest( term.begin(), found );
+    rest.insert( rest.end(), found + 1, term.end() );
+    with.push_back( rest );
+  }
+  const unsigned inner = factor( circuit, with );
+  const unsigned combined = most.negated ? circuit.gate( RuleCircuit::Op::AndNot, inner, most.node )
+                                         : circuit.gate( RuleCircuit::Op::And, inner, most.node );
+  return without.empty() ? combined : circuit.gate( RuleCircuit::Op::Or, combined, factor( circuit, without ));
+}
+
+// Gates it takes to add build's function to circuit.
+static unsigned cost( const RuleCircuit& circuit, const std::function< unsigned( RuleCircuit& ) >& build )
+{
+  RuleCircuit trial = circuit;
+  build( trial );
+  return unsigned( trial.gates().size() - circuit.gates().size() );
+}
+
+// The sum of products of on, or the complement of that of its
+// complement, whichever is smaller.
+static unsigned function( RuleCircuit& circuit, Truth on, Truth dontCare )
+{
+  auto sum = [=]( RuleCircuit& c, Truth t ) {
+    std::vector< Term > sum = terms( cover( primes( t, dontCare ), t ));
+    mergeXors( c, sum );
+    return factor( c, sum );
+  };
+  const Truth off = ~on & ~dontCare;
+  auto direct = [&]( RuleCircuit& c ) { return sum( c, on ); };
+  auto inverted = [&]( RuleCircuit& c ) { return c.gate( RuleCircuit::Op::Not, sum( c, off )); };
+  return cost( circuit, direct ) <= cost( circuit, inverted ) ? direct( circuit ) : inverted( circuit );
+}
+
+RuleCircuit RuleCircuit::synthesize( const LifeRule& rule )
+{
+  const Truth dontCare = ~possible();
+  const Truth birth = countsIn( rule.birth ) & ~dontCare;
+  const Truth survive = countsIn( rule.survive ) & ~dontCare;
+  const Truth alive = 0xffff0000u;
+  const Truth next = ( birth & ~alive ) | ( survive & alive );
+
+  std::vector< std::function< unsigned( RuleCircuit& ) >> shapes = {
+    [&]( RuleCircuit& c ) { return function( c, next, dontCare ); },
+    [&]( RuleCircuit& c ) {
+      const unsigned born = c.gate( Op::AndNot, function( c, birth, dontCare ), ALIVE );
+      return c.gate( Op::Or, born, c.gate( Op::And, function( c, survive, dontCare ), ALIVE ));
+    },
+    [&]( RuleCircuit& c ) {
+      const unsigned differs = c.gate( Op::And, function( c, birth ^ survive, dontCare ), ALIVE );
+      return c.gate( Op::Xor, function( c, birth, dontCare ), differs );
+    },
+  };
+  if (( birth & ~survive ) == 0 ) {
+    shapes.push_back( [&]( RuleCircuit& c ) {
+      return c.gate( Op::Or, function( c, birth, dontCare ), c.gate( Op::And, function( c, survive, dontCare ), ALIVE ));
+    });
+  }
+  if (( survive & ~birth ) == 0 ) {
+    shapes.push_back( [&]( RuleCircuit& c ) {
+      return c.gate( Op::Or, function( c, survive, dontCare ), c.gate( Op::AndNot, function( c, birth, dontCare ), ALIVE ));
+    });
+  }
+
+  RuleCircuit best;
+  bool any = false;
+  for ( const auto& shape : shapes )
+  {
+    RuleCircuit circuit;
+    circuit.result = shape( circuit );
+    circuit.prune();
+    if ( !any || circuit.gateList.size() < best.gateList.size() ) best = circuit;
+    any = true;
+  }
+
+  const std::vector< Truth > tables = best.truthTables();
+  if (( tables[ best.result ] ^ next ) & ~dontCare ) {
+    throw std::logic_error( "RuleCircuit::synthesize got " + rule.toString() + " wrong" );
+  }
+  return best;
+}
+
+unsigned RuleCircuit::zero()
+{
+  for ( size_t i = 0; i < gateList.size(); ++i ) if ( gateList[i].op == Op::Zero ) return INPUTS + unsigned( i );
+  gateList.push_back( Gate{ Op::Zero, 0, 0 } );
+  return nodes() - 1;
+}
+
+unsigned RuleCircuit::one()
+{
+  for ( size_t i = 0; i < gateList.size(); ++i ) if ( gateList[i].op == Op::One ) return INPUTS + unsigned( i );
+  gateList.push_back( Gate{ Op::One, 0, 0 } );
+  return nodes() - 1;
+}
+
+unsigned RuleCircuit::gate( Op op, unsigned a, unsigned b )
+{
+  auto is = [&]( unsigned node, Op constant ) { return node >= INPUTS && gateList[ node - INPUTS ].op == constant; };
+  switch ( op )
+  {
+    case Op::Zero: return zero();
+    case Op::One: return one();
+    case Op::Not:
+      if ( is( a, Op::Zero )) return one();
+      if ( is( a, Op::One )) return zero();
+      if ( a >= INPUTS && gateList[ a - INPUTS ].op == Op::Not ) return gateList[ a - INPUTS ].a;
+      break;
+    case Op::And:
+      if ( is( a, Op::Zero ) || is( b, Op::Zero )) return zero();
+      if ( is( a, Op::One ) || a == b ) return b;
+      if ( is( b, Op::One )) return a;
+      break;
+    case Op::Or:
+      if ( is( a, Op::One ) || is( b, Op::One )) return one();
+      if ( is( a, Op::Zero ) || a == b ) return b;
+      if ( is( b, Op::Zero )) return a;
+      break;
+    case Op::Xor:
+      if ( a == b ) return zero();
+      if ( is( a, Op::Zero )) return b;
+      if ( is( b, Op::Zero )) return a;
+      if ( is( a, Op::One )) return gate( Op::Not, b );
+      if ( is( b, Op::One )) return gate( Op::Not, a );
+      break;
+    case Op::AndNot:
+      if ( a == b || is( a, Op::Zero ) || is( b, Op::One )) return zero();
+      if ( is( b, Op::Zero )) return a;
+      if ( is( a, Op::One )) return gate( Op::Not, b );
+      break;
+  }
+  if ( op == Op::Not ) b = 0;
+  if (( op == Op::And || op == Op::Or || op == Op::Xor ) && b < a ) std::swap( a, b );
+  for ( size_t i = 0; i < gateList.size(); ++i )
+  {
+    const Gate& g = gateList[i];
+    if ( g.op == op && g.a == a && g.b == b ) return INPUTS + unsigned( i );
+  }
+  gateList.push_back( Gate{ op, a, b } );
+  return nodes() - 1;
+}
+
+void RuleCircuit::prune()
+{
+  std::vector< bool > used( nodes(), false );
+  used[ result ] = true;
+  for ( size_t i = gateList.size(); i-- > 0; )
+  {
+    if ( !used[ INPUTS + i ] ) continue;
+    const Gate& g = gateList[i];
+    if ( g.op == Op::Zero || g.op == Op::One ) continue;
+    used[ g.a ] = true;
+    if ( g.op != Op::Not ) used[ g.b ] = true;
+  }
+  std::vector< unsigned > moved( nodes() );
+  for ( unsigned i = 0; i < INPUTS; ++i ) moved[i] = i;
+  std::vector< Gate > kept;
+  for ( size_t i = 0; i < gateList.size(); ++i )
+  {
+    if ( !used[ INPUTS + i ] ) continue;
+    Gate g = gateList[i];
+    if ( g.op != Op::Zero && g.op != Op::One ) {
+      g.a = moved[ g.a ];
+      if ( g.op != Op::Not ) g.b = moved[ g.b ];
+    }
+    moved[ INPUTS + i ] = INPUTS + unsigned( kept.size() );
+    kept.push_back( g );
+  }
+  result = moved[ result ];
+  gateList.swap( kept );
+}
+
+std::vector< uint32_t > RuleCircuit::truthTables() const
+{
+  std::vector< uint32_t > tables( nodes() );
+  for ( unsigned v = 0; v < INPUTS; ++v ) {
+    for ( unsigned i = 0; i < COMBINATIONS; ++i ) if (( i >> v ) & 1 ) tables[v] |= 1u << i;
+  }
+  for ( size_t i = 0; i < gateList.size(); ++i )
+  {
+    const Gate& g = gateList[i];
+    uint32_t& t = tables[ INPUTS + i ];
+    switch ( g.op )
+    {
+      case Op::Zero: t = 0; break;
+      case Op::One: t = ~0u; break;
+      case Op::And: t = tables[ g.a ] & tables[ g.b ]; break;
+      case Op::Or: t = tables[ g.a ] | tables[ g.b ]; break;
+      case Op::Xor: t = tables[ g.a ] ^ tables[ g.b ]; break;
+      case Op::AndNot: t = tables[ g.a ] & ~tables[ g.b ]; break;
+      case Op::Not: t = ~tables[ g.a ]; break;
+    }
+  }
+  return tables;
+}
+
+bool RuleCircuit::evaluate( bool alive, unsigned neighbors ) const
+{
+  return ( truthTables()[ result ] >> (( alive ? 16 : 0 ) + neighbors )) & 1;
+}
+
+std::string RuleCircuit::toString() const
+{
+  static const char* const inputNames[ INPUTS ] = { "ones", "twos", "fours", "eights", "alive" };
+  auto name = [&]( unsigned node ) {
+    return node < INPUTS ? std::string( inputNames[ node ] ) : "g" + std::to_string( node );
+  };
+  std::string text;
+  for ( size_t i = 0; i < gateList.size(); ++i )
+  {
+    const Gate& g = gateList[i];
+    text += name( INPUTS + unsigned( i )) + " = ";
+    switch ( g.op )
+    {
+      case Op::Zero: text += "0"; break;
+      case Op::One: text += "1"; break;
+      case Op::And: text += name( g.a ) + " & " + name( g.b ); break;
+      case Op::Or: text += name( g.a ) + " | " + name( g.b ); break;
+      case Op::Xor: text += name( g.a ) + " ^ " + name( g.b ); break;
+      case Op::AndNot: text += name( g.a ) + " & ~" + name( g.b ); break;
+      case Op::Not: text += "~" + name( g.a ); break;
+    }
+    text += "; ";
+  }
+  return text + "-> " + name( result );
+}
@@ -0,0 +1,87 @@
+///
+/// Life-like rules as small boolean circuits over bit sliced counts.
+/// (C) Andrew Brownbill 2019
+///
+
+#ifndef RULE_CIRCUIT_H
+#define RULE_CIRCUIT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "life_rule.h"
+
+// A rule as a network of and / or / xor gates over the bit sliced
+// neighbor count, the planes holding bits 0 to 3 of every cell's count,
+// and the cell itself.  Run over whole words it steps 64 cells at once,
+// the way the hand written B3/S23 kernels do, for any rule.
+//
+// synthesize() builds the network from the rule's masks: a minimum sum
+// of products (Quine-McCluskey, counts past 8 being don't cares), pairs
+// of products that differ in two opposite literals merged into an xor,
+// then factored on the most shared literals.  That's tried on the rule
+// as a whole, on its complement, and on birth and survival separately
+// with the cell choosing between them; the fewest gates wins.  B3/S23
+// comes out as twos & ~fours & ( ones | alive ), three gates.
+class RuleCircuit
+{
+  public:
+
+  // Nodes 0 to INPUTS - 1 are the inputs, gates follow in the order
+  // they're evaluated, each only reading nodes before it.
+  enum Input : unsigned { ONES, TWOS, FOURS, EIGHTS, ALIVE, INPUTS };
+
+  enum class Op : uint8_t
+  {
+    Zero,       // All cells dead
+    One,        // All alive
+    And,
+    Or,
+    Xor,
+    AndNot,     // a & ~b
+    Not         // ~a
+  };
+
+  class Gate
+  {
+    public:
+
+    Op op;
+    unsigned a;
+    unsigned b;
+  };
+
+  static RuleCircuit synthesize( const LifeRule& rule );
+
+  // All the nodes, inputs then gates.
+  unsigned nodes() const { return INPUTS + unsigned( gateList.size() ); }
+  const std::vector< Gate >& gates() const { return gateList; }
+  unsigned output() const { return result; }
+
+  // Run it on one cell.
+  bool evaluate( bool alive, unsigned neighbors ) const;
+
+  // e.g. "g5 = twos & ~fours; g6 = ones | alive; g7 = g5 & g6; -> g7"
+  std::string toString() const;
+
+  // Node to add gates to, folding constants and sharing repeats.  For
+  // synthesize().
+  unsigned zero();
+  unsigned one();
+  unsigned gate( Op op, unsigned a, unsigned b = 0 );
+
+  private:
+
+  // Drop the gates the output doesn't use.
+  void prune();
+
+  // Truth tables of every node over the 32 combinations of alive and a
+  // 4 bit count, bit alive * 16 + count.
+  std::vector< uint32_t > truthTables() const;
+
+  std::vector< Gate > gateList;
+  unsigned result = 0;
+};
+
+#endif
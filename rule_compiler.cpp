@@ -0,0 +1,531 @@
+///
+/// Writes WebAssembly kernels specialized to one life-like rule.
+/// (C) Andrew Brownbill 2019
+///
+
+#include <map>
+#include <string>
+
+#include "rule_compiler.h"
+
+#if defined( __EMSCRIPTEN__ ) && !defined( __wasm64__ )
+#include <emscripten.h>
+#endif
+
+// Value types.
+constexpr uint8_t I32 = 0x7f;
+constexpr uint8_t I64 = 0x7e;
+constexpr uint8_t V128 = 0x7b;
+
+// Instructions, from the binary format.
+constexpr uint8_t BLOCK = 0x02;
+constexpr uint8_t LOOP = 0x03;
+constexpr uint8_t END = 0x0b;
+constexpr uint8_t BR = 0x0c;
+constexpr uint8_t BR_IF = 0x0d;
+constexpr uint8_t EMPTY_TYPE = 0x40;
+constexpr uint8_t LOCAL_GET = 0x20;
+constexpr uint8_t LOCAL_SET = 0x21;
+constexpr uint8_t LOCAL_TEE = 0x22;
+constexpr uint8_t I64_LOAD = 0x29;
+constexpr uint8_t I64_LOAD8_U = 0x31;
+constexpr uint8_t I64_STORE = 0x37;
+constexpr uint8_t I32_CONST = 0x41;
+constexpr uint8_t I64_CONST = 0x42;
+constexpr uint8_t I32_GT_U = 0x4b;
+constexpr uint8_t I64_LT_U = 0x54;
+constexpr uint8_t I32_ADD = 0x6a;
+constexpr uint8_t I32_SHL = 0x74;
+constexpr uint8_t I64_ADD = 0x7c;
+constexpr uint8_t I64_AND = 0x83;
+constexpr uint8_t I64_OR = 0x84;
+constexpr uint8_t I64_XOR = 0x85;
+constexpr uint8_t I64_SHL = 0x86;
+constexpr uint8_t I64_SHR_U = 0x88;
+constexpr uint8_t I32_WRAP_I64 = 0xa7;
+constexpr uint8_t SIMD_PREFIX = 0xfd;
+constexpr unsigned V128_LOAD = 0;
+constexpr unsigned V128_STORE = 11;
+constexpr unsigned V128_CONST = 12;
+constexpr unsigned V128_NOT = 77;
+constexpr unsigned V128_AND = 78;
+constexpr unsigned V128_ANDNOT = 79;
+constexpr unsigned V128_OR = 80;
+constexpr unsigned V128_XOR = 81;
+constexpr unsigned I64X2_SHL = 203;
+constexpr unsigned I64X2_SHR_U = 205;
+
+// Bytes of a module being written.
+class Bytes : public std::vector< uint8_t >
+{
+  public:
+
+  void byte( uint8_t b ) { push_back( b ); }
+
+  void unsignedLeb( uint64_t value )
+  {
+    do {
+      uint8_t b = value & 0x7f;
+      value >>= 7;
+      if ( value ) b |= 0x80;
+      push_back( b );
+    } while ( value );
+  }
+
+  void signedLeb( int64_t value )
+  {
+    for ( ;; )
+    {
+      const uint8_t b = value & 0x7f;
+      value >>= 7;
+      const bool done = ( value == 0 && !( b & 0x40 )) || ( value == -1 && ( b & 0x40 ));
+      push_back( done ? b : b | 0x80 );
+      if ( done ) return;
+    }
+  }
+
+  void name( const std::string& text )
+  {
+    unsignedLeb( text.size() );
+    insert( end(), text.begin(), text.end() );
+  }
+
+  // Length prefixed, as sections and function bodies are.
+  void sized( const Bytes& contents )
+  {
+    unsignedLeb( contents.size() );
+    insert( end(), contents.begin(), contents.end() );
+  }
+};
+
+// A function's code, with its locals handed out by type.  Words, or
+// pairs of them, are kept in locals of one lane type, I64 or V128, each
+// value in a new local; the engine's register allocator sorts that out.
+class FunctionWriter
+{
+  public:
+
+  FunctionWriter( unsigned firstLocal, uint8_t laneType ) :
+    lane( laneType ), first( firstLocal ), count( 0 ) {}
+
+  unsigned locals() const { return count; }
+  uint8_t laneType() const { return lane; }
+
+  Bytes code;
+
+  unsigned local() { return first + count++; }
+
+  void get( unsigned index ) { code.byte( LOCAL_GET ); code.unsignedLeb( index ); }
+  void set( unsigned index ) { code.byte( LOCAL_SET ); code.unsignedLeb( index ); }
+
+  void simd( unsigned op ) { code.byte( SIMD_PREFIX ); code.unsignedLeb( op ); }
+
+  // The value on the stack into a new local.
+  unsigned keep()
+  {
+    const unsigned index = local();
+    set( index );
+    return index;
+  }
+
+  // Lanes at pointer + w + offset bytes.
+  unsigned load( unsigned pointer, unsigned w, unsigned offset )
+  {
+    address( pointer, w );
+    if ( lane == V128 ) simd( V128_LOAD ); else code.byte( I64_LOAD );
+    memoryArgument( offset );
+    return keep();
+  }
+
+  void store( unsigned pointer, unsigned w, unsigned value )
+  {
+    address( pointer, w );
+    get( value );
+    if ( lane == V128 ) simd( V128_STORE ); else code.byte( I64_STORE );
+    memoryArgument( 0 );
+  }
+
+  unsigned bitwise( unsigned a, unsigned b, uint8_t i64Op, unsigned v128Op )
+  {
+    get( a );
+    get( b );
+    if ( lane == V128 ) simd( v128Op ); else code.byte( i64Op );
+    return keep();
+  }
+
+  unsigned andOf( unsigned a, unsigned b ) { return bitwise( a, b, I64_AND, V128_AND ); }
+  unsigned orOf( unsigned a, unsigned b ) { return bitwise( a, b, I64_OR, V128_OR ); }
+  unsigned xorOf( unsigned a, unsigned b ) { return bitwise( a, b, I64_XOR, V128_XOR ); }
+
+  unsigned notOf( unsigned a )
+  {
+    get( a );
+    if ( lane == V128 ) simd( V128_NOT );
+    else {
+      code.byte( I64_CONST );
+      code.signedLeb( -1 );
+      code.byte( I64_XOR );
+    }
+    return keep();
+  }
+
+  // a & ~b
+  unsigned andNotOf( unsigned a, unsigned b )
+  {
+    if ( lane == V128 ) return bitwise( a, b, 0, V128_ANDNOT );
+    return andOf( a, notOf( b ));
+  }
+
+  unsigned shift( unsigned a, unsigned bits, uint8_t i64Op, unsigned v128Op )
+  {
+    get( a );
+    if ( lane == V128 ) {
+      code.byte( I32_CONST );
+      code.signedLeb( bits );
+      simd( v128Op );
+    }
+    else {
+      code.byte( I64_CONST );
+      code.signedLeb( bits );
+      code.byte( i64Op );
+    }
+    return keep();
+  }
+
+  unsigned shiftLeft( unsigned a, unsigned bits ) { return shift( a, bits, I64_SHL, I64X2_SHL ); }
+  unsigned shiftRight( unsigned a, unsigned bits ) { return shift( a, bits, I64_SHR_U, I64X2_SHR_U ); }
+
+  unsigned zero()
+  {
+    if ( lane == V128 ) {
+      simd( V128_CONST );
+      for ( unsigned i = 0; i < 16; ++i ) code.byte( 0 );
+    }
+    else {
+      code.byte( I64_CONST );
+      code.signedLeb( 0 );
+    }
+    return keep();
+  }
+
+  private:
+
+  void address( unsigned pointer, unsigned w )
+  {
+    get( pointer );
+    get( w );
+    code.byte( I32_ADD );
+  }
+
+  // Byte aligned, which is all a padded row promises for v128.
+  void memoryArgument( unsigned offset )
+  {
+    code.unsignedLeb( 0 );
+    code.unsignedLeb( offset );
+  }
+
+  uint8_t lane;
+  unsigned first;
+  unsigned count;
+};
+
+// Parameters, as in RowKernel, then the lookup kernel's table.
+constexpr unsigned UP = 0;
+constexpr unsigned MID = 1;
+constexpr unsigned DOWN = 2;
+constexpr unsigned OUT = 3;
+constexpr unsigned WORDS = 4;
+constexpr unsigned TABLE = 5;
+
+// The i32 locals after the parameters: byte offset of the current word
+// and of the end of the row.
+constexpr unsigned W = 0;
+constexpr unsigned END_OF_ROW = 1;
+constexpr unsigned I32_LOCALS = 2;
+
+// Bit sliced neighbor counts of the lanes at byte offset w of the padded
+// rows, as in rule_kernel.cpp.
+class CountLocals
+{
+  public:
+
+  unsigned alive, ones, twos, fours, eights;
+};
+
+static CountLocals writeCounts( FunctionWriter& f, unsigned w )
+{
+  auto neighbors = [&]( unsigned row, unsigned& west, unsigned& center, unsigned& east ) {
+    const unsigned before = f.load( row, w, 0 );
+    center = f.load( row, w, 8 );
+    const unsigned after = f.load( row, w, 16 );
+    west = f.orOf( f.shiftLeft( center, 1 ), f.shiftRight( before, 63 ));
+    east = f.orOf( f.shiftRight( center, 1 ), f.shiftLeft( after, 63 ));
+  };
+  auto fullAdd = [&]( unsigned a, unsigned b, unsigned c, unsigned& sum, unsigned& carry ) {
+    const unsigned u = f.xorOf( a, b );
+    sum = f.xorOf( u, c );
+    carry = f.orOf( f.andOf( a, b ), f.andOf( u, c ));
+  };
+
+  unsigned upWest, up, upEast, midWest, alive, midEast, downWest, down, downEast;
+  neighbors( UP, upWest, up, upEast );
+  neighbors( MID, midWest, alive, midEast );
+  neighbors( DOWN, downWest, down, downEast );
+
+  unsigned s1, c1, s2, c2, c4, t, d1;
+  fullAdd( upWest, up, upEast, s1, c1 );
+  fullAdd( midWest, midEast, downWest, s2, c2 );
+  const unsigned s3 = f.xorOf( down, downEast );
+  const unsigned c3 = f.andOf( down, downEast );
+
+  CountLocals counts;
+  counts.alive = alive;
+  fullAdd( s1, s2, s3, counts.ones, c4 );
+  fullAdd( c1, c2, c3, t, d1 );
+  counts.twos = f.xorOf( t, c4 );
+  const unsigned d2 = f.andOf( t, c4 );
+  counts.fours = f.xorOf( d1, d2 );
+  counts.eights = f.andOf( d1, d2 );
+  return counts;
+}
+
+// Next generation of the lanes at w by circuit, into out.
+static void writeRuleStep( FunctionWriter& f, unsigned w, const RuleCircuit& circuit )
+{
+  using Op = RuleCircuit::Op;
+  const CountLocals counts = writeCounts( f, w );
+  std::vector< unsigned > node = { counts.ones, counts.twos, counts.fours, counts.eights, counts.alive };
+  for ( const RuleCircuit::Gate& gate : circuit.gates() )
+  {
+    switch ( gate.op )
+    {
+      case Op::Zero: node.push_back( f.zero() ); break;
+      case Op::One: node.push_back( f.notOf( f.zero() )); break;
+      case Op::And: node.push_back( f.andOf( node[ gate.a ], node[ gate.b ] )); break;
+      case Op::Or: node.push_back( f.orOf( node[ gate.a ], node[ gate.b ] )); break;
+      case Op::Xor: node.push_back( f.xorOf( node[ gate.a ], node[ gate.b ] )); break;
+      case Op::AndNot: node.push_back( f.andNotOf( node[ gate.a ], node[ gate.b ] )); break;
+      case Op::Not: node.push_back( f.notOf( node[ gate.a ] )); break;
+    }
+  }
+  f.store( OUT, w, node[ circuit.output() ] );
+}
+
+// Cell by cell through the lookup table at TABLE.
+static void writeLookupStep( FunctionWriter& f, unsigned w )
+{
+  const CountLocals counts = writeCounts( f, w );
+  const unsigned next = f.zero();
+  const unsigned bit = f.zero();
+  const unsigned fields[ 5 ] = { counts.ones, counts.twos, counts.fours, counts.eights, counts.alive };
+  Bytes& code = f.code;
+  code.byte( LOOP );
+  code.byte( EMPTY_TYPE );
+  {
+    f.get( next );
+    f.get( TABLE );
+    for ( unsigned i = 0; i < 5; ++i )
+    {
+      f.get( fields[ i ] );
+      f.get( bit );
+      code.byte( I64_SHR_U );
+      code.byte( I64_CONST );
+      code.signedLeb( 1 );
+      code.byte( I64_AND );
+      if ( i ) {
+        code.byte( I64_CONST );
+        code.signedLeb( i );
+        code.byte( I64_SHL );
+        code.byte( I64_OR );
+      }
+    }
+    code.byte( I32_WRAP_I64 );
+    code.byte( I32_ADD );
+    code.byte( I64_LOAD8_U );
+    code.unsignedLeb( 0 );
+    code.unsignedLeb( 0 );
+    f.get( bit );
+    code.byte( I64_SHL );
+    code.byte( I64_OR );
+    f.set( next );
+
+    f.get( bit );
+    code.byte( I64_CONST );
+    code.signedLeb( 1 );
+    code.byte( I64_ADD );
+    code.byte( LOCAL_TEE );
+    code.unsignedLeb( bit );
+    code.byte( I64_CONST );
+    code.signedLeb( CELLS_PER_WORD );
+    code.byte( I64_LT_U );
+    code.byte( BR_IF );
+    code.unsignedLeb( 0 );
+  }
+  code.byte( END );
+  f.store( OUT, w, next );
+}
+
+// while ( w + step <= end ) { body; w += step; }
+static void writeLoop( Bytes& code, unsigned w, unsigned end, unsigned step, const Bytes& body )
+{
+  code.byte( BLOCK );
+  code.byte( EMPTY_TYPE );
+  code.byte( LOOP );
+  code.byte( EMPTY_TYPE );
+  code.byte( LOCAL_GET ); code.unsignedLeb( w );
+  code.byte( I32_CONST ); code.signedLeb( step );
+  code.byte( I32_ADD );
+  code.byte( LOCAL_GET ); code.unsignedLeb( end );
+  code.byte( I32_GT_U );
+  code.byte( BR_IF ); code.unsignedLeb( 1 );
+  code.insert( code.end(), body.begin(), body.end() );
+  code.byte( LOCAL_GET ); code.unsignedLeb( w );
+  code.byte( I32_CONST ); code.signedLeb( step );
+  code.byte( I32_ADD );
+  code.byte( LOCAL_SET ); code.unsignedLeb( w );
+  code.byte( BR ); code.unsignedLeb( 0 );
+  code.byte( END );
+  code.byte( END );
+}
+
+// A module around one function, "row", taking params i32s.  Its body is
+// a v128 loop over pairs of words, if simd isn't empty, then an i64 loop
+// over what's left.
+static std::vector< uint8_t > writeModule( const WasmTarget& target, unsigned params, const FunctionWriter* simd,
+                                           const FunctionWriter& scalar )
+{
+  const unsigned w = params + W;
+  const unsigned end = params + END_OF_ROW;
+
+  Bytes body;
+  Bytes locals;
+  unsigned groups = 1;
+  locals.unsignedLeb( I32_LOCALS ); locals.byte( I32 );
+  if ( scalar.locals() ) { locals.unsignedLeb( scalar.locals() ); locals.byte( I64 ); ++groups; }
+  if ( simd && simd->locals() ) { locals.unsignedLeb( simd->locals() ); locals.byte( V128 ); ++groups; }
+  body.unsignedLeb( groups );
+  body.insert( body.end(), locals.begin(), locals.end() );
+
+  // end = words * 8
+  body.byte( LOCAL_GET ); body.unsignedLeb( WORDS );
+  body.byte( I32_CONST ); body.signedLeb( 3 );
+  body.byte( I32_SHL );
+  body.byte( LOCAL_SET ); body.unsignedLeb( end );
+  if ( simd ) writeLoop( body, w, end, 16, simd->code );
+  writeLoop( body, w, end, 8, scalar.code );
+  body.byte( END );
+
+  Bytes module;
+  const uint8_t header[] = { 0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00 };
+  module.insert( module.end(), header, header + sizeof( header ));
+  auto section = [&]( uint8_t id, const Bytes& contents ) {
+    module.byte( id );
+    module.sized( contents );
+  };
+
+  Bytes types;
+  types.unsignedLeb( 1 );
+  types.byte( 0x60 );
+  types.unsignedLeb( params );
+  for ( unsigned i = 0; i < params; ++i ) types.byte( I32 );
+  types.unsignedLeb( 0 );
+  section( 1, types );
+
+  // The whole wasm32 address space as the most for a shared memory, which
+  // has to give one.
+  Bytes imports;
+  imports.unsignedLeb( 1 );
+  imports.name( "env" );
+  imports.name( "memory" );
+  imports.byte( 0x02 );
+  if ( target.sharedMemory ) {
+    imports.byte( 0x03 );
+    imports.unsignedLeb( 1 );
+    imports.unsignedLeb( 65536 );
+  }
+  else {
+    imports.byte( 0x00 );
+    imports.unsignedLeb( 1 );
+  }
+  section( 2, imports );
+
+  Bytes functions;
+  functions.unsignedLeb( 1 );
+  functions.unsignedLeb( 0 );
+  section( 3, functions );
+
+  Bytes exports;
+  exports.unsignedLeb( 1 );
+  exports.name( "row" );
+  exports.byte( 0x00 );
+  exports.unsignedLeb( 0 );
+  section( 7, exports );
+
+  Bytes code;
+  code.unsignedLeb( 1 );
+  code.sized( body );
+  section( 10, code );
+  return module;
+}
+
+std::vector< uint8_t > compileRuleKernel( const LifeRule& rule, const WasmTarget& target )
+{
+  constexpr unsigned PARAMS = 5;
+  const RuleCircuit circuit = RuleCircuit::synthesize( rule );
+  FunctionWriter scalar( PARAMS + I32_LOCALS, I64 );
+  writeRuleStep( scalar, PARAMS + W, circuit );
+  if ( !target.simd ) return writeModule( target, PARAMS, nullptr, scalar );
+
+  FunctionWriter simd( PARAMS + I32_LOCALS + scalar.locals(), V128 );
+  writeRuleStep( simd, PARAMS + W, circuit );
+  return writeModule( target, PARAMS, &simd, scalar );
+}
+
+std::vector< uint8_t > compileLookupKernel( const WasmTarget& target )
+{
+  constexpr unsigned PARAMS = 6;
+  FunctionWriter scalar( PARAMS + I32_LOCALS, I64 );
+  writeLookupStep( scalar, PARAMS + W );
+  return writeModule( target, PARAMS, nullptr, scalar );
+}
+
+#if defined( __EMSCRIPTEN__ ) && !defined( __wasm64__ )
+
+// Instantiate the module against this instance's memory and put its row
+// function in the table.  Returns the table index, which is the function
+// pointer.
+EM_JS( int, instantiateRowKernel, ( const uint8_t* bytes, int length ), {
+  var module = new WebAssembly.Module( HEAPU8.slice( bytes, bytes + length ));
+  var instance = new WebAssembly.Instance( module, { env: { memory: wasmMemory } } );
+  return addFunction( instance.exports.row, 'viiiii' );
+});
+
+RowKernel linkRuleKernel( const LifeRule& rule )
+{
+  static std::map< std::string, RowKernel > linked;
+  const std::string name = rule.toString();
+  auto found = linked.find( name );
+  if ( found != linked.end() ) return found->second;
+
+  WasmTarget target;
+#ifndef __wasm_simd128__
+  target.simd = false;
+#endif
+#ifdef __EMSCRIPTEN_PTHREADS__
+  target.sharedMemory = true;
+#endif
+  const std::vector< uint8_t > module = compileRuleKernel( rule, target );
+  const int index = instantiateRowKernel( module.data(), int( module.size() ));
+  const RowKernel kernel = reinterpret_cast< RowKernel >( intptr_t( index ));
+  linked[ name ] = kernel;
+  return kernel;
+}
+
+#else
+
+RowKernel linkRuleKernel( const LifeRule& )
+{
+  return nullptr;
+}
+
+#endif
@@ -0,0 +1,43 @@
+///
+/// Writes WebAssembly kernels specialized to one life-like rule.
+/// (C) Andrew Brownbill 2019
+///
+
+#ifndef RULE_COMPILER_H
+#define RULE_COMPILER_H
+
+#include <cstdint>
+#include <vector>
+
+#include "life_rule.h"
+#include "rule_kernel.h"
+
+// What the kernel module is for.  Both kinds import the memory the board
+// lives in as env.memory, and their pointers are wasm32 ones.
+class WasmTarget
+{
+  public:
+
+  bool simd = true;             // Two words at a time with v128
+  bool sharedMemory = false;    // The memory of a -pthread build
+};
+
+// A module exporting "row", a RowKernel for rule: the neighbor counts
+// bit sliced, then the rule's circuit (see RuleCircuit) as straight
+// line and / or / xor, no tables and no branches.  Runs under any wasm
+// engine, e.g. node, given a memory to import.
+std::vector< uint8_t > compileRuleKernel( const LifeRule& rule, const WasmTarget& target );
+
+// The generic lookup path as a module to compare with: "row" takes a
+// sixth argument, a 32 byte table indexed by alive * 16 + neighbors, and
+// looks every cell up in it.  Always scalar.
+std::vector< uint8_t > compileLookupKernel( const WasmTarget& target );
+
+// compileRuleKernel for this build, instantiated against the page's
+// memory and added to the function table, so it's called like any other
+// function pointer.  Kernels are kept per rule, the table only grows.
+// nullptr where there's no runtime code generation: native builds and
+// wasm64.
+RowKernel linkRuleKernel( const LifeRule& rule );
+
+#endif
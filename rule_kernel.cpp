@@ -0,0 +1,158 @@
+///
+/// Stepping the packed board under any life-like rule.
+/// (C) Andrew Brownbill 2019
+///
+
+#include <stdexcept>
+
+#include "bit_ops.h"
+#include "rule_kernel.h"
+
+// A word's live neighbor counts, bit sliced: bit i of each plane is one
+// bit of the count for cell i.
+class Counts
+{
+  public:
+  uint64_t ones;
+  uint64_t twos;
+  uint64_t fours;
+  uint64_t eights;
+};
+
+// Word w of padded rows, see RowKernel.
+static inline uint64_t westOf( const uint64_t* row, unsigned w ) { return westOf( row[ w ], row[ w + 1 ] ); }
+static inline uint64_t eastOf( const uint64_t* row, unsigned w ) { return eastOf( row[ w + 1 ], row[ w + 2 ] ); }
+
+static inline Counts count( const uint64_t* up, const uint64_t* mid, const uint64_t* down, unsigned w )
+{
+  uint64_t s1, c1, s2, c2, c4;
+  fullAdd( westOf( up, w ), up[ w + 1 ], eastOf( up, w ), s1, c1 );
+  fullAdd( westOf( mid, w ), eastOf( mid, w ), westOf( down, w ), s2, c2 );
+  const uint64_t s3 = down[ w + 1 ] ^ eastOf( down, w );
+  const uint64_t c3 = down[ w + 1 ] & eastOf( down, w );
+
+  Counts counts;
+  fullAdd( s1, s2, s3, counts.ones, c4 );
+  uint64_t t, d1;
+  fullAdd( c1, c2, c3, t, d1 );
+  counts.twos = t ^ c4;
+  const uint64_t d2 = t & c4;
+  counts.fours = d1 ^ d2;
+  counts.eights = d1 & d2;
+  return counts;
+}
+
+// The cells whose count is n.
+static inline uint64_t countIs( const Counts& counts, unsigned n )
+{
+  return ( n & 1 ? counts.ones : ~counts.ones ) & ( n & 2 ? counts.twos : ~counts.twos ) &
+         ( n & 4 ? counts.fours : ~counts.fours ) & ( n & 8 ? counts.eights : ~counts.eights );
+}
+
+void advanceRuleLookup( const PackedBoard& src, PackedBoard& dst, const LifeRule& rule )
+{
+  if ( dst.width() != src.width() || dst.height() != src.height() ) {
+    throw std::invalid_argument( "advanceRuleLookup board size mismatch" );
+  }
+  // Indexed by alive * 16 + neighbors.
+  uint8_t table[ 32 ] = {};
+  for ( unsigned n = 0; n <= LifeRule::MAX_NEIGHBORS; ++n )
+  {
+    table[ n ] = rule.next( false, n );
+    table[ 16 + n ] = rule.next( true, n );
+  }
+  advanceRows( src, dst, [&]( const uint64_t* up, const uint64_t* mid, const uint64_t* down,
+                              uint64_t* out, unsigned words ) {
+    for ( unsigned w = 0; w < words; ++w )
+    {
+      const Counts counts = count( up, mid, down, w );
+      const uint64_t alive = mid[ w + 1 ];
+      uint64_t next = 0;
+      for ( unsigned i = 0; i < CELLS_PER_WORD; ++i )
+      {
+        const unsigned index = unsigned((( alive >> i ) & 1 ) << 4 | (( counts.eights >> i ) & 1 ) << 3 |
+                                        (( counts.fours >> i ) & 1 ) << 2 | (( counts.twos >> i ) & 1 ) << 1 |
+                                        (( counts.ones >> i ) & 1 ));
+        next |= uint64_t( table[ index ] ) << i;
+      }
+      out[ w ] = next;
+    }
+  });
+}
+
+void advanceRule( const PackedBoard& src, PackedBoard& dst, const LifeRule& rule )
+{
+  if ( dst.width() != src.width() || dst.height() != src.height() ) {
+    throw std::invalid_argument( "advanceRule board size mismatch" );
+  }
+  advanceRows( src, dst, [&]( const uint64_t* up, const uint64_t* mid, const uint64_t* down,
+                              uint64_t* out, unsigned words ) {
+    for ( unsigned w = 0; w < words; ++w )
+    {
+      const Counts counts = count( up, mid, down, w );
+      const uint64_t alive = mid[ w + 1 ];
+      uint64_t next = 0;
+      for ( unsigned n = 0; n <= LifeRule::MAX_NEIGHBORS; ++n )
+      {
+        const uint64_t cells = (( rule.birth >> n ) & 1 ? ~alive : 0 ) | (( rule.survive >> n ) & 1 ? alive : 0 );
+        if ( cells ) next |= cells & countIs( counts, n );
+      }
+      out[ w ] = next;
+    }
+  });
+}
+
+void advanceCircuit( const PackedBoard& src, PackedBoard& dst, const RuleCircuit& circuit )
+{
+  if ( dst.width() != src.width() || dst.height() != src.height() ) {
+    throw std::invalid_argument( "advanceCircuit board size mismatch" );
+  }
+  using Op = RuleCircuit::Op;
+  const unsigned words = src.wordsPerRow();
+  // A row of words for every node.  Alive is read from the padded row.
+  std::vector< uint64_t > values( size_t( circuit.nodes() ) * words );
+  std::vector< const uint64_t* > node( circuit.nodes() );
+  for ( unsigned i = 0; i < circuit.nodes(); ++i ) node[i] = &values[ size_t( i ) * words ];
+  advanceRows( src, dst, [&]( const uint64_t* up, const uint64_t* mid, const uint64_t* down,
+                              uint64_t* out, unsigned ) {
+    node[ RuleCircuit::ALIVE ] = mid + 1;
+    uint64_t* ones = &values[ size_t( RuleCircuit::ONES ) * words ];
+    uint64_t* twos = &values[ size_t( RuleCircuit::TWOS ) * words ];
+    uint64_t* fours = &values[ size_t( RuleCircuit::FOURS ) * words ];
+    uint64_t* eights = &values[ size_t( RuleCircuit::EIGHTS ) * words ];
+    for ( unsigned w = 0; w < words; ++w )
+    {
+      const Counts counts = count( up, mid, down, w );
+      ones[w] = counts.ones;
+      twos[w] = counts.twos;
+      fours[w] = counts.fours;
+      eights[w] = counts.eights;
+    }
+    unsigned index = RuleCircuit::INPUTS;
+    for ( const RuleCircuit::Gate& gate : circuit.gates() )
+    {
+      uint64_t* r = &values[ size_t( index++ ) * words ];
+      const uint64_t* a = node[ gate.a ];
+      const uint64_t* b = node[ gate.b ];
+      switch ( gate.op )
+      {
+        case Op::Zero: std::fill( r, r + words, 0 ); break;
+        case Op::One: std::fill( r, r + words, ~uint64_t( 0 )); break;
+        case Op::And: for ( unsigned w = 0; w < words; ++w ) r[w] = a[w] & b[w]; break;
+        case Op::Or: for ( unsigned w = 0; w < words; ++w ) r[w] = a[w] | b[w]; break;
+        case Op::Xor: for ( unsigned w = 0; w < words; ++w ) r[w] = a[w] ^ b[w]; break;
+        case Op::AndNot: for ( unsigned w = 0; w < words; ++w ) r[w] = a[w] & ~b[w]; break;
+        case Op::Not: for ( unsigned w = 0; w < words; ++w ) r[w] = ~a[w]; break;
+      }
+    }
+    std::copy( node[ circuit.output() ], node[ circuit.output() ] + words, out );
+  });
+}
+
+void advanceRule( const PackedBoard& src, PackedBoard& dst, RowKernel kernel )
+{
+  if ( dst.width() != src.width() || dst.height() != src.height() ) {
+    throw std::invalid_argument( "advanceRule board size mismatch" );
+  }
+  advanceRows( src, dst, kernel );
+}
@@ -0,0 +1,67 @@
+///
+/// Stepping the packed board under any life-like rule.
+/// (C) Andrew Brownbill 2019
+///
+
+#ifndef RULE_KERNEL_H
+#define RULE_KERNEL_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "life_rule.h"
+#include "packed_board.h"
+#include "rule_circuit.h"
+
+// One row of a rule step, out[0..words) from the rows around it.  The
+// rows come padded: a copy of the row's last word first and of its first
+// word last, so word w is at [w + 1] and its neighbors at [w] and [w + 2]
+// without wrapping.  The shape of the kernels compileRuleKernel writes.
+using RowKernel = void (*)( const uint64_t* up, const uint64_t* mid, const uint64_t* down,
+                            uint64_t* out, unsigned words );
+
+// Move src forward one generation into dst a row at a time, rowStep
+// called like a RowKernel on padded copies of the rows, three of them
+// kept in a ring so each row is padded once.
+template < typename RowStep >
+void advanceRows( const PackedBoard& src, PackedBoard& dst, RowStep rowStep )
+{
+  const unsigned words = src.wordsPerRow();
+  const unsigned height = src.height();
+  const size_t padded = size_t( words ) + 2;
+  std::vector< uint64_t > scratch( 3 * padded );
+  uint64_t* ring[ 3 ] = { &scratch[ 0 ], &scratch[ padded ], &scratch[ 2 * padded ] };
+  auto pad = [&]( unsigned y, uint64_t* out ) {
+    const uint64_t* in = src.row( y );
+    out[ 0 ] = in[ words - 1 ];
+    std::copy( in, in + words, out + 1 );
+    out[ words + 1 ] = in[ 0 ];
+  };
+  pad( height - 1, ring[ 0 ] );
+  pad( 0, ring[ 1 ] );
+  for ( unsigned y = 0; y < height; ++y )
+  {
+    pad( y + 1 < height ? y + 1 : 0, ring[ ( y + 2 ) % 3 ] );                 // wrap around y
+    rowStep( ring[ y % 3 ], ring[ ( y + 1 ) % 3 ], ring[ ( y + 2 ) % 3 ], dst.row( y ), words );
+  }
+}
+
+// The generic path: neighbor counts bit sliced, then every cell looked up
+// in a table of rule.next().
+void advanceRuleLookup( const PackedBoard& src, PackedBoard& dst, const LifeRule& rule );
+
+// Bit sliced all the way, the rule applied a neighbor count at a time
+// across the whole word.  Still loops over the rule's counts; a compiled
+// kernel has them unrolled.
+void advanceRule( const PackedBoard& src, PackedBoard& dst, const LifeRule& rule );
+
+// Running the rule's circuit, see RuleCircuit, a gate at a time across a
+// whole row of words.  Near the hand written kernels' speed for any rule
+// without compiling anything.
+void advanceCircuit( const PackedBoard& src, PackedBoard& dst, const RuleCircuit& circuit );
+
+// With a kernel from linkRuleKernel.
+void advanceRule( const PackedBoard& src, PackedBoard& dst, RowKernel kernel );
+
+#endif
@@ -0,0 +1,22 @@
+#!/usr/bin/env python3
+#
+# Like python3 -m http.server, plus the headers that make the page cross
+# origin isolated.  The threaded build needs that for SharedArrayBuffer.
+#
+# serve.py [port]
+#
+
+import http.server
+import sys
+
+class Handler( http.server.SimpleHTTPRequestHandler ):
+    def end_headers( self ):
+        self.send_header( 'Cross-Origin-Opener-Policy', 'same-origin' )
+        self.send_header( 'Cross-Origin-Embedder-Policy', 'require-corp' )
+        super().end_headers()
+
+Handler.extensions_map[ '.wasm' ] = 'application/wasm'
+
+if __name__ == '__main__':
+    port = int( sys.argv[1] ) if len( sys.argv ) > 1 else 8000
+    http.server.test( HandlerClass=Handler, port=port )
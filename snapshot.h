@@ -0,0 +1,127 @@
+///
+/// Start board for the web build.  Generated by
+/// gol_snapshot --seed 1 --generations 0, don't edit.
+///
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstdint>
+
+constexpr unsigned SNAPSHOT_WIDTH = 512;
+constexpr unsigned SNAPSHOT_HEIGHT = 384;
+
+// Word index into the packed board, then the word.
+const uint64_t snapshotWords[] = {
+  4u, 0x4101ull,
+  12u, 0x1804585ull,
+  20u, 0x1804118ull,
+  27u, 0x60000000000000ull,
+  28u, 0x2218ull,
+  35u, 0x60000000000000ull,
+  36u, 0x1818ull,
+  44u, 0x5ull,
+  45u, 0x10000000000ull,
+  52u, 0x1ull,
+  53u, 0x14000000000ull,
+  61u, 0xc003030000000ull,
+  69u, 0xc003088000000ull,
+  77u, 0x3104030000ull,
+  85u, 0x14344030000ull,
+  93u, 0x10104000000ull,
+  101u, 0x88000000ull,
+  109u, 0x30000000ull,
+  174u, 0x3ull,
+  181u, 0x4000000000000000ull,
+  182u, 0x4ull,
+  189u, 0x2020000000000000ull,
+  190u, 0x8ull,
+  197u, 0xb0a0000000000000ull,
+  198u, 0x3008ull,
+  205u, 0x2300000000000000ull,
+  206u, 0x3008ull,
+  213u, 0x43000c0000000000ull,
+  214u, 0x4ull,
+  221u, 0x3000c0000000000ull,
+  222u, 0x3ull,
+  229u, 0xa0000000000000ull,
+  237u, 0x20000000000000ull,
+  507u, 0x180000000ull,
+  515u, 0x220000000ull,
+  523u, 0x410100000ull,
+  531u, 0x180458500000ull,
+  539u, 0x180411800000ull,
+  547u, 0x221800600ull,
+  555u, 0x181800600ull,
+  563u, 0x500000ull,
+  571u, 0x100000ull,
+  798u, 0x6000000ull,
+  806u, 0x11000000ull,
+  814u, 0x2020800000ull,
+  822u, 0x2868806000ull,
+  830u, 0x620806000ull,
+  838u, 0x1800611000000ull,
+  846u, 0x1800606000000ull,
+  854u, 0x2800000000ull,
+  862u, 0x2000000000ull,
+  957u, 0x1800000000000000ull,
+  965u, 0x2200000000000000ull,
+  973u, 0x4101000000000000ull,
+  981u, 0x4585000000000000ull,
+  982u, 0x180ull,
+  989u, 0x4118000000000000ull,
+  990u, 0x180ull,
+  997u, 0x2218006000000000ull,
+  1005u, 0x1818006000000000ull,
+  1013u, 0x5000000000000ull,
+  1021u, 0x1000000000000ull,
+  1111u, 0x600000000ull,
+  1119u, 0x1100000000ull,
+  1127u, 0x202080000000ull,
+  1135u, 0x286880600000ull,
+  1143u, 0x62080600000ull,
+  1151u, 0x180061100000000ull,
+  1159u, 0x180060600000000ull,
+  1167u, 0x280000000000ull,
+  1175u, 0x200000000000ull,
+  1187u, 0x2000000000ull,
+  1195u, 0xa000000000ull,
+  1203u, 0x303000c000000ull,
+  1211u, 0x443000c000000ull,
+  1219u, 0x3008230000000000ull,
+  1227u, 0x3008b0a000000000ull,
+  1235u, 0x8202000000000ull,
+  1243u, 0x4400000000000ull,
+  1251u, 0x3000000000000ull,
+  2016u, 0x8ull,
+  2024u, 0xaull,
+  2032u, 0x6001ull,
+  2039u, 0x8180000000000000ull,
+  2040u, 0x6001ull,
+  2047u, 0x8440000000000000ull,
+  2048u, 0x1ull,
+  2055u, 0x8820180000000000ull,
+  2056u, 0xaull,
+  2063u, 0x1a20180000000000ull,
+  2064u, 0x8ull,
+  2071u, 0x820000000000000ull,
+  2079u, 0x440000000000000ull,
+  2087u, 0x180000000000000ull,
+  2113u, 0x18000000000000ull,
+  2121u, 0x22000000000000ull,
+  2129u, 0x41010000000000ull,
+  2137u, 0x8045850000000000ull,
+  2138u, 0x1ull,
+  2145u, 0x8041180000000000ull,
+  2146u, 0x1ull,
+  2153u, 0x22180060000000ull,
+  2161u, 0x18180060000000ull,
+  2169u, 0x50000000000ull,
+  2177u, 0x10000000000ull,
+  3060u, 0x1800ull,
+  3068u, 0x2200ull,
+};
+
+constexpr unsigned SNAPSHOT_WORDS = 107;
+
+#endif
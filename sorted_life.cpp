@@ -0,0 +1,145 @@
+///
+/// Sparse game of life on sorted lists of live cells.
+/// (C) Andrew Brownbill 2019
+///
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "sorted_life.h"
+
+// Radix sort digit.
+constexpr unsigned DIGIT_BITS = 8;
+constexpr unsigned DIGITS = 1u << DIGIT_BITS;
+
+static unsigned bitsFor( unsigned size )
+{
+  unsigned bits = 0;
+  while (( 1ull << bits ) < size ) ++bits;
+  return bits;
+}
+
+SortedLife::SortedLife( unsigned width, unsigned height ) :
+  xSize( width ), ySize( height ), xBits( bitsFor( width )),
+  keyBits( bitsFor( width ) + bitsFor( height )), xMask(( 1u << xBits ) - 1 )
+{
+  if ( width == 0 || height == 0 || keyBits > 32 ) {
+    throw std::invalid_argument( "SortedLife board must be non empty and have at most 2^32 cells" );
+  }
+}
+
+void SortedLife::load( const PackedBoard& board )
+{
+  if ( board.width() != xSize || board.height() != ySize ) {
+    throw std::invalid_argument( "SortedLife::load board size mismatch" );
+  }
+  live.clear();
+  for ( unsigned y = 0; y < ySize; ++y )
+  {
+    const uint64_t* row = board.row( y );
+    for ( unsigned w = 0; w < board.wordsPerRow(); ++w ) {
+      for ( uint64_t bits = row[w]; bits; bits &= bits - 1 ) {
+        live.push_back( key( w * CELLS_PER_WORD + __builtin_ctzll( bits ), y ));
+      }
+    }
+  }
+
+  gather();
+  touched.assign( neighbors.begin(), std::unique( neighbors.begin(), neighbors.end() ));
+}
+
+void SortedLife::store( PackedBoard& board ) const
+{
+  board.clear();
+  for ( uint32_t k : live ) board.set( xOf( k ), yOf( k ), true );
+}
+
+// The keys of all 8 neighbors of every live cell, sorted.
+void SortedLife::gather()
+{
+  neighbors.resize( live.size() * 8 );
+  uint32_t* out = neighbors.data();
+  for ( uint32_t k : live )
+  {
+    const unsigned x = xOf( k );
+    const unsigned y = yOf( k );
+    const uint32_t west = x ? x - 1 : xSize - 1;     // wrap around x
+    const uint32_t east = ( x + 1 < xSize ) ? x + 1 : 0;
+    const uint32_t up = ( y ? y - 1 : ySize - 1 ) << xBits;
+    const uint32_t mid = y << xBits;
+    const uint32_t down = (( y + 1 < ySize ) ? y + 1 : 0 ) << xBits;
+    out[0] = up | west;
+    out[1] = up | x;
+    out[2] = up | east;
+    out[3] = mid | west;
+    out[4] = mid | east;
+    out[5] = down | west;
+    out[6] = down | x;
+    out[7] = down | east;
+    out += 8;
+  }
+  sortNeighbors();
+}
+
+// Least significant digit first radix sort.
+void SortedLife::sortNeighbors()
+{
+  scratch.resize( neighbors.size() );
+  for ( unsigned shift = 0; shift < keyBits; shift += DIGIT_BITS )
+  {
+    size_t start[ DIGITS ] = {};
+    for ( uint32_t k : neighbors ) ++start[ ( k >> shift ) & ( DIGITS - 1 ) ];
+    size_t sum = 0;
+    for ( size_t& s : start )
+    {
+      const size_t count = s;
+      s = sum;
+      sum += count;
+    }
+    for ( uint32_t k : neighbors ) scratch[ start[ ( k >> shift ) & ( DIGITS - 1 ) ]++ ] = k;
+    neighbors.swap( scratch );
+  }
+}
+
+void SortedLife::advance()
+{
+  gather();
+
+  // Runs of equal keys are neighbor counts.  Walk the live list alongside
+  // to see which counted cells are alive now.
+  std::vector< uint32_t >& next = scratch;
+  next.clear();
+  touched.clear();
+  size_t j = 0;
+  const size_t total = neighbors.size();
+  for ( size_t i = 0; i < total; )
+  {
+    const uint32_t k = neighbors[ i ];
+    size_t run = i + 1;
+    while ( run < total && neighbors[ run ] == k ) ++run;
+    const size_t count = run - i;
+    i = run;
+
+    touched.push_back( k );
+    while ( j < live.size() && live[ j ] < k ) ++j;
+    const bool alive = j < live.size() && live[ j ] == k;
+    if ( count == 3 || ( count == 2 && alive )) next.push_back( k );
+  }
+  live.swap( next );
+}
+
+size_t SortedLife::memoryUsed() const
+{
+  return ( live.capacity() + touched.capacity() + neighbors.capacity() + scratch.capacity() ) * sizeof( uint32_t );
+}
+
+void SortedLife::storeNeighborhood( LifeBuffer& buffer ) const
+{
+  buffer.clear();
+  size_t j = 0;
+  for ( uint32_t k : touched )
+  {
+    while ( j < live.size() && live[ j ] < k ) ++j;
+    buffer[ LifeCoord( xOf( k ), yOf( k )) ].value = ( j < live.size() && live[ j ] == k ) ? 1 : 0;
+  }
+}
@@ -0,0 +1,64 @@
+///
+/// Sparse game of life on sorted lists of live cells.
+/// (C) Andrew Brownbill 2019
+///
+
+#ifndef SORTED_LIFE_H
+#define SORTED_LIFE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "life.h"
+#include "packed_board.h"
+
+// Keeps the live cells of a torus as a sorted vector of (y, x) keys.  A
+// generation writes the keys of all 8 neighbors of every live cell into
+// one array, radix sorts it, and counts runs of equal keys: a run of 3,
+// or of 2 on a live cell, is alive next time.  Everything is a linear
+// pass or a sort pass, no probing.  Costs 4 bytes per live cell plus 32
+// bytes per live cell of scratch while stepping.  Keys are 32 bits, so
+// the board has at most 2^32 cells.
+class SortedLife
+{
+  public:
+
+  SortedLife( unsigned width, unsigned height );
+
+  unsigned width() const { return xSize; }
+  unsigned height() const { return ySize; }
+
+  void load( const PackedBoard& board );
+  void store( PackedBoard& board ) const;
+
+  void advance();
+
+  size_t population() const { return live.size(); }
+  size_t memoryUsed() const;
+
+  // Write the board in advanceSim's form: every cell with a live
+  // neighbor last generation, value 1 if it's alive now.  After load()
+  // the neighborhood is the loaded board's.
+  void storeNeighborhood( LifeBuffer& buffer ) const;
+
+  private:
+
+  uint32_t key( unsigned x, unsigned y ) const { return ( uint32_t( y ) << xBits ) | x; }
+  unsigned xOf( uint32_t k ) const { return k & xMask; }
+  unsigned yOf( uint32_t k ) const { return k >> xBits; }
+
+  void gather();
+  void sortNeighbors();
+
+  unsigned xSize;
+  unsigned ySize;
+  unsigned xBits;
+  unsigned keyBits;
+  uint32_t xMask;
+  std::vector< uint32_t > live;         // Sorted
+  std::vector< uint32_t > touched;      // Sorted, had a live neighbor last generation
+  std::vector< uint32_t > neighbors;    // 8 per live cell
+  std::vector< uint32_t > scratch;      // For the radix sort
+};
+
+#endif
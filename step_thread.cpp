@@ -0,0 +1,68 @@
+///
+/// One stage of work on its own thread, overlapped with the caller's.
+/// (C) Andrew Brownbill 2019
+///
+
+#include "step_thread.h"
+
+StepThread::StepThread( std::function< void() > step ) :
+  stepFunction( std::move( step )), requested( false ), done( true ), stopping( false ), frameCount( 0 )
+{
+  worker = std::thread( &StepThread::workerLoop, this );
+}
+
+StepThread::~StepThread()
+{
+  {
+    std::lock_guard< std::mutex > lock( mutex );
+    stopping = true;
+  }
+  changed.notify_all();
+  worker.join();
+}
+
+void StepThread::start()
+{
+  {
+    std::lock_guard< std::mutex > lock( mutex );
+    requested = true;
+    done = false;
+  }
+  changed.notify_all();
+}
+
+void StepThread::finish()
+{
+  const Clock::time_point arrived = Clock::now();
+  std::unique_lock< std::mutex > lock( mutex );
+  if ( done )
+  {
+    const double idle = std::chrono::duration< double >( arrived - doneAt ).count();
+    ++stepWaits.count;
+    stepWaits.seconds += idle > 0 ? idle : 0;
+  }
+  else
+  {
+    changed.wait( lock, [this]{ return done; } );
+    ++callerWaits.count;
+    callerWaits.seconds += std::chrono::duration< double >( Clock::now() - arrived ).count();
+  }
+  ++frameCount;
+}
+
+void StepThread::workerLoop()
+{
+  std::unique_lock< std::mutex > lock( mutex );
+  for ( ;; )
+  {
+    changed.wait( lock, [this]{ return requested || stopping; } );
+    if ( stopping ) return;
+    requested = false;
+    lock.unlock();
+    stepFunction();
+    lock.lock();
+    done = true;
+    doneAt = Clock::now();
+    changed.notify_all();
+  }
+}
@@ -0,0 +1,68 @@
+///
+/// One stage of work on its own thread, overlapped with the caller's.
+/// (C) Andrew Brownbill 2019
+///
+
+#ifndef STEP_THREAD_H
+#define STEP_THREAD_H
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Runs a step on a thread of its own while the caller does the next
+// stage, a frame at a time: start() hands the step over, finish() waits
+// for it.  Whichever side got to the end of the frame first waited on
+// the other; that's kept per side as stalls.
+class StepThread
+{
+  public:
+
+  // Time one stage spent waiting on the other.
+  struct Stalls
+  {
+    unsigned count = 0;
+    double seconds = 0;
+  };
+
+  explicit StepThread( std::function< void() > step );
+  StepThread( const StepThread& ) = delete;
+  StepThread& operator=( const StepThread& ) = delete;
+  ~StepThread();
+
+  // Run the step once.  Not again until finish().
+  void start();
+
+  // Wait for the step start() began.
+  void finish();
+
+  unsigned frames() const { return frameCount; }
+
+  // The step was done before the caller, and sat idle.
+  const Stalls& stepStalls() const { return stepWaits; }
+
+  // The caller was done before the step, and blocked in finish().
+  const Stalls& callerStalls() const { return callerWaits; }
+
+  private:
+
+  using Clock = std::chrono::steady_clock;
+
+  void workerLoop();
+
+  std::function< void() > stepFunction;
+  std::mutex mutex;
+  std::condition_variable changed;
+  bool requested;
+  bool done;
+  bool stopping;
+  Clock::time_point doneAt;
+  unsigned frameCount;
+  Stalls stepWaits;
+  Stalls callerWaits;
+  std::thread worker;
+};
+
+#endif
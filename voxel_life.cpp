@@ -0,0 +1,407 @@
+///
+/// Game of life in three dimensions, bit-packed voxels.
+/// (C) Andrew Brownbill 2019
+///
+
+#include <algorithm>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+#include "bit_ops.h"
+#include "voxel_life.h"
+
+constexpr unsigned VoxelRule::MAX_NEIGHBORS;
+
+constexpr uint32_t ALL_COUNTS = ( 1u << ( VoxelRule::MAX_NEIGHBORS + 1 )) - 1;
+
+// Bit planes of a layer sum, 0 to 9.
+constexpr unsigned LAYER_BITS = 4;
+
+// Bits lo to hi.
+static uint32_t range( unsigned lo, unsigned hi )
+{
+  if ( lo > hi || hi > VoxelRule::MAX_NEIGHBORS ) throw std::invalid_argument( "bad voxel rule range" );
+  return ( ALL_COUNTS >> ( VoxelRule::MAX_NEIGHBORS - hi )) & ~(( 1u << lo ) - 1 );
+}
+
+// A mask's counts, "4,5".
+static std::string countList( uint32_t mask )
+{
+  std::string text;
+  for ( unsigned n = 0; n <= VoxelRule::MAX_NEIGHBORS; ++n ) {
+    if (( mask >> n ) & 1 ) text += ( text.empty() ? "" : "," ) + std::to_string( n );
+  }
+  return text;
+}
+
+// "4,5" back to a list.
+static std::vector< unsigned > parseCountList( const std::string& text )
+{
+  std::vector< unsigned > list;
+  std::istringstream in( text );
+  for ( std::string number; std::getline( in, number, ',' ); )
+  {
+    if ( number.empty() || number.size() > 2 || number.find_first_not_of( "0123456789" ) != std::string::npos ||
+         std::stoul( number ) > VoxelRule::MAX_NEIGHBORS ) {
+      throw std::invalid_argument( "bad voxel rule count '" + number + "'" );
+    }
+    list.push_back( unsigned( std::stoul( number )));
+  }
+  return list;
+}
+
+static uint32_t parseCounts( const std::string& text )
+{
+  uint32_t mask = 0;
+  for ( unsigned n : parseCountList( text )) mask |= 1u << n;
+  return mask;
+}
+
+// Every voxel of layer z summed with the eight around it in the layer:
+// first each row with its x neighbors, 0 to 3 in rows, then three of
+// those, 0 to 9 in out, LAYER_BITS planes a word, word w of row y at
+// ( y * words + w ) * LAYER_BITS.
+static void sumLayer( const VoxelBoard& board, unsigned z, std::vector< uint64_t >& rows, uint64_t* out )
+{
+  const unsigned words = board.wordsPerRow();
+  const unsigned height = board.height();
+  rows.resize( size_t( height ) * words * 2 );
+  for ( unsigned y = 0; y < height; ++y )
+  {
+    const uint64_t* row = board.row( y, z );
+    uint64_t* sums = &rows[ size_t( y ) * words * 2 ];
+    for ( unsigned w = 0; w < words; ++w )
+    {
+      const unsigned p = w ? w - 1 : words - 1;         // wrap around x
+      const unsigned n = ( w + 1 < words ) ? w + 1 : 0;
+      fullAdd( westOf( row[ p ], row[ w ] ), row[ w ], eastOf( row[ w ], row[ n ] ), sums[ 2 * w ], sums[ 2 * w + 1 ] );
+    }
+  }
+  for ( unsigned y = 0; y < height; ++y )
+  {
+    const uint64_t* up = &rows[ size_t( y ? y - 1 : height - 1 ) * words * 2 ];      // wrap around y
+    const uint64_t* mid = &rows[ size_t( y ) * words * 2 ];
+    const uint64_t* down = &rows[ size_t(( y + 1 < height ) ? y + 1 : 0 ) * words * 2 ];
+    uint64_t* sum = out + size_t( y ) * words * LAYER_BITS;
+    for ( unsigned w = 0; w < words; ++w )
+    {
+      uint64_t ones, k, t, f;
+      fullAdd( up[ 2 * w ], mid[ 2 * w ], down[ 2 * w ], ones, k );
+      fullAdd( up[ 2 * w + 1 ], mid[ 2 * w + 1 ], down[ 2 * w + 1 ], t, f );
+      uint64_t* planes = sum + w * LAYER_BITS;
+      planes[ 0 ] = ones;
+      planes[ 1 ] = t ^ k;
+      planes[ 2 ] = f ^ ( t & k );
+      planes[ 3 ] = f & ( t & k );
+    }
+  }
+}
+
+// Three layer sums added, 0 to 27, the voxel and its 26 neighbors.
+class Totals
+{
+  public:
+
+  Totals( const uint64_t* a, const uint64_t* b, const uint64_t* c )
+  {
+    uint64_t c2, s1, c4, s2, c8, e4, g8, s3, c16, g16;
+    fullAdd( a[ 0 ], b[ 0 ], c[ 0 ], bits[ 0 ], c2 );
+    fullAdd( a[ 1 ], b[ 1 ], c[ 1 ], s1, c4 );
+    bits[ 1 ] = s1 ^ c2;
+    e4 = s1 & c2;
+    fullAdd( a[ 2 ], b[ 2 ], c[ 2 ], s2, c8 );
+    fullAdd( s2, c4, e4, bits[ 2 ], g8 );
+    fullAdd( a[ 3 ], b[ 3 ], c[ 3 ], s3, c16 );
+    fullAdd( s3, c8, g8, bits[ 3 ], g16 );
+    bits[ 4 ] = c16 | g16;      // Never both, 27 < 32
+  }
+
+  // The voxels whose total is n.
+  uint64_t is( unsigned n ) const
+  {
+    uint64_t cells = ~uint64_t( 0 );
+    for ( unsigned i = 0; i < 5; ++i ) cells &= ( n >> i ) & 1 ? bits[ i ] : ~bits[ i ];
+    return cells;
+  }
+
+  uint64_t bits[ 5 ];
+};
+
+VoxelRule::VoxelRule( uint32_t birthMask, uint32_t surviveMask ) :
+  birth( birthMask ), survive( surviveMask )
+{
+  if (( birth | survive ) & ~ALL_COUNTS ) throw std::invalid_argument( "voxel rules count at most 26 neighbors" );
+}
+
+VoxelRule VoxelRule::parse( const std::string& text )
+{
+  if ( !text.empty() && ( text[ 0 ] == 'B' || text[ 0 ] == 'b' ))
+  {
+    const size_t slash = text.find( '/' );
+    if ( slash == std::string::npos || slash + 1 >= text.size() || ( text[ slash + 1 ] != 'S' && text[ slash + 1 ] != 's' )) {
+      throw std::invalid_argument( "bad voxel rule '" + text + "'" );
+    }
+    return VoxelRule( parseCounts( text.substr( 1, slash - 1 )), parseCounts( text.substr( slash + 2 )));
+  }
+
+  std::vector< unsigned > bounds;
+  if ( text.find( ',' ) == std::string::npos )
+  {
+    for ( char c : text )
+    {
+      if ( c < '0' || c > '9' ) throw std::invalid_argument( "bad voxel rule '" + text + "'" );
+      bounds.push_back( unsigned( c - '0' ));
+    }
+  }
+  else
+  {
+    bounds = parseCountList( text );
+  }
+  if ( bounds.size() != 4 ) throw std::invalid_argument( "voxel rules take four bounds, e.g. 4555" );
+  return VoxelRule( range( bounds[ 2 ], bounds[ 3 ] ), range( bounds[ 0 ], bounds[ 1 ] ));
+}
+
+std::string VoxelRule::toString() const
+{
+  auto isRange = []( uint32_t mask ) { return mask && (( mask >> __builtin_ctz( mask )) & (( mask >> __builtin_ctz( mask )) + 1 )) == 0; };
+  if ( !isRange( birth ) || !isRange( survive )) return "B" + countList( birth ) + "/S" + countList( survive );
+
+  const unsigned bounds[ 4 ] = { unsigned( __builtin_ctz( survive )), 31u - __builtin_clz( survive ),
+                                 unsigned( __builtin_ctz( birth )), 31u - __builtin_clz( birth ) };
+  const bool digits = bounds[ 1 ] < 10 && bounds[ 3 ] < 10;
+  std::string text;
+  for ( unsigned bound : bounds ) text += ( digits || text.empty() ? "" : "," ) + std::to_string( bound );
+  return text;
+}
+
+VoxelBoard::VoxelBoard( unsigned width, unsigned height, unsigned depth ) :
+  xSize( width ), ySize( height ), zSize( depth ), words( width / CELLS_PER_WORD )
+{
+  if ( width == 0 || width % CELLS_PER_WORD != 0 || height == 0 || depth == 0 ) {
+    throw std::invalid_argument( "VoxelBoard width must be a non zero multiple of 64" );
+  }
+  cells.resize( size_t( words ) * ySize * zSize );
+}
+
+bool VoxelBoard::get( unsigned x, unsigned y, unsigned z ) const
+{
+  return ( row( y, z )[ x / CELLS_PER_WORD ] >> ( x % CELLS_PER_WORD )) & 1;
+}
+
+void VoxelBoard::set( unsigned x, unsigned y, unsigned z, bool alive )
+{
+  uint64_t& word = row( y, z )[ x / CELLS_PER_WORD ];
+  const uint64_t bit = uint64_t( 1 ) << ( x % CELLS_PER_WORD );
+  word = alive ? ( word | bit ) : ( word & ~bit );
+}
+
+void VoxelBoard::clear()
+{
+  std::fill( cells.begin(), cells.end(), 0 );
+}
+
+size_t VoxelBoard::population() const
+{
+  size_t count = 0;
+  for ( uint64_t word : cells ) count += __builtin_popcountll( word );
+  return count;
+}
+
+void VoxelBoard::storeLayer( unsigned z, PackedBoard& layer ) const
+{
+  if ( layer.width() != xSize || layer.height() != ySize ) {
+    throw std::invalid_argument( "VoxelBoard::storeLayer board size mismatch" );
+  }
+  std::copy( row( 0, z ), row( 0, z ) + size_t( words ) * ySize, layer.row( 0 ));
+}
+
+void seedCube( VoxelBoard& board, unsigned side, unsigned percent, unsigned seed )
+{
+  std::mt19937 rng( seed );
+  std::uniform_int_distribution< unsigned > roll( 0, 99 );
+  board.clear();
+  const unsigned x0 = ( board.width() - std::min( side, board.width() )) / 2;
+  const unsigned y0 = ( board.height() - std::min( side, board.height() )) / 2;
+  const unsigned z0 = ( board.depth() - std::min( side, board.depth() )) / 2;
+  for ( unsigned z = z0; z < z0 + side && z < board.depth(); ++z ) {
+    for ( unsigned y = y0; y < y0 + side && y < board.height(); ++y ) {
+      for ( unsigned x = x0; x < x0 + side && x < board.width(); ++x ) {
+        if ( roll( rng ) < percent ) board.set( x, y, z, true );
+      }
+    }
+  }
+}
+
+void advanceVoxels( const VoxelBoard& src, VoxelBoard& dst, const VoxelRule& rule,
+                    unsigned first, unsigned last )
+{
+  if ( dst.width() != src.width() || dst.height() != src.height() || dst.depth() != src.depth() ) {
+    throw std::invalid_argument( "advanceVoxels board size mismatch" );
+  }
+  const unsigned words = src.wordsPerRow();
+  const unsigned height = src.height();
+  const unsigned depth = src.depth();
+  last = std::min( last, depth );
+  if ( first >= last ) return;
+
+  // Totals count the voxel itself, so a live one's neighbors are one less.
+  uint64_t births[ VoxelRule::MAX_NEIGHBORS + 2 ], survivals[ VoxelRule::MAX_NEIGHBORS + 2 ];
+  for ( unsigned n = 0; n <= VoxelRule::MAX_NEIGHBORS + 1; ++n )
+  {
+    births[ n ] = ( rule.birth >> n ) & 1 ? ~uint64_t( 0 ) : 0;
+    survivals[ n ] = n && ( rule.survive >> ( n - 1 )) & 1 ? ~uint64_t( 0 ) : 0;
+  }
+
+  const size_t layer = size_t( height ) * words * LAYER_BITS;
+  std::vector< uint64_t > scratch( 3 * layer ), rows;
+  auto ring = [&]( unsigned z ) { return &scratch[ ( z % 3 ) * layer ]; };
+  const unsigned before = first ? first - 1 : depth - 1;       // wrap around z
+  sumLayer( src, before, rows, ring( first + 2 ));              // ring( first - 1 )
+  sumLayer( src, first, rows, ring( first ));
+  for ( unsigned z = first; z < last; ++z )
+  {
+    sumLayer( src, ( z + 1 < depth ) ? z + 1 : 0, rows, ring( z + 1 ));
+    const uint64_t* below = ring( z + 2 );
+    const uint64_t* mid = ring( z );
+    const uint64_t* above = ring( z + 1 );
+    for ( unsigned y = 0; y < height; ++y )
+    {
+      const uint64_t* alive = src.row( y, z );
+      uint64_t* out = dst.row( y, z );
+      for ( unsigned w = 0; w < words; ++w )
+      {
+        const size_t at = ( size_t( y ) * words + w ) * LAYER_BITS;
+        const Totals totals( below + at, mid + at, above + at );
+        uint64_t next = 0;
+        for ( unsigned n = 0; n <= VoxelRule::MAX_NEIGHBORS + 1; ++n )
+        {
+          const uint64_t wanted = ( births[ n ] & ~alive[ w ] ) | ( survivals[ n ] & alive[ w ] );
+          if ( wanted ) next |= wanted & totals.is( n );
+        }
+        out[ w ] = next;
+      }
+    }
+  }
+}
+
+void countLayer( const VoxelBoard& board, unsigned z, std::vector< uint8_t >& counts )
+{
+  const unsigned words = board.wordsPerRow();
+  const unsigned height = board.height();
+  const unsigned depth = board.depth();
+  const size_t layer = size_t( height ) * words * LAYER_BITS;
+  std::vector< uint64_t > sums( 3 * layer ), rows;
+  sumLayer( board, z ? z - 1 : depth - 1, rows, &sums[ 0 ] );
+  sumLayer( board, z, rows, &sums[ layer ] );
+  sumLayer( board, ( z + 1 < depth ) ? z + 1 : 0, rows, &sums[ 2 * layer ] );
+
+  counts.assign( size_t( board.width() ) * height, 0 );
+  for ( unsigned y = 0; y < height; ++y )
+  {
+    const uint64_t* alive = board.row( y, z );
+    for ( unsigned w = 0; w < words; ++w )
+    {
+      if ( !alive[ w ] ) continue;
+      const size_t at = ( size_t( y ) * words + w ) * LAYER_BITS;
+      const Totals totals( &sums[ at ], &sums[ layer + at ], &sums[ 2 * layer + at ] );
+      for ( uint64_t bits = alive[ w ]; bits; bits &= bits - 1 )
+      {
+        const unsigned bit = __builtin_ctzll( bits );
+        unsigned total = 0;
+        for ( unsigned i = 0; i < 5; ++i ) total |= unsigned(( totals.bits[ i ] >> bit ) & 1 ) << i;
+        counts[ size_t( y ) * board.width() + w * CELLS_PER_WORD + bit ] = uint8_t( total - 1 );
+      }
+    }
+  }
+}
+
+VoxelLife::VoxelLife( unsigned width, unsigned height, unsigned depth, const VoxelRule& rule, unsigned threads ) :
+  voxelRule( rule ), current( width, height, depth ), next( width, height, depth ),
+  generations( 0 ), stopping( false ),
+  start( std::max( 1u, std::min( threads, depth ))), done( std::max( 1u, std::min( threads, depth )))
+{
+  // The calling thread runs slab 0.
+  for ( unsigned id = 1; id < std::min( threads, depth ); ++id )
+  {
+    workers.emplace_back( &VoxelLife::workerLoop, this, id );
+  }
+}
+
+VoxelLife::~VoxelLife()
+{
+  stopping = true;
+  if ( !workers.empty() ) start.wait();
+  for ( auto& worker : workers ) worker.join();
+}
+
+void VoxelLife::advance()
+{
+  if ( !workers.empty() ) start.wait();
+  runSlab( 0 );
+  if ( !workers.empty() ) done.wait();
+  std::swap( current, next );
+  ++generations;
+}
+
+void VoxelLife::workerLoop( unsigned id )
+{
+  for (;;)
+  {
+    start.wait();
+    if ( stopping ) return;
+    runSlab( id );
+    done.wait();
+  }
+}
+
+void VoxelLife::runSlab( unsigned id )
+{
+  const size_t depth = current.depth();
+  const unsigned first = unsigned( depth * id / threads() );
+  const unsigned last = unsigned( depth * ( id + 1 ) / threads() );
+  advanceVoxels( current, next, voxelRule, first, last );
+}
+
+void VoxelLife::memoryUsage( std::vector< MemoryUse >& report ) const
+{
+  report.push_back( MemoryUse{ "voxels", current.memoryUsed() + next.memoryUsed() } );
+}
+
+VoxelView::VoxelView( unsigned width, unsigned height ) :
+  visible( width, height ), levels( size_t( width ) * height )
+{
+}
+
+void VoxelView::slice( const VoxelBoard& board, unsigned z )
+{
+  board.storeLayer( z, visible );
+  countLayer( board, z, counts );
+  for ( size_t i = 0; i < levels.size(); ++i ) {
+    levels[ i ] = uint8_t( counts[ i ] * 255u / VoxelRule::MAX_NEIGHBORS );
+  }
+}
+
+void VoxelView::project( const VoxelBoard& board )
+{
+  visible.clear();
+  const unsigned width = board.width();
+  const unsigned depth = board.depth();
+  for ( unsigned z = 0; z < depth; ++z )
+  {
+    const uint8_t level = uint8_t( depth > 1 ? z * 255u / ( depth - 1 ) : 0 );
+    for ( unsigned y = 0; y < board.height(); ++y )
+    {
+      const uint64_t* layer = board.row( y, z );
+      uint64_t* seen = visible.row( y );
+      for ( unsigned w = 0; w < board.wordsPerRow(); ++w )
+      {
+        // Only the voxels nothing nearer hides.
+        for ( uint64_t bits = layer[ w ] & ~seen[ w ]; bits; bits &= bits - 1 ) {
+          levels[ size_t( y ) * width + w * CELLS_PER_WORD + __builtin_ctzll( bits ) ] = level;
+        }
+        seen[ w ] |= layer[ w ];
+      }
+    }
+  }
+}
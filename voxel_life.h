@@ -0,0 +1,170 @@
+///
+/// Game of life in three dimensions, bit-packed voxels.
+/// (C) Andrew Brownbill 2019
+///
+
+#ifndef VOXEL_LIFE_H
+#define VOXEL_LIFE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "barrier.h"
+#include "memory_budget.h"
+#include "packed_board.h"
+
+// An outer totalistic rule over the 26 cells around a voxel.  Bit n of
+// birth is set if a dead voxel with n live neighbors comes alive, bit n
+// of survive if a live one with n stays alive.
+class VoxelRule
+{
+  public:
+
+  static constexpr unsigned MAX_NEIGHBORS = 26;
+
+  VoxelRule( uint32_t birthMask, uint32_t surviveMask );
+
+  // Bays' notation, survival then birth as ranges, "4555" being survive
+  // on 4 to 5 neighbors, born on 5 to 5.  Numbers past 9 go comma
+  // separated, "5,7,6,6".  Throws std::invalid_argument on anything
+  // else.
+  static VoxelRule parse( const std::string& text );
+
+  // Bays' 4555, the first 3D rule found to have gliders.
+  static VoxelRule bays4555() { return parse( "4555" ); }
+
+  // Back to Bays' notation; masks that aren't ranges come out as
+  // "B5,6/S4,5".
+  std::string toString() const;
+
+  bool next( bool alive, unsigned neighbors ) const
+  {
+    return ((( alive ? survive : birth ) >> neighbors ) & 1 ) != 0;
+  }
+
+  uint32_t birth;
+  uint32_t survive;
+};
+
+// A bit-packed volume.  Each x row is a run of 64 bit words like
+// PackedBoard's, rows stacked y then z, so a z layer is a PackedBoard's
+// worth of rows in a row.  Wraps around in all three directions.  The
+// width must be a multiple of 64.
+class VoxelBoard
+{
+  public:
+
+  VoxelBoard( unsigned width, unsigned height, unsigned depth );
+
+  unsigned width() const { return xSize; }
+  unsigned height() const { return ySize; }
+  unsigned depth() const { return zSize; }
+  unsigned wordsPerRow() const { return words; }
+
+  uint64_t* row( unsigned y, unsigned z ) { return &cells[ ( size_t( z ) * ySize + y ) * words ]; }
+  const uint64_t* row( unsigned y, unsigned z ) const { return &cells[ ( size_t( z ) * ySize + y ) * words ]; }
+
+  bool get( unsigned x, unsigned y, unsigned z ) const;
+  void set( unsigned x, unsigned y, unsigned z, bool alive );
+  void clear();
+  size_t population() const;
+  size_t memoryUsed() const { return cells.capacity() * sizeof( uint64_t ); }
+
+  // Layer z as a board of its own.
+  void storeLayer( unsigned z, PackedBoard& layer ) const;
+
+  private:
+  unsigned xSize;
+  unsigned ySize;
+  unsigned zSize;
+  unsigned words;
+  std::vector< uint64_t > cells;
+};
+
+// Fill a cube of side voxels in the middle of the volume at random, each
+// alive with probability percent / 100.  The 3D rules mostly die out or
+// boil from a full random fill, a blob in empty space is the usual
+// start.
+void seedCube( VoxelBoard& board, unsigned side, unsigned percent, unsigned seed );
+
+// Layers [first, last) of src forward one generation into dst.  The 26
+// neighbor count is bit sliced in three passes: every row's cells summed
+// with their x neighbors, 0 to 3, then three of those rows within a
+// layer, 0 to 9, then three of those layers, 0 to 27 with the voxel
+// itself, which the rule is applied to.  The layer sums are kept in a
+// ring of three, so each is worked out once.
+void advanceVoxels( const VoxelBoard& src, VoxelBoard& dst, const VoxelRule& rule,
+                    unsigned first, unsigned last );
+
+// Every live voxel of layer z's count of live neighbors into counts, one
+// byte a voxel, x fastest.  For drawing.
+void countLayer( const VoxelBoard& board, unsigned z, std::vector< uint8_t >& counts );
+
+// A volume stepped by threads, each on a slab of layers.  The calling
+// thread does the first slab; the others wait on a barrier between
+// generations, like ParallelEngine's.
+class VoxelLife : public MemoryClient
+{
+  public:
+
+  VoxelLife( unsigned width, unsigned height, unsigned depth, const VoxelRule& rule, unsigned threads );
+  VoxelLife( const VoxelLife& ) = delete;
+  VoxelLife& operator=( const VoxelLife& ) = delete;
+  ~VoxelLife();
+
+  const VoxelBoard& board() const { return current; }
+  VoxelBoard& board() { return current; }
+  const VoxelRule& rule() const { return voxelRule; }
+  unsigned threads() const { return unsigned( workers.size() ) + 1; }
+  uint64_t generation() const { return generations; }
+
+  void advance();
+
+  void memoryUsage( std::vector< MemoryUse >& report ) const override;
+
+  private:
+
+  void workerLoop( unsigned id );
+  void runSlab( unsigned id );
+
+  VoxelRule voxelRule;
+  VoxelBoard current;
+  VoxelBoard next;
+  uint64_t generations;
+  bool stopping;
+  Barrier start;
+  Barrier done;
+  std::vector< std::thread > workers;
+};
+
+// The part of a volume the page shows: one z layer, or every layer
+// projected onto the x y plane.  levels() picks the palette entry of
+// each visible cell.
+class VoxelView
+{
+  public:
+
+  VoxelView( unsigned width, unsigned height );
+
+  // Layer z, colored by how many neighbors each voxel has.
+  void slice( const VoxelBoard& board, unsigned z );
+
+  // Down the z axis, each column showing its nearest voxel, colored by
+  // how deep it is.
+  void project( const VoxelBoard& board );
+
+  const PackedBoard& cells() const { return visible; }
+  uint8_t level( unsigned x, unsigned y ) const { return levels[ size_t( y ) * visible.width() + x ]; }
+
+  size_t memoryUsed() const { return visible.memoryUsed() + levels.capacity() + counts.capacity(); }
+
+  private:
+  PackedBoard visible;
+  std::vector< uint8_t > levels;
+  std::vector< uint8_t > counts;
+};
+
+#endif
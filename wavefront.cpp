@@ -0,0 +1,55 @@
+///
+/// Several generations of a packed board in one pass over memory.
+/// (C) Andrew Brownbill 2019
+///
+
+#include <stdexcept>
+
+#include "wavefront.h"
+
+Wavefront::Wavefront( unsigned width, unsigned height, unsigned depth ) :
+  xSize( width ), ySize( height ), words( width / CELLS_PER_WORD ), maxDepth( depth )
+{
+  if ( width == 0 || width % CELLS_PER_WORD != 0 || height == 0 ) {
+    throw std::invalid_argument( "Wavefront width must be a non zero multiple of 64" );
+  }
+  if ( depth == 0 ) {
+    throw std::invalid_argument( "Wavefront depth must be at least 1" );
+  }
+  rings.resize( size_t( depth - 1 ) * 3 * words );
+}
+
+void Wavefront::advance( const PackedBoard& src, PackedBoard& dst, unsigned generations )
+{
+  if ( src.width() != xSize || src.height() != ySize || dst.width() != xSize || dst.height() != ySize ) {
+    throw std::invalid_argument( "Wavefront::advance board size mismatch" );
+  }
+  if ( &src == &dst ) {
+    throw std::invalid_argument( "Wavefront::advance needs separate boards" );
+  }
+  if ( generations == 0 || generations > maxDepth ) {
+    throw std::invalid_argument( "Wavefront::advance generations must be 1 to depth" );
+  }
+
+  // Rows are numbered on the unrolled torus, v in [-k, height + k), so
+  // generation g is good for v in [g - k, height + k - g), and generation
+  // k is exactly the board.
+  const long k = generations;
+  const long height = ySize;
+  auto input = [&]( long v ) { return src.row( unsigned((( v % height ) + height ) % height )); };
+  auto rowOf = [&]( unsigned g, long v ) -> const uint64_t* {
+    return g == 0 ? input( v ) : ringRow( g, v );
+  };
+
+  // Input row t arrives, then each generation g takes the step it now has
+  // all three rows for: row t - g.
+  for ( long t = 2 - k; t < height + k; ++t ) {
+    for ( unsigned g = 1; g <= generations; ++g )
+    {
+      const long v = t - long( g );
+      if ( v < long( g ) - k || v >= height + k - long( g )) continue;
+      uint64_t* out = ( g == generations ) ? dst.row( unsigned( v )) : ringRow( g, v );
+      stepPackedRow( rowOf( g - 1, v - 1 ), rowOf( g - 1, v ), rowOf( g - 1, v + 1 ), out, words );
+    }
+  }
+}
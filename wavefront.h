@@ -0,0 +1,50 @@
+///
+/// Several generations of a packed board in one pass over memory.
+/// (C) Andrew Brownbill 2019
+///
+
+#ifndef WAVEFRONT_H
+#define WAVEFRONT_H
+
+#include <cstdint>
+#include <vector>
+
+#include "packed_board.h"
+
+// Temporal blocking for dense boards too big for the cache.  advancePacked
+// streams the whole board in and out once a generation; this sweeps down
+// the board once and carries every generation along with it, generation
+// g running g rows behind the input.  Each generation in flight keeps a
+// ring of three rows, so the working set is 3 * depth rows however tall
+// the board is, and the board is read and written once per depth
+// generations.  Wrapping around y takes depth extra rows at each end,
+// recomputed rather than stored: depth^2 row steps of overhead a pass.
+class Wavefront
+{
+  public:
+
+  Wavefront( unsigned width, unsigned height, unsigned depth );
+
+  unsigned depth() const { return maxDepth; }
+  size_t memoryUsed() const { return rings.capacity() * sizeof( uint64_t ); }
+
+  // Move src forward generations (1 to depth()) into dst, which must be a
+  // different board of the same size.
+  void advance( const PackedBoard& src, PackedBoard& dst, unsigned generations );
+
+  private:
+
+  // Row v of generation g, 1 <= g < depth, in its ring.
+  uint64_t* ringRow( unsigned g, long v )
+  {
+    return &rings[ (( g - 1 ) * 3 + size_t(( v % 3 + 3 ) % 3 )) * words ];
+  }
+
+  unsigned xSize;
+  unsigned ySize;
+  unsigned words;
+  unsigned maxDepth;
+  std::vector< uint64_t > rings;
+};
+
+#endif